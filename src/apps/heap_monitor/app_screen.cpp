@@ -0,0 +1,98 @@
+#include "app_screen.h"
+#include "../../ui.h"
+#include "../../services/heap_telemetry.h"
+#include "../../pools.h"
+
+namespace apps_heap_monitor {
+    using namespace heap_telemetry;
+
+    const int FIRST_TAG_ROW = 10;
+    const int LAST_TAG_ROW = 14;
+
+    // Rows are built in the frame arena so the screen does not perturb the frame counters it shows.
+    static ArenaString& appendKb(ArenaString& out, uint32_t bytes) {
+        return out.append((unsigned long)((bytes + 512) / 1024)).append('K');
+    }
+
+    static void drawRegion(const char* label, HeapRegion region, int row) {
+        RegionStats stats = getRegionStats(region);
+        ArenaString summary(arenas::frame(), 48);
+        summary.append(label).append(" free ");
+        appendKb(summary, stats.freeBytes).append(" min ");
+        appendKb(summary, stats.minFreeBytes).append(" blk ");
+        appendKb(summary, stats.largestFreeBlock);
+        ::bufferRow(summary.c_str(), row, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+
+        ArenaString live(arenas::frame(), 48);
+        live.append("  live ").append((unsigned long)stats.liveBlocks).append(" / ");
+        appendKb(live, stats.liveBytes).append(" peak ");
+        appendKb(live, stats.peakBytes);
+        ::bufferRow(live.c_str(), row + 1, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+    }
+
+    void drawAppScreen() {
+        ::updateHeader();
+
+
+        RowPosition contentStart = getRowPosition(2);
+        RowPosition footerStart = getRowPosition(15);
+        M5.Display.fillRect(contentStart.x, contentStart.y, contentStart.width, footerStart.y - contentStart.y, TFT_WHITE);
+
+
+        ::bufferRow("Heap monitor", 2, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+        drawRegion("RAM", REGION_INTERNAL, 3);
+        drawRegion("PSRAM", REGION_PSRAM, 5);
+
+        FrameStats frame = getFrameStats();
+        ArenaString frameText(arenas::frame(), 48);
+        frameText.append("Frame allocs ").append((unsigned long)frame.lastAllocs)
+                 .append(" max ").append((unsigned long)frame.maxAllocs)
+                 .append(" clean ").append((unsigned long)frame.allocationFreeFrames)
+                 .append('/').append((unsigned long)frame.frames);
+        ::bufferRow(frameText.c_str(), 7, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+
+        // Live bytes per pool, plus fallbacks and failures summed over all pools.
+        ArenaString poolText(arenas::frame(), 48);
+        poolText.append("Pools");
+        uint32_t fallbacks = 0;
+        uint32_t failures = 0;
+        for (int i = 0; i < pools::POOL_COUNT; ++i) {
+            pools::PoolStats pool = pools::getStats((pools::Pool)i);
+            poolText.append(' ').append(pools::poolName((pools::Pool)i)).append(' ');
+            appendKb(poolText, pool.liveBytes);
+            fallbacks += pool.fallbacks;
+            failures += pool.failures;
+        }
+        poolText.append(" fb ").append((unsigned long)fallbacks).append(" fail ").append((unsigned long)failures);
+        ::bufferRow(poolText.c_str(), 8, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+        ::bufferRow("Allocations by subsystem:", 9, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+
+        // Busiest tags first, by bytes allocated since boot.
+        TagStats stats[HEAP_TAG_COUNT];
+        int order[HEAP_TAG_COUNT];
+        for (int i = 0; i < HEAP_TAG_COUNT; ++i) {
+            stats[i] = getTagStats((HeapTag)i);
+            order[i] = i;
+        }
+        for (int i = 1; i < HEAP_TAG_COUNT; ++i) {
+            int current = order[i];
+            int j = i - 1;
+            while (j >= 0 && stats[order[j]].bytes < stats[current].bytes) {
+                order[j + 1] = order[j];
+                j--;
+            }
+            order[j + 1] = current;
+        }
+
+        int row = FIRST_TAG_ROW;
+        for (int i = 0; i < HEAP_TAG_COUNT && row <= LAST_TAG_ROW; ++i) {
+            const TagStats& tag = stats[order[i]];
+            if (tag.allocs == 0 && tag.failures == 0) continue;
+            ArenaString line(arenas::frame(), 40);
+            line.append("  ").append(tagName((HeapTag)order[i])).append(' ').append((unsigned long)tag.allocs).append("x ");
+            appendKb(line, (uint32_t)(tag.bytes > 0xFFFFFFFFULL ? 0xFFFFFFFFULL : tag.bytes));
+            if (tag.failures) line.append(" fail ").append((unsigned long)tag.failures);
+            ::bufferRow(line.c_str(), row++, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+        }
+    }
+}
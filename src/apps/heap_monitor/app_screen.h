@@ -0,0 +1,12 @@
+#ifndef HEAP_MONITOR_APP_SCREEN_H
+#define HEAP_MONITOR_APP_SCREEN_H
+
+#include <M5Unified.h>
+#include <String>
+
+namespace apps_heap_monitor {
+    // Read-only; any tap or the Rfrsh button redraws with fresh figures.
+    void drawAppScreen();
+}
+
+#endif // HEAP_MONITOR_APP_SCREEN_H
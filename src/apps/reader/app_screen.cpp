@@ -1,9 +1,14 @@
 #include "app_screen.h"
 #include "../../ui.h"
 #include "../../sdcard.h"
+#include "../../pools.h"
+#include "../../gateway/events.h"
+#include "../../services/reading_state.h"
+#include "../../services/power_telemetry.h"
+#include "../../services/profiler.h"
+#include "../../services/heap_telemetry.h"
 #include <SD.h>
 #include <algorithm>
-#include <ArduinoJson.h>
 
 namespace apps_reader {
     const int MAX_DISPLAYED_FILES = 50;
@@ -23,8 +28,13 @@ namespace apps_reader {
     static bool initialized = false;
     static bool fileIsOpen = false;
     static String currentFileName = "";
-    static String fileContent = "";
-    static String* pages = nullptr;
+    // Book text and wrapped page text are bulk data in PSRAM; the page tables
+    // are read on every turn and stay in internal SRAM.
+    static char* fileContent = nullptr;
+    static size_t fileLength = 0;
+    static char* pageCache = nullptr;
+    static TextSpan* pages = nullptr;
+    static uint32_t* pageOffsets = nullptr;
     static int totalPagesCount = 0;
     static int currentPageIndex = 0;
     static bool showingFileList = true;
@@ -35,9 +45,8 @@ namespace apps_reader {
     static int currentPage = 0;
     static const int itemsPerPage = 9;
     static int totalPages = 1;
-    
-
-    const String STATE_FILE_PATH = "/books/reader_state.json";
+    static bool booksListValid = false;
+    static bool listenerRegistered = false;
     
 
     struct ReaderRowPosition {
@@ -56,7 +65,7 @@ namespace apps_reader {
         return ReaderRowPosition{WORK_AREA_X, y, WORK_AREA_WIDTH, READER_ROW_HEIGHT};
     }
     
-    void drawReaderRow(const String& text, int row, uint16_t textColor = TFT_BLACK, uint16_t bgColor = TFT_WHITE) {
+    void drawReaderRow(const char* text, int row, uint16_t textColor = TFT_BLACK, uint16_t bgColor = TFT_WHITE) {
         ReaderRowPosition pos = getReaderRowPosition(row);
         M5.Display.fillRect(pos.x, pos.y, pos.width, pos.height, bgColor);
         
@@ -75,99 +84,96 @@ namespace apps_reader {
     
 
     void saveReadingState() {
-        if (!fileIsOpen || currentFileName.isEmpty()) {
+        if (!fileIsOpen || currentFileName.isEmpty() || pageOffsets == nullptr) {
             return;
         }
-        
-        JsonDocument doc;
-        
-
-        if (SD.exists(STATE_FILE_PATH)) {
-            File stateFile = SD.open(STATE_FILE_PATH);
-            if (stateFile) {
-                deserializeJson(doc, stateFile);
-                stateFile.close();
-            }
-        }
-        
+        ReadingStateStore::getInstance().setOffset(currentFileName, pageOffsets[currentPageIndex]);
+    }
+    
 
-        doc[currentFileName] = currentPageIndex;
-        
-        File stateFile = SD.open(STATE_FILE_PATH, FILE_WRITE);
-        if (stateFile) {
-            serializeJson(doc, stateFile);
-            stateFile.close();
-            Serial.println("[Reader] State saved: " + currentFileName + ", page " + String(currentPageIndex + 1));
-        } else {
-            Serial.println("[Reader] Failed to save state");
+    int pageForOffset(uint32_t offset) {
+        int page = 0;
+        for (int i = 1; i < totalPagesCount; i++) {
+            if (pageOffsets[i] > offset) break;
+            page = i;
         }
+        return page;
     }
     
 
     int loadReadingStateForFile(const String& filename) {
-        if (!SD.exists(STATE_FILE_PATH)) {
-            return 0;
-        }
-        
-        File stateFile = SD.open(STATE_FILE_PATH);
-        if (!stateFile) {
+        const BookState* state = ReadingStateStore::getInstance().find(filename);
+        if (state == nullptr) {
             return 0;
         }
-        
-        JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, stateFile);
-        stateFile.close();
-        
-        if (error) {
-            Serial.println("[Reader] Failed to parse state file");
-            return 0;
-        }
-        
-        if (doc.containsKey(filename)) {
-            int page = doc[filename].as<int>();
-            Serial.println("[Reader] State loaded for " + filename + ": page " + String(page + 1));
-            return page;
-        }
-        
-        return 0;
+        int page = state->legacyPage >= 0 ? state->legacyPage : pageForOffset(state->offset);
+        Serial.println("[Reader] State loaded for " + filename + ": page " + String(page + 1));
+        return page;
     }
     
 
+    static void releasePages() {
+        pools::release(pages);
+        pools::release(pageOffsets);
+        pools::release(pageCache);
+        pages = nullptr;
+        pageOffsets = nullptr;
+        pageCache = nullptr;
+    }
+
+    static void releaseFileContent() {
+        pools::release(fileContent);
+        fileContent = nullptr;
+        fileLength = 0;
+    }
+
     void splitTextIntoPages() {
-        if (pages != nullptr) {
-            delete[] pages;
-            pages = nullptr;
-        }
+        PROFILE_SCOPE("splitTextIntoPages");
+        HEAP_TAG(HEAP_READER);
+        releasePages();
         
         totalPagesCount = 0;
-        if (fileContent.length() == 0) return;
+        if (fileLength == 0) return;
         
 
         ::setUniversalFont();
         M5.Display.setTextSize(FONT_SIZE_ALL);
         
 
-        int estimatedPages = (fileContent.length() / (LINES_PER_PAGE * 50)) + 5;
+        int estimatedPages = (fileLength / (LINES_PER_PAGE * 50)) + 5;
         if (estimatedPages < 5) estimatedPages = 5;
         if (estimatedPages > 200) estimatedPages = 200;
         
-        pages = new String[estimatedPages];
+        // Wrapped lines can gain a trailing space and a separator each.
+        size_t cacheCapacity = fileLength + (size_t)estimatedPages * LINES_PER_PAGE * 2;
+        pages = pools::allocateArray<TextSpan>(pools::POOL_FAST, estimatedPages);
+        pageOffsets = pools::allocateArray<uint32_t>(pools::POOL_FAST, estimatedPages);
+        pageCache = (char*)pools::allocate(pools::POOL_BULK, cacheCapacity);
+        if (!pages || !pageOffsets || !pageCache) {
+            releasePages();
+            return;
+        }
+        size_t cacheUsed = 0;
         
 
         int maxLineWidth = EPD_WIDTH - 40;
         
         int pageIndex = 0;
         int textPos = 0;
+        // Set when a wrapped line no longer fits the cache; pagination stops at that line.
+        bool cacheFull = false;
         
-        while (textPos < fileContent.length() && pageIndex < estimatedPages) {
-            String page = "";
+        while (textPos < fileLength && pageIndex < estimatedPages && !cacheFull) {
+            size_t pageStart = cacheUsed;
             int linesOnPage = 0;
+            pageOffsets[pageIndex] = textPos;
             
-            while (linesOnPage < LINES_PER_PAGE && textPos < fileContent.length()) {
+            while (linesOnPage < LINES_PER_PAGE && textPos < fileLength) {
+                int lineStart = textPos;
     
                 String currentLine = "";
-                while (textPos < fileContent.length()) {
-                    char c = fileContent.charAt(textPos);
+                while (textPos < fileLength) {
+                    char c = fileContent[textPos];
                     textPos++;
                     
                     if (c == '\r') {
@@ -191,26 +197,50 @@ namespace apps_reader {
                 
 
                 for (int i = 0; i < wrappedCount && linesOnPage < LINES_PER_PAGE; i++) {
-                    if (page.length() > 0) page += "\n";
-                    page += wrappedLines[i];
+                    size_t needed = wrappedLines[i].length() + (cacheUsed > pageStart ? 1 : 0);
+                    if (cacheUsed + needed > cacheCapacity) {
+                        cacheFull = true;
+                        break;
+                    }
+                    if (cacheUsed > pageStart) pageCache[cacheUsed++] = '\n';
+                    memcpy(pageCache + cacheUsed, wrappedLines[i].c_str(), wrappedLines[i].length());
+                    cacheUsed += wrappedLines[i].length();
                     linesOnPage++;
                 }
                 
+                if (cacheFull) {
+                    textPos = lineStart;
+                    break;
+                }
                 
                 if (wrappedCount > 0 && linesOnPage >= LINES_PER_PAGE) {
                     break;
                 }
             }
             
-            pages[pageIndex] = page;
+            if (linesOnPage == 0 && cacheFull) break;
+            pages[pageIndex] = TextSpan(pageCache + pageStart, cacheUsed - pageStart);
             pageIndex++;
         }
         
         totalPagesCount = pageIndex;
+        if (cacheFull) {
+            Serial.printf("[Reader] Page cache full; paginated %d of %u bytes\n", textPos, (unsigned)fileLength);
+        }
     }
     
 
+    static void onFileChanged(const String& path) {
+        if (path == "/books" || path.startsWith("/books/")) {
+            booksListValid = false;
+        }
+    }
+
     void loadBooksList() {
+        if (booksListValid) {
+            return;
+        }
+        HEAP_TAG(HEAP_READER);
         bookFilesCount = 0;
         for (int i = 0; i < MAX_DISPLAYED_FILES; i++) {
             bookFiles[i] = "";
@@ -222,6 +252,7 @@ namespace apps_reader {
         if (!booksDir) {
             return;
         }
+        booksListValid = true;
         
         while (true) {
             File file = booksDir.openNextFile();
@@ -236,15 +267,7 @@ namespace apps_reader {
         booksDir.close();
         
 
-        for (int i = 0; i < bookFilesCount - 1; i++) {
-            for (int j = 0; j < bookFilesCount - i - 1; j++) {
-                if (bookFiles[j] > bookFiles[j + 1]) {
-                    String temp = bookFiles[j];
-                    bookFiles[j] = bookFiles[j + 1];
-                    bookFiles[j + 1] = temp;
-                }
-            }
-        }
+        std::sort(bookFiles, bookFiles + bookFilesCount);
         
 
         totalPages = (bookFilesCount + itemsPerPage - 1) / itemsPerPage;
@@ -286,7 +309,12 @@ namespace apps_reader {
     }
     
     void initApp() {
+        if (!listenerRegistered) {
+            gateway_events::addFileChangeListener(onFileChanged);
+            listenerRegistered = true;
+        }
         ensureBooksFolder();
+        ReadingStateStore::getInstance().begin();
         fileIsOpen = false;
         showingFileList = true;
         currentPageIndex = 0;
@@ -322,18 +350,20 @@ namespace apps_reader {
         
 
         if (totalPages > 1) {
-            String paginationButtons[] = {"<<<--", "<--", String(currentPage + 1), "-->", "-->>>"};  
+            ArenaString pageNumber(arenas::frame(), 8);
+            pageNumber.append(currentPage + 1);
+            const char* paginationButtons[] = {"<<<--", "<--", pageNumber.c_str(), "-->", "-->>>"};
             int numButtons = 5;
             int sectionWidth = EPD_WIDTH / numButtons;
             RowPosition pos = getRowPosition(14);
             
             for(int i = 0; i < numButtons; ++i){
-                String btn = paginationButtons[i];
+                const char* btn = paginationButtons[i];
                 int btnX = pos.x + i * sectionWidth + 10;
                 int btnY = pos.y + (pos.height - 20) / 2;
                 M5.Display.setCursor(btnX, btnY);
                 M5.Display.print(btn);
-                int textWidth = M5.Display.textWidth(btn.c_str());
+                int textWidth = M5.Display.textWidth(btn);
                 int centeredUnderlineY = pos.y + pos.height - 10;
                 M5.Display.drawLine(btnX, centeredUnderlineY, btnX + textWidth, centeredUnderlineY, TFT_BLACK);
             }
@@ -354,9 +384,11 @@ namespace apps_reader {
         M5.Display.fillRect(WORK_AREA_X, WORK_AREA_Y, WORK_AREA_WIDTH, workAreaHeight, TFT_WHITE);
         
 
-        String pageText = pages[currentPageIndex];
+        // Lines are drawn from frame-arena copies; the page text itself is not copied.
+        TextSpan pageText = pages[currentPageIndex];
+        const char* text = pageText.data();
         int lineNum = 0;
-        int pos = 0;
+        size_t pos = 0;
         const int maxLines = LINES_PER_PAGE;
         
 
@@ -371,26 +403,24 @@ namespace apps_reader {
                     break;
                 }
                 
-                int nextNewline = pageText.indexOf('\n', pos);
-                String line;
-                
-                if (nextNewline == -1) {
-                    line = pageText.substring(pos);
-                    pos = pageText.length();
-                } else {
-                    line = pageText.substring(pos, nextNewline);
-                    pos = nextNewline + 1;
-                }
+                const char* newline = (const char*)memchr(text + pos, '\n', pageText.length() - pos);
+                size_t lineEnd = newline ? newline - text : pageText.length();
+                const char* line = arenas::frame().copy(text + pos, lineEnd - pos);
+                pos = newline ? lineEnd + 1 : pageText.length();
                 
-                drawReaderRow(line, lineNum);
+                drawReaderRow(line ? line : "", lineNum);
                 lineNum++;
             }
         }
         
 
-        String pageInfo = String(currentPageIndex + 1) + "/" + String(totalPagesCount);
-        String navLine = "<< Prev  Menu " + pageInfo +"  Next >>";
-        bufferRow(navLine, 14, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
+        ArenaString navLine(arenas::frame(), 48);
+        navLine.append("<< Prev  Menu ").append(currentPageIndex + 1).append('/').append(totalPagesCount);
+        if (ReadingStateStore::getInstance().hasBookmark(currentFileName, pageOffsets[currentPageIndex])) {
+            navLine.append('*');
+        }
+        navLine.append("  Next >>");
+        bufferRow(navLine.c_str(), 14, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
     }
     
     void drawAppScreen() {
@@ -407,6 +437,8 @@ namespace apps_reader {
     }
     
     void openFile(const String& filename) {
+        POWER_SCOPE(POWER_SD);
+        HEAP_TAG(HEAP_READER);
         String filepath = "/books/" + filename;
         File file = SD.open(filepath);
         
@@ -421,14 +453,26 @@ namespace apps_reader {
             return;
         }
         
-        fileContent = "";
-        while (file.available()) {
-            fileContent += (char)file.read();
+        releaseFileContent();
+        size_t fileSize = file.size();
+        fileContent = (char*)pools::allocate(pools::POOL_BULK, fileSize + 1);
+        if (!fileContent) {
+            displayMessage("Out of memory");
+            file.close();
+            return;
         }
+        {
+            PROFILE_SCOPE("sd.readBook");
+            fileLength = file.read((uint8_t*)fileContent, fileSize);
+        }
+        fileContent[fileLength] = '\0';
+        PROFILE_COUNT("sd.readBytes", fileLength);
         file.close();
         
         currentFileName = filename;
         splitTextIntoPages();
+        // Pages hold their own wrapped copy; the raw text is not needed any more.
+        releaseFileContent();
         
         if (totalPagesCount > 0) {
     
@@ -441,33 +485,55 @@ namespace apps_reader {
             
             fileIsOpen = true;
             showingFileList = false;
+            ReadingStateStore::getInstance().markOpened(filename);
             saveReadingState();
         } else {
             displayMessage("Empty file");
         }
     }
     
+    bool resumeBook(const String& filename, uint32_t offset) {
+        if (!initialized) {
+            initApp();
+            initialized = true;
+        }
+        if (filename.isEmpty()) {
+            return true;
+        }
+        openFile(filename);
+        if (!fileIsOpen || currentFileName != filename) {
+            return false;
+        }
+        currentPageIndex = pageForOffset(offset);
+        return true;
+    }
+
     void nextPage() {
         if (fileIsOpen && currentPageIndex < totalPagesCount - 1) {
             currentPageIndex++;
-            saveReadingState();
+            ReadingStateStore::getInstance().recordPageTurn(currentFileName, pageOffsets[currentPageIndex]);
         }
     }
     
     void prevPage() {
         if (fileIsOpen && currentPageIndex > 0) {
             currentPageIndex--;
-            saveReadingState();
+            ReadingStateStore::getInstance().recordPageTurn(currentFileName, pageOffsets[currentPageIndex]);
         }
     }
     
+    bool toggleBookmark() {
+        if (!fileIsOpen || pageOffsets == nullptr) {
+            return false;
+        }
+        return ReadingStateStore::getInstance().toggleBookmark(currentFileName, pageOffsets[currentPageIndex]);
+    }
+    
     void returnToFileList() {
         showingFileList = true;
         fileIsOpen = false;
-        if (pages != nullptr) {
-            delete[] pages;
-            pages = nullptr;
-        }
+        releasePages();
+        ReadingStateStore::getInstance().flush();
         loadBooksList();
     }
     
@@ -556,6 +622,33 @@ namespace apps_reader {
     }
     
 
+    void handleGesture(const gestures::Gesture& gesture) {
+        if (showingFileList) {
+            if (gesture.type != gestures::GESTURE_SWIPE) return;
+            bool forward = gesture.direction == gestures::SWIPE_LEFT || gesture.direction == gestures::SWIPE_UP;
+            handlePagination(forward ? "-->" : "<--");
+            return;
+        }
+        if (!fileIsOpen) return;
+
+        int pageBefore = currentPageIndex;
+        if (gesture.type == gestures::GESTURE_SWIPE) {
+            if (gesture.direction == gestures::SWIPE_LEFT || gesture.direction == gestures::SWIPE_UP) {
+                nextPage();
+            } else {
+                prevPage();
+            }
+            if (currentPageIndex == pageBefore) return;
+        } else if (gesture.type == gestures::GESTURE_LONG_PRESS) {
+            bool marked = toggleBookmark();
+            Serial.println(String("[Reader] Bookmark ") + (marked ? "added" : "removed") + " on page " + String(currentPageIndex + 1));
+        } else {
+            return;
+        }
+        renderCurrentScreen();
+    }
+    
+
     bool isFileOpen() {
         return fileIsOpen;
     }
@@ -571,4 +664,8 @@ namespace apps_reader {
     int getTotalPages() {
         return totalPagesCount;
     }
+    
+    uint32_t getCurrentOffset() {
+        return (fileIsOpen && pageOffsets != nullptr) ? pageOffsets[currentPageIndex] : 0;
+    }
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <M5Unified.h>
 #include <String>
+#include "../../services/gestures.h"
 
 namespace apps_reader {
     
@@ -14,12 +15,17 @@ namespace apps_reader {
     
     void handleTouch(int touchRow, int touchX, int touchY);
     
+    // Swipe turns pages (or list pages), long press toggles a bookmark.
+    void handleGesture(const gestures::Gesture& gesture);
+    
     
     void nextPage();
     void prevPage();
+    bool toggleBookmark();
     
     
     void openFile(const String& filename);
+    bool resumeBook(const String& filename, uint32_t offset);
     
     
     void returnToFileList();
@@ -32,6 +38,7 @@ namespace apps_reader {
     String getCurrentFile();
     int getCurrentPage();
     int getTotalPages();
+    uint32_t getCurrentOffset();
 }
 
 #endif // READER_APP_SCREEN_H
\ No newline at end of file
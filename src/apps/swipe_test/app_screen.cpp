@@ -14,10 +14,6 @@ namespace apps_swipe_test {
     static bool showLines = false;
     
     
-    const int MIN_SWIPE_DISTANCE = 50;
-    const unsigned long MAX_SWIPE_TIME = 1000;
-    
-    
     struct TouchInfo {
         int startX, startY;
         int currentX, currentY;
@@ -31,6 +27,7 @@ namespace apps_swipe_test {
         unsigned long timestamp;
         int distance;
         int duration;
+        int velocity;
     };
     
     
@@ -49,33 +46,26 @@ namespace apps_swipe_test {
     }
     
     
-    String determineSwipeDirection(int startX, int startY, int endX, int endY) {
-        int dx = endX - startX;
-        int dy = endY - startY;
-        
-    
-        int distance = calculateDistance(startX, startY, endX, endY);
-        if (distance < MIN_SWIPE_DISTANCE) {
-            return "Tap";
-        }
-        
-    
-        if (abs(dx) > abs(dy)) {
-    
-            return (dx > 0) ? "Right" : "Left";
-        } else {
-    
-            return (dy > 0) ? "Down" : "Up";
+    String describeGesture(const gestures::Gesture& gesture) {
+        static const char* const DIRECTIONS[] = {"", "Left", "Right", "Up", "Down"};
+        switch (gesture.type) {
+            case gestures::GESTURE_SWIPE:
+                return DIRECTIONS[gesture.direction];
+            case gestures::GESTURE_PINCH:
+                return String("Pinch x") + String(gesture.scale, 2);
+            default:
+                return gestures::gestureName(gesture.type);
         }
     }
     
     
-    void addSwipeToHistory(const String& direction, int distance, int duration) {
+    void addSwipeToHistory(const String& direction, int distance, int duration, int velocity) {
         SwipeRecord record;
         record.direction = direction;
         record.timestamp = millis();
         record.distance = distance;
         record.duration = duration;
+        record.velocity = velocity;
         
         swipeHistory.push_back(record);
         
@@ -109,7 +99,7 @@ namespace apps_swipe_test {
             M5.Display.fillTriangle(centerX + arrowSize, centerY,
                                   centerX - arrowSize/2, centerY - arrowSize/2,
                                   centerX - arrowSize/2, centerY + arrowSize/2, color);
-        } else if (direction == "Tap") {
+        } else if (direction == "Tap" || direction == "Double tap" || direction == "Long press") {
     
             M5.Display.fillCircle(centerX, centerY, arrowSize/2, color);
         }
@@ -162,7 +152,7 @@ namespace apps_swipe_test {
             
             String historyText = String(i + 1) + ". " + record.direction + 
                                " (" + String(record.distance) + "px, " + 
-                               String(record.duration) + "ms)";
+                               String(record.duration) + "ms, " + String(record.velocity) + "px/s)";
             
             M5.Display.drawString(historyText, 10, historyY + 30 + i * 25);
         }
@@ -235,12 +225,8 @@ void handleTouch(int x, int y, bool isPressed) {
     } else {
 
         if (currentTouch.isActive) {
-            int duration = currentTime - currentTouch.startTime;
-            
-            if (duration <= MAX_SWIPE_TIME) {
-                handleSwipe(currentTouch.startX, currentTouch.startY, x, y);
-            }
-            
+            currentTouch.currentX = x;
+            currentTouch.currentY = y;
             currentTouch.isActive = false;
             needsRedraw = true;
         }
@@ -248,13 +234,12 @@ void handleTouch(int x, int y, bool isPressed) {
 }
     
     
-void handleSwipe(int startX, int startY, int endX, int endY) {
-    String direction = determineSwipeDirection(startX, startY, endX, endY);
-    int distance = calculateDistance(startX, startY, endX, endY);
-    int duration = millis() - currentTouch.startTime;
-    
-
-    addSwipeToHistory(direction, distance, duration);
+void handleGesture(const gestures::Gesture& gesture) {
+    if (!initialized) {
+        initApp();
+    }
+    int distance = calculateDistance(0, 0, gesture.dx, gesture.dy);
+    addSwipeToHistory(describeGesture(gesture), distance, gesture.durationMs, (int)gesture.velocity);
     needsRedraw = true;
 }
     
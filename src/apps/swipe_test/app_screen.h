@@ -3,6 +3,7 @@
 
 #include <M5Unified.h>
 #include <String>
+#include "../../services/gestures.h"
 
 namespace apps_swipe_test {
     
@@ -18,7 +19,7 @@ namespace apps_swipe_test {
     void handleTouch(int x, int y, bool isPressed);
     
     
-    void handleSwipe(int startX, int startY, int endX, int endY);
+    void handleGesture(const gestures::Gesture& gesture);
     
     
     void resetState();
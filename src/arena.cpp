@@ -0,0 +1,162 @@
+#include "arena.h"
+#include <string.h>
+
+static const size_t FRAME_ARENA_SIZE = 4096;
+static const size_t SCREEN_ARENA_SIZE = 8192;
+
+Arena::Arena(void* storage, size_t capacity)
+    : _storage((uint8_t*)storage), _capacity(capacity), _used(0), _peak(0), _overflows(0), _generation(0) {}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    uintptr_t base = (uintptr_t)_storage;
+    uintptr_t start = (base + _used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    size_t offset = start - base;
+    if (offset + size > _capacity) {
+        _overflows++;
+        return nullptr;
+    }
+    _used = offset + size;
+    if (_used > _peak) _peak = _used;
+    return _storage + offset;
+}
+
+bool Arena::extend(void* block, size_t oldSize, size_t newSize) {
+    size_t offset = (uint8_t*)block - _storage;
+    if (!owns(block) || offset + oldSize != _used || offset + newSize > _capacity) {
+        return false;
+    }
+    _used = offset + newSize;
+    if (_used > _peak) _peak = _used;
+    return true;
+}
+
+char* Arena::copy(const char* text, size_t length) {
+    char* out = (char*)allocate(length + 1, 1);
+    if (!out) return nullptr;
+    memcpy(out, text, length);
+    out[length] = '\0';
+    return out;
+}
+
+char* Arena::copy(const char* text) {
+    return copy(text, strlen(text));
+}
+
+bool Arena::owns(const void* ptr) const {
+    return (const uint8_t*)ptr >= _storage && (const uint8_t*)ptr < _storage + _capacity;
+}
+
+void Arena::reset() {
+    _used = 0;
+    _generation++;
+}
+
+
+ArenaString::ArenaString(Arena& arena, size_t reserveBytes)
+    : _arena(arena), _data(nullptr), _length(0), _capacity(0), _truncated(false) {
+    reserve(reserveBytes);
+}
+
+bool ArenaString::reserve(size_t capacity) {
+    if (capacity <= _capacity) return true;
+    if (_data && _arena.extend(_data, _capacity, capacity)) {
+        _capacity = capacity;
+        return true;
+    }
+    char* grown = (char*)_arena.allocate(capacity, 1);
+    if (!grown) return false;
+    if (_data) memcpy(grown, _data, _length + 1);
+    else grown[0] = '\0';
+    _data = grown;
+    _capacity = capacity;
+    return true;
+}
+
+ArenaString& ArenaString::append(const char* text, size_t length) {
+    if (_truncated) return *this;
+    size_t needed = _length + length + 1;
+    if (needed > _capacity && !reserve(needed > _capacity * 2 ? needed : _capacity * 2) && !reserve(needed)) {
+        // Keep whatever fits and stop growing.
+        _truncated = true;
+        if (!_data) return *this;
+        length = _capacity - _length - 1;
+    }
+    memcpy(_data + _length, text, length);
+    _length += length;
+    _data[_length] = '\0';
+    return *this;
+}
+
+ArenaString& ArenaString::append(const char* text) {
+    return append(text, strlen(text));
+}
+
+ArenaString& ArenaString::append(const String& text) {
+    return append(text.c_str(), text.length());
+}
+
+ArenaString& ArenaString::append(char c) {
+    return append(&c, 1);
+}
+
+ArenaString& ArenaString::append(unsigned long value) {
+    char digits[20];
+    char* start = digits + sizeof(digits);
+    do {
+        *--start = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    return append(start, digits + sizeof(digits) - start);
+}
+
+ArenaString& ArenaString::append(long value) {
+    if (value < 0) {
+        append('-');
+        return append((unsigned long)(-(value + 1)) + 1);
+    }
+    return append((unsigned long)value);
+}
+
+ArenaString& ArenaString::append(int value) {
+    return append((long)value);
+}
+
+ArenaString& ArenaString::append(unsigned int value) {
+    return append((unsigned long)value);
+}
+
+// Fixed-point formatting; printf's float path can allocate inside newlib.
+ArenaString& ArenaString::append(float value, int decimals) {
+    if (value < 0) {
+        append('-');
+        value = -value;
+    }
+    unsigned long scale = 1;
+    for (int i = 0; i < decimals; ++i) scale *= 10;
+    unsigned long scaled = (unsigned long)(value * scale + 0.5f);
+    append(scaled / scale);
+    if (decimals > 0) {
+        append('.');
+        unsigned long fraction = scaled % scale;
+        for (unsigned long digit = scale / 10; digit > 0; digit /= 10) {
+            append((char)('0' + (fraction / digit) % 10));
+        }
+    }
+    return *this;
+}
+
+
+namespace arenas {
+    static uint8_t frameStorage[FRAME_ARENA_SIZE];
+    static uint8_t screenStorage[SCREEN_ARENA_SIZE];
+    static Arena frameArena(frameStorage, sizeof(frameStorage));
+    static Arena screenArena(screenStorage, sizeof(screenStorage));
+
+    Arena& frame() {
+        return frameArena;
+    }
+
+    Arena& screen() {
+        return screenArena;
+    }
+}
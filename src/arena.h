@@ -0,0 +1,76 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump allocator over caller-owned storage. Blocks are never freed one by
+// one; reset() drops everything at once. On overflow allocate() returns
+// nullptr and the overflow is counted, it never falls back to the heap.
+class Arena {
+public:
+    Arena(void* storage, size_t capacity);
+
+    void* allocate(size_t size, size_t alignment = sizeof(void*));
+    // Grows the most recent block in place; false if it is not the top block or does not fit.
+    bool extend(void* block, size_t oldSize, size_t newSize);
+    char* copy(const char* text, size_t length);
+    char* copy(const char* text);
+    bool owns(const void* ptr) const;
+    void reset();
+
+    size_t used() const { return _used; }
+    size_t capacity() const { return _capacity; }
+    size_t peak() const { return _peak; }
+    uint32_t overflows() const { return _overflows; }
+    // Bumped by reset(); lets holders of arena pointers detect that they went stale.
+    uint32_t generation() const { return _generation; }
+
+private:
+    uint8_t* _storage;
+    size_t _capacity;
+    size_t _used;
+    size_t _peak;
+    uint32_t _overflows;
+    uint32_t _generation;
+};
+
+// Append-only string built in an arena. Growth extends in place while the
+// string is the arena's top block and copies otherwise; on overflow the text
+// is truncated rather than spilling to the heap.
+class ArenaString {
+public:
+    explicit ArenaString(Arena& arena, size_t reserve = 32);
+
+    ArenaString& append(const char* text);
+    ArenaString& append(const char* text, size_t length);
+    ArenaString& append(const String& text);
+    ArenaString& append(char c);
+    ArenaString& append(int value);
+    ArenaString& append(unsigned int value);
+    ArenaString& append(long value);
+    ArenaString& append(unsigned long value);
+    ArenaString& append(float value, int decimals);
+
+    const char* c_str() const { return _data ? _data : ""; }
+    size_t length() const { return _length; }
+
+private:
+    bool reserve(size_t capacity);
+
+    Arena& _arena;
+    char* _data;
+    size_t _length;
+    size_t _capacity;
+    bool _truncated;
+};
+
+namespace arenas {
+    // Reset at the end of every renderCurrentScreen() and after rows drawn outside one; rowsBuffer text lives here.
+    Arena& frame();
+    // Reset when renderCurrentScreen() draws a different screen than last time.
+    Arena& screen();
+}
+
+#endif // ARENA_H
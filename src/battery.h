@@ -2,6 +2,8 @@
 #define BATTERY_H
 
 int getBatteryPercentage();
+int percentageFromVoltage(float voltage);
 float getBatteryVoltage();
+float getBatteryRemainingHours();
 
 #endif
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "freeze.h"
 #include "../ui.h"
+#include "../settings.h"
+#include "../services/reading_state.h"
+#include "../services/resume_state.h"
 #include "../screens/txt_viewer_screen.h"
 #include "../screens/img_viewer_screen.h"
 #include <esp_sleep.h>
@@ -22,6 +25,10 @@ void freezeAction() {
 
     M5.Display.display();
 
+    bool frozenView = currentScreen == TXT_VIEWER_SCREEN || currentScreen == IMG_VIEWER_SCREEN;
+    resume_state::capture(frozenView ? resume_state::PANEL_FROZEN : resume_state::PANEL_OTHER);
+    Settings::getInstance().flush();
+    ReadingStateStore::getInstance().flush();
     M5.Power.powerOff();
     esp_deep_sleep_start();
 }
\ No newline at end of file
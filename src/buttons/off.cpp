@@ -1,10 +1,12 @@
 #include "off.h"
 #include "../ui.h"
 #include "../screens/off_screen.h"
+#include "../services/resume_state.h"
 extern Message currentMessage;
 
 void showOffScreen() {
     displayMessage("Off pressed");
+    resume_state::capture(resume_state::PANEL_OTHER);
 
     footer.setVisible(false);
     currentMessage.text = "";
@@ -1,6 +1,7 @@
 #include "rfrsh.h"
 #include "../ui.h"
 #include "../network/wifi_manager.h"
+#include "../screens/files_screen.h"
 
 extern Message currentMessage;
 
@@ -9,6 +10,9 @@ void refreshUI() {
 
     if (currentScreen == WIFI_SCREEN) {
         WiFiManager::getInstance().startScan();
+    } else if (currentScreen == FILES_SCREEN) {
+        screens::invalidateFilesCache();
+        currentMessage.text = "";
     } else if (currentScreen != TXT_VIEWER_SCREEN && currentScreen != IMG_VIEWER_SCREEN) {
         currentMessage.text = "";
     }
@@ -4,6 +4,7 @@
 
 #define DEBUG_TOUCH
 #define DEBUG_WIFI_TOUCH
+#define DEBUG_POWER
 
 #define DEBUG_ALL
 
@@ -12,6 +13,7 @@
     #define DEBUG_KEYBOARD
     #define DEBUG_FILES
     #define DEBUG_SD_GATEWAY
+    #define DEBUG_POOLS
 #endif
 
 #endif
\ No newline at end of file
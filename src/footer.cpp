@@ -1,5 +1,7 @@
 #include "footer.h"
 #include "ui.h"
+#include "services/power_telemetry.h"
+#include "hit_index.h"
 #include <algorithm>
 Footer::Footer() : buttonCount(0), visible(true) {}
 
@@ -27,6 +29,7 @@ void Footer::draw(bool visible) {
     int currentX = pos.x + padding;
     int textY = pos.y + 10;
     int underlineY = pos.y + 40;
+    int sliceWidth = pos.width / buttonCount;
 
 
     ::setUniversalFont();
@@ -40,8 +43,9 @@ void Footer::draw(bool visible) {
         M5.Display.print(button.label);
         
 
-        int textWidth = M5.Display.textWidth(button.label.c_str());
+        int textWidth = M5.Display.textWidth(button.label);
         M5.Display.drawLine(currentX, underlineY, currentX + textWidth, underlineY, TFT_BLACK);
+        hit_index::add(pos.x + i * sliceWidth, pos.y, sliceWidth, pos.height, hit_index::HIT_FOOTER_BUTTON, i);
         
         currentX += buttonWidth + buttonSpacing;
     }
@@ -60,6 +64,7 @@ bool Footer::isVisible() const {
 
 void Footer::invokeButtonAction(int index) {
     if (index >= 0 && index < buttonCount && buttons[index].action) {
+        power_telemetry::noteAction(buttons[index].label);
         buttons[index].action();
     }
 }
\ No newline at end of file
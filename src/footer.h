@@ -3,14 +3,14 @@
 
 #include <M5Unified.h>
 #include <String>
-#include <functional>
 
 struct RowPosition;
 
 const int MAX_FOOTER_BUTTONS = 4;
+// Labels are string literals and actions plain functions, so button tables can be constexpr.
 struct FooterButton {
-    String label;
-    std::function<void()> action;
+    const char* label;
+    void (*action)();
 };
 
 
@@ -1,5 +1,7 @@
 #include "game.h"
 #include "../../ui.h"
+#include "../../hit_index.h"
+#include "../../services/heap_telemetry.h"
 #include <random>
 #include <algorithm>
 #include <vector>
@@ -119,6 +121,7 @@ namespace games_minesweeper {
         int restartX = (SCREEN_WIDTH - textWidth) / 2;
         M5.Display.drawString("RESTART", restartX, 35);
         M5.Display.drawLine(restartX, 65, restartX + textWidth, 65, BLACK);
+        hit_index::add(restartX, 20, textWidth + 1, 51, hit_index::HIT_RESTART);
         
         for (int i = 0; i < GRID_HEIGHT; i++) {
             for (int j = 0; j < GRID_WIDTH; j++) {
@@ -126,6 +129,7 @@ namespace games_minesweeper {
                 int y = GRID_START_Y + i * CELL_SIZE;
                 
                 M5.Display.drawRect(x, y, CELL_SIZE, CELL_SIZE, BLACK);
+                hit_index::add(x, y, CELL_SIZE, CELL_SIZE, hit_index::HIT_CELL, i * GRID_WIDTH + j);
                 
                 if (cellStates[i][j] == REVEALED || (gameLost && mines[i][j])) {
                     if (mines[i][j]) {
@@ -164,21 +168,18 @@ namespace games_minesweeper {
     }
     
     void handleTouch(int touchType, int x, int y) {
-        M5.Display.setTextSize(3);
-        int textWidth = M5.Display.textWidth("RESTART");
-        int restartX = (SCREEN_WIDTH - textWidth) / 2;
-        if (x >= restartX && x <= restartX + textWidth && y >= 20 && y <= 70) {
+        HEAP_TAG(HEAP_GAMES);
+        const hit_index::HitTarget* hit = hit_index::lookup(x, y);
+        if (!hit) return;
+
+        if (hit->action == hit_index::HIT_RESTART) {
             resetGame();
             return;
         }
         
-        if (x >= GRID_START_X && x < GRID_START_X + GRID_WIDTH * CELL_SIZE &&
-            y >= GRID_START_Y && y < GRID_START_Y + GRID_HEIGHT * CELL_SIZE) {
-            
-            int col = (x - GRID_START_X) / CELL_SIZE;
-            int row = (y - GRID_START_Y) / CELL_SIZE;
-            
-            if (row < 0 || row >= GRID_HEIGHT || col < 0 || col >= GRID_WIDTH) return;
+        if (hit->action == hit_index::HIT_CELL) {
+            int row = hit->param / GRID_WIDTH;
+            int col = hit->param % GRID_WIDTH;
             
             if (!gameStarted) {
                 generateMines(row, col);
@@ -190,6 +191,7 @@ namespace games_minesweeper {
     }
     
     void initGame() {
+        HEAP_TAG(HEAP_GAMES);
         gameWon = false;
         gameLost = false;
         gameStarted = false;
@@ -203,4 +205,37 @@ namespace games_minesweeper {
     void resetGame() {
         initGame();
     }
-}
\ No newline at end of file
+
+    size_t saveState(uint8_t* out, size_t capacity) {
+        const size_t length = 1 + GRID_WIDTH * GRID_HEIGHT;
+        if (capacity < length) return 0;
+        out[0] = (gameWon ? 1 : 0) | (gameLost ? 2 : 0) | (gameStarted ? 4 : 0);
+        size_t pos = 1;
+        for (int i = 0; i < GRID_HEIGHT; i++) {
+            for (int j = 0; j < GRID_WIDTH; j++) {
+                out[pos++] = (mines[i][j] ? 1 : 0) | (cellStates[i][j] == REVEALED ? 2 : 0) |
+                             ((neighborCounts[i][j] < 0 ? 0 : neighborCounts[i][j]) << 4);
+            }
+        }
+        return length;
+    }
+
+    bool restoreState(const uint8_t* data, size_t length) {
+        if (length != 1 + (size_t)(GRID_WIDTH * GRID_HEIGHT)) return false;
+        initGame();
+        gameWon = data[0] & 1;
+        gameLost = data[0] & 2;
+        gameStarted = data[0] & 4;
+        size_t pos = 1;
+        for (int i = 0; i < GRID_HEIGHT; i++) {
+            for (int j = 0; j < GRID_WIDTH; j++) {
+                uint8_t cell = data[pos++];
+                mines[i][j] = cell & 1;
+                cellStates[i][j] = (cell & 2) ? REVEALED : HIDDEN;
+                neighborCounts[i][j] = mines[i][j] ? -1 : (cell >> 4);
+                if (cellStates[i][j] == REVEALED) revealedCount++;
+            }
+        }
+        return true;
+    }
+}
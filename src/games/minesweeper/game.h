@@ -8,6 +8,8 @@ namespace games_minesweeper {
     void handleTouch(int touchType, int x, int y);
     void initGame();
     void resetGame();
+    size_t saveState(uint8_t* out, size_t capacity);
+    bool restoreState(const uint8_t* data, size_t length);
 }
 
 #endif
\ No newline at end of file
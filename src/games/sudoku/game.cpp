@@ -1,6 +1,8 @@
 #include "game.h"
 #include "../../ui.h"
 #include "../../keyboards/numbers_keyboard.h"
+#include "../../hit_index.h"
+#include "../../services/heap_telemetry.h"
 #include <random>
 #include <algorithm>
 #include <vector>
@@ -354,6 +356,7 @@ namespace games_sudoku {
                          M5.Display.fillRect(x + 1, y + 1, CELL_SIZE - 2, CELL_SIZE - 2, cellColor);
                         
                         M5.Display.drawRect(x, y, CELL_SIZE, CELL_SIZE, BLACK);
+                        hit_index::add(x, y, CELL_SIZE, CELL_SIZE, hit_index::HIT_CELL, gridRow * GRID_SIZE + gridCol);
                         
                         if (board[gridRow][gridCol] != 0) {
                             M5.Display.setTextSize(4);
@@ -402,24 +405,22 @@ namespace games_sudoku {
             }
             M5.Display.setTextSize(3);
         }
+
+        hit_index::add(restartX, 15, restartWidth + 1, 51, hit_index::HIT_RESTART);
+        hit_index::add(hintX, hintY, hintWidth + 1, 61, hit_index::HIT_HINT);
     }
     
     void handleTouch(int touchType, int x, int y) {
-        M5.Display.setTextSize(3);
-        int textWidth = M5.Display.textWidth("RESTART");
-        int restartX = (SCREEN_WIDTH - textWidth) / 2;
-        if (x >= restartX && x <= restartX + textWidth && y >= 15 && y <= 65) {
+        HEAP_TAG(HEAP_GAMES);
+        const hit_index::HitTarget* hit = hit_index::lookup(x, y);
+        uint16_t action = hit ? hit->action : (uint16_t)hit_index::HIT_NONE;
+
+        if (action == hit_index::HIT_RESTART) {
             resetGame();
             return;
         }
         
-
-        
-        int hintWidth = M5.Display.textWidth("HINT");
-        int hintX = (SCREEN_WIDTH - hintWidth) / 2;
-        int hintY = SCREEN_HEIGHT - 90;
-        
-        if (x >= hintX && x <= hintX + hintWidth && y >= hintY && y <= hintY + 60) {
+        if (action == hit_index::HIT_HINT) {
             showingHint = !showingHint;
             return;
         }
@@ -428,7 +429,7 @@ namespace games_sudoku {
             return;
         }
         
-        if (keyboardVisible) {
+        if (keyboardVisible && action == hit_index::HIT_NUMBER_KEY) {
             String key = keyboards::getNumberKeyFromTouch(x, y);
             if (key != "") {
                 handleKeyboardInput(key);
@@ -436,30 +437,15 @@ namespace games_sudoku {
             }
         }
         
-        for (int blockRow = 0; blockRow < 2; blockRow++) {
-            for (int blockCol = 0; blockCol < 2; blockCol++) {
-                int blockStartX = GRID_START_X + blockCol * (BLOCK_SIZE * CELL_SIZE + BLOCK_SPACING);
-                int blockStartY = GRID_START_Y + blockRow * (BLOCK_SIZE * CELL_SIZE + BLOCK_SPACING);
-                
-                if (x >= blockStartX && x < blockStartX + BLOCK_SIZE * CELL_SIZE &&
-                    y >= blockStartY && y < blockStartY + BLOCK_SIZE * CELL_SIZE) {
-                    
-                    int localCol = (x - blockStartX) / CELL_SIZE;
-                    int localRow = (y - blockStartY) / CELL_SIZE;
-                    
-                    int gridRow = blockRow * BLOCK_SIZE + localRow;
-                    int gridCol = blockCol * BLOCK_SIZE + localCol;
-                    
-                    if (gridRow < 0 || gridRow >= GRID_SIZE || gridCol < 0 || gridCol >= GRID_SIZE) return;
-                    
-                    if (!readonly[gridRow][gridCol]) {
-                        selectedRow = gridRow;
-                        selectedCol = gridCol;
-                        keyboardVisible = true;
-                    }
-                    return;
-                }
+        if (action == hit_index::HIT_CELL) {
+            int gridRow = hit->param / GRID_SIZE;
+            int gridCol = hit->param % GRID_SIZE;
+            if (!readonly[gridRow][gridCol]) {
+                selectedRow = gridRow;
+                selectedCol = gridCol;
+                keyboardVisible = true;
             }
+            return;
         }
         
         keyboardVisible = false;
@@ -490,6 +476,7 @@ namespace games_sudoku {
     }
     
     void initGame() {
+        HEAP_TAG(HEAP_GAMES);
         gameWon = false;
         gameStarted = false;
         selectedRow = -1;
@@ -505,4 +492,39 @@ namespace games_sudoku {
         initGame();
         generatePuzzle();
     }
-}
\ No newline at end of file
+
+    size_t saveState(uint8_t* out, size_t capacity) {
+        const size_t length = 1 + GRID_SIZE * GRID_SIZE;
+        if (capacity < length) return 0;
+        out[0] = (gameWon ? 1 : 0) | (gameStarted ? 2 : 0);
+        size_t pos = 1;
+        for (int row = 0; row < GRID_SIZE; row++) {
+            for (int col = 0; col < GRID_SIZE; col++) {
+                out[pos++] = board[row][col] | (solution[row][col] << 3) | (readonly[row][col] ? 0x40 : 0);
+            }
+        }
+        return length;
+    }
+
+    bool restoreState(const uint8_t* data, size_t length) {
+        if (length != 1 + (size_t)(GRID_SIZE * GRID_SIZE)) return false;
+        gameWon = data[0] & 1;
+        gameStarted = data[0] & 2;
+        selectedRow = -1;
+        selectedCol = -1;
+        keyboardVisible = false;
+        showingErrors = false;
+        showingErrorMessage = false;
+        showingHint = false;
+        size_t pos = 1;
+        for (int row = 0; row < GRID_SIZE; row++) {
+            for (int col = 0; col < GRID_SIZE; col++) {
+                uint8_t cell = data[pos++];
+                board[row][col] = cell & 0x07;
+                solution[row][col] = (cell >> 3) & 0x07;
+                readonly[row][col] = cell & 0x40;
+            }
+        }
+        return true;
+    }
+}
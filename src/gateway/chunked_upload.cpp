@@ -0,0 +1,393 @@
+#include <Arduino.h>
+#include <SD.h>
+#include <WebServer.h>
+#include <ArduinoJson.h>
+#include <mbedtls/md.h>
+#include <vector>
+#include "chunked_upload.h"
+#include "gateway_util.h"
+#include "events.h"
+#include "sync_manifest.h"
+#include "../services/profiler.h"
+#include "../debug_config.h"
+
+namespace gateway_upload {
+    static WebServer* server = nullptr;
+
+    const int MAX_UPLOAD_SESSIONS = 2;
+    const int MAX_RANGES = 64;
+    const unsigned long SESSION_TTL_MS = 30UL * 60UL * 1000UL;
+    const uint32_t PREFERRED_CHUNK_SIZE = 64 * 1024;
+
+    struct ByteRange {
+        uint32_t start;
+        uint32_t end;
+    };
+
+    struct UploadSession {
+        uint32_t id;
+        String path;
+        String partPath;
+        uint32_t size;
+        std::vector<ByteRange> ranges;
+        uint32_t hashedUpTo;
+        mbedtls_md_context_t sha;
+        bool shaReady;
+        unsigned long lastUsed;
+    };
+
+    static UploadSession sessions[MAX_UPLOAD_SESSIONS];
+    static uint32_t nextSessionId = 0x5e55;
+
+    struct ChunkWrite {
+        UploadSession* session;
+        File file;
+        uint32_t offset;
+        uint32_t written;
+        String error;
+    };
+
+    static ChunkWrite chunk;
+
+    static void releaseSession(UploadSession& session, bool removePart) {
+        if (session.shaReady) {
+            mbedtls_md_free(&session.sha);
+            session.shaReady = false;
+        }
+        if (removePart && session.partPath.length() > 0 && SD.exists(session.partPath)) {
+            SD.remove(session.partPath);
+        }
+        session.id = 0;
+        session.path = "";
+        session.partPath = "";
+        session.ranges.clear();
+    }
+
+    void closeSessions() {
+        if (chunk.file) chunk.file.close();
+        chunk.session = nullptr;
+        for (int i = 0; i < MAX_UPLOAD_SESSIONS; ++i) {
+            releaseSession(sessions[i], false);
+        }
+    }
+
+    static UploadSession* findSession(const String& token) {
+        uint32_t id = (uint32_t)strtoul(token.c_str(), nullptr, 16);
+        unsigned long now = millis();
+        for (int i = 0; i < MAX_UPLOAD_SESSIONS; ++i) {
+            if (sessions[i].id != 0 && &sessions[i] != chunk.session && now - sessions[i].lastUsed > SESSION_TTL_MS) {
+                releaseSession(sessions[i], true);
+            }
+        }
+        for (int i = 0; i < MAX_UPLOAD_SESSIONS; ++i) {
+            if (id != 0 && sessions[i].id == id) return &sessions[i];
+        }
+        return nullptr;
+    }
+
+    static void addRange(UploadSession& session, uint32_t start, uint32_t end) {
+        if (end <= start) return;
+        std::vector<ByteRange>& ranges = session.ranges;
+        size_t i = 0;
+        while (i < ranges.size() && ranges[i].end < start) i++;
+        size_t j = i;
+        while (j < ranges.size() && ranges[j].start <= end) {
+            start = min(start, ranges[j].start);
+            end = max(end, ranges[j].end);
+            j++;
+        }
+        ranges.erase(ranges.begin() + i, ranges.begin() + j);
+        ranges.insert(ranges.begin() + i, ByteRange{start, end});
+    }
+
+    static uint32_t contiguousEnd(const UploadSession& session) {
+        if (session.ranges.empty() || session.ranges[0].start > 0) return 0;
+        return session.ranges[0].end;
+    }
+
+    static void catchUpHash(UploadSession& session) {
+        uint32_t target = contiguousEnd(session);
+        if (session.hashedUpTo >= target) return;
+
+        File file = SD.open(session.partPath, FILE_READ);
+        if (!file || !file.seek(session.hashedUpTo)) {
+            if (file) file.close();
+            return;
+        }
+        uint8_t* buffer = gateway_util::ioBuffer(gateway_util::IO_UPLOAD_HASH);
+        while (session.hashedUpTo < target) {
+            size_t want = min((size_t)(target - session.hashedUpTo), gateway_util::IO_BUFFER_SIZE);
+            int n = file.read(buffer, want);
+            if (n <= 0) break;
+            mbedtls_md_update(&session.sha, buffer, n);
+            session.hashedUpTo += n;
+        }
+        file.close();
+    }
+
+    static bool isSha256Hex(const String& text) {
+        if (text.length() != 64) return false;
+        for (unsigned int i = 0; i < text.length(); ++i) {
+            if (!isxdigit((unsigned char)text[i])) return false;
+        }
+        return true;
+    }
+
+    static String sessionToken(const UploadSession& session) {
+        char token[9];
+        snprintf(token, sizeof(token), "%08x", (unsigned)session.id);
+        return String(token);
+    }
+
+    static void sendStatus(const UploadSession& session) {
+        JsonDocument doc;
+        doc["v"] = gateway_util::API_VERSION;
+        doc["id"] = sessionToken(session);
+        doc["path"] = session.path;
+        doc["size"] = session.size;
+        doc["hashed"] = session.hashedUpTo;
+        doc["chunkSize"] = PREFERRED_CHUNK_SIZE;
+        JsonArray ranges = doc["received"].to<JsonArray>();
+        for (size_t i = 0; i < session.ranges.size(); ++i) {
+            JsonArray range = ranges.add<JsonArray>();
+            range.add(session.ranges[i].start);
+            range.add(session.ranges[i].end);
+        }
+        String json;
+        serializeJson(doc, json);
+        gateway_util::sendJson(server, 200, json);
+    }
+
+    void handleCreateSession() {
+        PROFILE_SCOPE("gateway.handleCreateSession");
+        JsonDocument request;
+        if (deserializeJson(request, server->arg("plain"))) {
+            gateway_util::sendError(server, 400, "Bad JSON");
+            return;
+        }
+        String path;
+        if (!gateway_util::normalizePath(request["path"] | "", path) || path == "/") {
+            gateway_util::sendError(server, 400, "Invalid path");
+            return;
+        }
+        uint32_t size = request["size"] | 0;
+
+        UploadSession* session = nullptr;
+        for (int i = 0; i < MAX_UPLOAD_SESSIONS; ++i) {
+            if (sessions[i].id != 0 && sessions[i].path == path) {
+                session = &sessions[i];
+                break;
+            }
+        }
+        if (session && session->size == size) {
+            session->lastUsed = millis();
+            sendStatus(*session);
+            return;
+        }
+        if (session) releaseSession(*session, true);
+
+        for (int i = 0; i < MAX_UPLOAD_SESSIONS && !session; ++i) {
+            if (sessions[i].id == 0) session = &sessions[i];
+        }
+        if (!session) {
+            for (int i = 0; i < MAX_UPLOAD_SESSIONS; ++i) {
+                if (&sessions[i] == chunk.session) continue;
+                if (!session || sessions[i].lastUsed < session->lastUsed) session = &sessions[i];
+            }
+            releaseSession(*session, true);
+        }
+
+        gateway_util::ensureParentDirs(path);
+        String partPath = path + ".part";
+        File part = SD.open(partPath, FILE_WRITE);
+        if (!part) {
+            gateway_util::sendError(server, 500, "Cannot create " + partPath);
+            return;
+        }
+        part.close();
+
+        session->id = nextSessionId++;
+        if (session->id == 0) session->id = nextSessionId++;
+        session->path = path;
+        session->partPath = partPath;
+        session->size = size;
+        session->hashedUpTo = 0;
+        session->lastUsed = millis();
+        mbedtls_md_init(&session->sha);
+        mbedtls_md_setup(&session->sha, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0);
+        mbedtls_md_starts(&session->sha);
+        session->shaReady = true;
+
+        #ifdef DEBUG_SD_GATEWAY
+        Serial.printf("[SD Gateway] upload session %08x for %s (%u bytes)\n", (unsigned)session->id, path.c_str(), (unsigned)size);
+        #endif
+        sendStatus(*session);
+    }
+
+    static void endChunk() {
+        if (chunk.file) chunk.file.close();
+        if (chunk.session) {
+            addRange(*chunk.session, chunk.offset, chunk.offset + chunk.written);
+            catchUpHash(*chunk.session);
+            gateway_events::notifyUploadProgress(chunk.session->path, contiguousEnd(*chunk.session), chunk.session->size);
+        }
+    }
+
+    void handleChunkRaw() {
+        PROFILE_SCOPE("gateway.handleChunkRaw");
+        HTTPRaw& raw = server->raw();
+        if (raw.status == RAW_START) {
+            chunk.session = findSession(server->arg("id"));
+            chunk.written = 0;
+            chunk.error = "";
+            if (!chunk.session) {
+                chunk.error = "Unknown session";
+                return;
+            }
+            if (chunk.session->ranges.size() >= (size_t)MAX_RANGES) {
+                chunk.error = "Too many gaps";
+                chunk.session = nullptr;
+                return;
+            }
+            chunk.offset = (uint32_t)strtoul(server->arg("offset").c_str(), nullptr, 10);
+            if (chunk.session->size > 0 && chunk.offset > chunk.session->size) {
+                chunk.error = "Offset past end";
+                chunk.session = nullptr;
+                return;
+            }
+            chunk.file = SD.open(chunk.session->partPath, "r+");
+            if (!chunk.file || !chunk.file.seek(chunk.offset)) {
+                chunk.error = "Seek failed";
+                if (chunk.file) chunk.file.close();
+                chunk.session = nullptr;
+            }
+        } else if (raw.status == RAW_WRITE) {
+            if (!chunk.session) return;
+            uint32_t position = chunk.offset + chunk.written;
+            size_t n = raw.currentSize;
+            if (chunk.session->size > 0 && position + n > chunk.session->size) {
+                n = chunk.session->size - position;
+            }
+            if (chunk.file.write(raw.buf, n) != n) {
+                chunk.error = "Write failed";
+                endChunk();
+                chunk.session = nullptr;
+                return;
+            }
+            if (position <= chunk.session->hashedUpTo && position + n > chunk.session->hashedUpTo) {
+                uint32_t skip = chunk.session->hashedUpTo - position;
+                mbedtls_md_update(&chunk.session->sha, raw.buf + skip, n - skip);
+                chunk.session->hashedUpTo = position + n;
+            }
+            chunk.written += n;
+        } else if (raw.status == RAW_END || raw.status == RAW_ABORTED) {
+            if (!chunk.session) return;
+            endChunk();
+            if (raw.status == RAW_ABORTED) chunk.session = nullptr;
+        }
+    }
+
+    void handleChunkDone() {
+        PROFILE_SCOPE("gateway.handleChunkDone");
+        if (!chunk.session) {
+            gateway_util::sendError(server, chunk.error == "Unknown session" ? 404 : 400, chunk.error);
+            return;
+        }
+        UploadSession& session = *chunk.session;
+        chunk.session = nullptr;
+        session.lastUsed = millis();
+        sendStatus(session);
+    }
+
+    void handleStatus() {
+        PROFILE_SCOPE("gateway.handleStatus");
+        UploadSession* session = findSession(server->arg("id"));
+        if (!session) {
+            gateway_util::sendError(server, 404, "Unknown session");
+            return;
+        }
+        session->lastUsed = millis();
+        sendStatus(*session);
+    }
+
+    void handleFinalize() {
+        PROFILE_SCOPE("gateway.handleFinalize");
+        UploadSession* session = findSession(server->arg("id"));
+        if (!session) {
+            gateway_util::sendError(server, 404, "Unknown session");
+            return;
+        }
+        String expected = server->arg("sha256");
+        expected.toLowerCase();
+        if (expected.length() == 0) {
+            gateway_util::sendError(server, 400, "Missing sha256");
+            return;
+        }
+        if (!isSha256Hex(expected)) {
+            gateway_util::sendError(server, 400, "sha256 must be 64 hex digits");
+            return;
+        }
+        catchUpHash(*session);
+        uint32_t complete = contiguousEnd(*session);
+        // An empty file arrives with no chunks at all; anything else must be a
+        // single range from offset 0, ending at the declared size when there is one.
+        bool emptyFile = session->ranges.empty() && session->size == 0;
+        if (!emptyFile && (session->ranges.size() != 1 || session->ranges[0].start != 0 ||
+                           (session->size > 0 && complete != session->size))) {
+            gateway_util::sendError(server, 409, "Missing ranges");
+            return;
+        }
+        if (session->hashedUpTo != complete) {
+            gateway_util::sendError(server, 500, "Hash incomplete");
+            return;
+        }
+
+        uint8_t digest[32];
+        mbedtls_md_context_t copy;
+        mbedtls_md_init(&copy);
+        mbedtls_md_setup(&copy, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0);
+        mbedtls_md_clone(&copy, &session->sha);
+        mbedtls_md_finish(&copy, digest);
+        mbedtls_md_free(&copy);
+        String actual = gateway_util::hexEncode(digest, sizeof(digest));
+
+        if (expected != actual) {
+            #ifdef DEBUG_SD_GATEWAY
+            Serial.printf("[SD Gateway] upload %s hash mismatch: %s\n", session->path.c_str(), actual.c_str());
+            #endif
+            releaseSession(*session, true);
+            gateway_util::sendError(server, 422, "SHA-256 mismatch: " + actual);
+            return;
+        }
+
+        if (SD.exists(session->path)) SD.remove(session->path);
+        if (!SD.rename(session->partPath, session->path)) {
+            gateway_util::sendError(server, 500, "Rename failed");
+            return;
+        }
+        String path = session->path;
+        releaseSession(*session, false);
+        gateway_sync::recordHash(path, complete, actual);
+        gateway_events::notifyFileChanged(path, "created");
+
+        String json = "{\"v\":" + String(gateway_util::API_VERSION) + ",\"path\":\"" + path +
+                      "\",\"size\":" + String((unsigned long)complete) + ",\"sha256\":\"" + actual + "\"}";
+        gateway_util::sendJson(server, 200, json);
+    }
+
+    void handleAbort() {
+        PROFILE_SCOPE("gateway.handleAbort");
+        UploadSession* session = findSession(server->arg("id"));
+        if (session) releaseSession(*session, true);
+        gateway_util::sendJson(server, 200, "{\"v\":" + String(gateway_util::API_VERSION) + "}");
+    }
+
+    void registerRoutes(WebServer* webServer) {
+        server = webServer;
+        server->on("/api/upload/session", HTTP_POST, handleCreateSession);
+        server->on("/api/upload/session", HTTP_DELETE, handleAbort);
+        server->on("/api/upload/chunk", HTTP_PUT, handleChunkDone, handleChunkRaw);
+        server->on("/api/upload/status", HTTP_GET, handleStatus);
+        server->on("/api/upload/finalize", HTTP_POST, handleFinalize);
+    }
+}
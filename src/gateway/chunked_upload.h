@@ -0,0 +1,11 @@
+#ifndef GATEWAY_CHUNKED_UPLOAD_H
+#define GATEWAY_CHUNKED_UPLOAD_H
+
+class WebServer;
+
+namespace gateway_upload {
+    void registerRoutes(WebServer* server);
+    void closeSessions();
+}
+
+#endif // GATEWAY_CHUNKED_UPLOAD_H
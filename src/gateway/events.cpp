@@ -0,0 +1,127 @@
+#include <Arduino.h>
+#include <WebSocketsServer.h>
+#include <vector>
+#include "events.h"
+#include "../battery.h"
+#include "../ui.h"
+#include "../services/idle_scheduler.h"
+#include "../debug_config.h"
+
+namespace gateway_events {
+    const unsigned long METRICS_INTERVAL_MS = 5000;
+    const unsigned long PROGRESS_INTERVAL_MS = 500;
+
+    static WebSocketsServer* socket = nullptr;
+    static uint16_t socketPort = 0;
+    static unsigned long lastMetricsTime = 0;
+    static unsigned long lastProgressTime = 0;
+    static std::vector<FileChangeListener> fileChangeListeners;
+
+    static String escapeJson(const String& value) {
+        String out;
+        out.reserve(value.length() + 2);
+        for (unsigned int i = 0; i < value.length(); ++i) {
+            char c = value[i];
+            if (c == '"' || c == '\\') out += '\\';
+            if ((uint8_t)c < 0x20) continue;
+            out += c;
+        }
+        return out;
+    }
+
+    static void broadcast(const char* type, const String& fields) {
+        if (!socket || socket->connectedClients() == 0) return;
+        String message = "{\"type\":\"";
+        message += type;
+        message += "\",\"t\":";
+        message += String(millis());
+        if (fields.length() > 0) {
+            message += ",";
+            message += fields;
+        }
+        message += "}";
+        socket->broadcastTXT(message);
+    }
+
+    static void onSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t length) {
+        if (type == WStype_CONNECTED) {
+            #ifdef DEBUG_SD_GATEWAY
+            Serial.printf("[SD Gateway] ws client %u connected\n", num);
+            #endif
+            publishMetrics();
+        } else if (type == WStype_TEXT) {
+            if (length == 7 && memcmp(payload, "metrics", 7) == 0) {
+                publishMetrics();
+            }
+        }
+    }
+
+    void begin(uint16_t port) {
+        if (socket) return;
+        socketPort = port;
+        socket = new WebSocketsServer(port);
+        socket->onEvent(onSocketEvent);
+        socket->begin();
+        lastMetricsTime = millis();
+    }
+
+    void stop() {
+        if (socket) {
+            socket->close();
+            delete socket;
+            socket = nullptr;
+        }
+    }
+
+    bool isRunning() { return socket != nullptr; }
+    uint16_t getPort() { return socketPort; }
+
+    int clientCount() {
+        return socket ? socket->connectedClients() : 0;
+    }
+
+    void loop() {
+        if (!socket) return;
+        socket->loop();
+        if (millis() - lastMetricsTime >= METRICS_INTERVAL_MS) {
+            lastMetricsTime = millis();
+            publishMetrics();
+        }
+    }
+
+    void addFileChangeListener(FileChangeListener listener) {
+        fileChangeListeners.push_back(listener);
+    }
+
+    void notifyFileChanged(const String& path, const char* change) {
+        #ifdef DEBUG_SD_GATEWAY
+        Serial.printf("[SD Gateway] fs %s %s\n", change, path.c_str());
+        #endif
+        for (size_t i = 0; i < fileChangeListeners.size(); ++i) {
+            fileChangeListeners[i](path);
+        }
+        broadcast("fs", "\"change\":\"" + String(change) + "\",\"path\":\"" + escapeJson(path) + "\"");
+    }
+
+    void notifyUploadProgress(const String& path, size_t received, size_t total) {
+        bool finished = total > 0 && received >= total;
+        if (!finished && millis() - lastProgressTime < PROGRESS_INTERVAL_MS) return;
+        lastProgressTime = millis();
+        broadcast("upload", "\"path\":\"" + escapeJson(path) + "\",\"received\":" + String((unsigned long)received) +
+                  ",\"total\":" + String((unsigned long)total));
+    }
+
+    void publishMetrics() {
+        if (!socket || socket->connectedClients() == 0) return;
+        String fields = "\"battery\":" + String(getBatteryPercentage());
+        fields += ",\"voltage\":" + String(getBatteryVoltage(), 2);
+        fields += ",\"heapFree\":" + String(ESP.getFreeHeap());
+        fields += ",\"heapMin\":" + String(ESP.getMinFreeHeap());
+        fields += ",\"psramFree\":" + String(ESP.getFreePsram());
+        fields += ",\"renders\":" + String(renderStats.renderCount);
+        fields += ",\"renderMs\":" + String(renderStats.lastRenderMs);
+        fields += ",\"displayMs\":" + String(renderStats.lastDisplayMs);
+        fields += ",\"sleepPct\":" + String(idle_scheduler::sleepFraction() * 100.0f, 1);
+        broadcast("metrics", fields);
+    }
+}
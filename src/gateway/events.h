@@ -0,0 +1,24 @@
+#ifndef GATEWAY_EVENTS_H
+#define GATEWAY_EVENTS_H
+
+#include <Arduino.h>
+#include <functional>
+
+namespace gateway_events {
+    typedef std::function<void(const String& path)> FileChangeListener;
+
+    void begin(uint16_t port);
+    void stop();
+    void loop();
+    bool isRunning();
+    uint16_t getPort();
+    int clientCount();
+
+    void addFileChangeListener(FileChangeListener listener);
+
+    void notifyFileChanged(const String& path, const char* change);
+    void notifyUploadProgress(const String& path, size_t received, size_t total);
+    void publishMetrics();
+}
+
+#endif // GATEWAY_EVENTS_H
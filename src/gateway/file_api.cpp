@@ -0,0 +1,276 @@
+#include <Arduino.h>
+#include <SD.h>
+#include <WebServer.h>
+#include <ArduinoJson.h>
+#include <vector>
+#include "file_api.h"
+#include "gateway_util.h"
+#include "events.h"
+#include "../pools.h"
+#include "../services/profiler.h"
+#include "../debug_config.h"
+
+namespace gateway_file_api {
+    static WebServer* server = nullptr;
+
+    const int DEFAULT_LIST_LIMIT = 50;
+    const int MAX_LIST_LIMIT = 200;
+    const int MAX_WALK_CURSORS = 2;
+    const unsigned long CURSOR_TTL_MS = 5UL * 60UL * 1000UL;
+
+    struct WalkCursor {
+        uint32_t id;
+        bool recursive;
+        File dir;
+        String dirPath;
+        std::vector<String> pendingDirs;
+        unsigned long lastUsed;
+    };
+
+    static WalkCursor cursors[MAX_WALK_CURSORS];
+    static uint32_t nextCursorId = 1;
+
+    static void releaseCursor(WalkCursor& cursor) {
+        if (cursor.dir) cursor.dir.close();
+        cursor.id = 0;
+        cursor.dirPath = "";
+        cursor.pendingDirs.clear();
+    }
+
+    void closeCursors() {
+        for (int i = 0; i < MAX_WALK_CURSORS; ++i) {
+            releaseCursor(cursors[i]);
+        }
+    }
+
+    static WalkCursor* findCursor(uint32_t id) {
+        unsigned long now = millis();
+        for (int i = 0; i < MAX_WALK_CURSORS; ++i) {
+            if (cursors[i].id != 0 && now - cursors[i].lastUsed > CURSOR_TTL_MS) {
+                releaseCursor(cursors[i]);
+            }
+        }
+        for (int i = 0; i < MAX_WALK_CURSORS; ++i) {
+            if (cursors[i].id == id && id != 0) return &cursors[i];
+        }
+        return nullptr;
+    }
+
+    static WalkCursor* allocCursor() {
+        WalkCursor* slot = &cursors[0];
+        for (int i = 0; i < MAX_WALK_CURSORS; ++i) {
+            if (cursors[i].id == 0) {
+                slot = &cursors[i];
+                break;
+            }
+            if (cursors[i].lastUsed < slot->lastUsed) slot = &cursors[i];
+        }
+        releaseCursor(*slot);
+        slot->id = nextCursorId++;
+        if (nextCursorId == 0) nextCursorId = 1;
+        slot->lastUsed = millis();
+        return slot;
+    }
+
+    static bool advanceDir(WalkCursor& cursor) {
+        if (cursor.dir) cursor.dir.close();
+        while (!cursor.pendingDirs.empty()) {
+            cursor.dirPath = cursor.pendingDirs.back();
+            cursor.pendingDirs.pop_back();
+            cursor.dir = SD.open(cursor.dirPath);
+            if (cursor.dir && cursor.dir.isDirectory()) return true;
+            if (cursor.dir) cursor.dir.close();
+        }
+        return false;
+    }
+
+    void handleLs() {
+        PROFILE_SCOPE("gateway.handleLs");
+        int limit = server->hasArg("limit") ? server->arg("limit").toInt() : DEFAULT_LIST_LIMIT;
+        if (limit <= 0) limit = DEFAULT_LIST_LIMIT;
+        if (limit > MAX_LIST_LIMIT) limit = MAX_LIST_LIMIT;
+
+        WalkCursor* cursor = nullptr;
+        String rootPath;
+        if (server->hasArg("cursor") && server->arg("cursor").length() > 0) {
+            cursor = findCursor((uint32_t)strtoul(server->arg("cursor").c_str(), nullptr, 16));
+            if (!cursor) {
+                gateway_util::sendError(server, 410, "Cursor expired");
+                return;
+            }
+        } else {
+            if (!gateway_util::normalizePath(server->hasArg("path") ? server->arg("path") : "/", rootPath)) {
+                gateway_util::sendError(server, 400, "Invalid path");
+                return;
+            }
+            File root = SD.open(rootPath);
+            if (!root) {
+                gateway_util::sendError(server, 404, "Not found: " + rootPath);
+                return;
+            }
+            if (!root.isDirectory()) {
+                root.close();
+                gateway_util::sendError(server, 400, "Not a directory: " + rootPath);
+                return;
+            }
+            cursor = allocCursor();
+            cursor->recursive = server->hasArg("recursive") && server->arg("recursive") != "0";
+            cursor->dir = root;
+            cursor->dirPath = rootPath;
+        }
+        cursor->lastUsed = millis();
+
+        #ifdef DEBUG_SD_GATEWAY
+        Serial.printf("[SD Gateway] ls %s (cursor %08x, limit %d)\n", cursor->dirPath.c_str(), (unsigned)cursor->id, limit);
+        #endif
+
+        // Listing pages can hold hundreds of entries; keep them out of internal SRAM.
+        JsonDocument doc(pools::jsonAllocator());
+        doc["v"] = gateway_util::API_VERSION;
+        if (rootPath.length() > 0) doc["path"] = rootPath;
+        JsonArray entries = doc["entries"].to<JsonArray>();
+
+        int count = 0;
+        bool exhausted = false;
+        while (count < limit) {
+            File entry = cursor->dir.openNextFile();
+            if (!entry) {
+                if (!cursor->recursive || !advanceDir(*cursor)) {
+                    exhausted = true;
+                    break;
+                }
+                continue;
+            }
+
+            String name = entry.name();
+            String path = gateway_util::joinPath(cursor->dirPath, name);
+            bool isDir = entry.isDirectory();
+
+            JsonObject item = entries.add<JsonObject>();
+            item["path"] = path;
+            item["name"] = name;
+            item["type"] = isDir ? "dir" : "file";
+            item["size"] = isDir ? 0 : (uint32_t)entry.size();
+            item["mtime"] = (uint32_t)entry.getLastWrite();
+            entry.close();
+
+            if (isDir && cursor->recursive) {
+                cursor->pendingDirs.push_back(path);
+            }
+            count++;
+        }
+
+        if (exhausted) {
+            doc["next"] = nullptr;
+            releaseCursor(*cursor);
+        } else {
+            char token[9];
+            snprintf(token, sizeof(token), "%08x", (unsigned)cursor->id);
+            doc["next"] = token;
+        }
+
+        String json;
+        serializeJson(doc, json);
+        gateway_util::sendJson(server, 200, json);
+    }
+
+    // FAT names are case-insensitive, so "/A" and "/a" are the same entry.
+    static bool isSameOrInside(const String& path, const String& root) {
+        String a = path;
+        String b = root;
+        a.toLowerCase();
+        b.toLowerCase();
+        return a == b || a.startsWith(b + "/");
+    }
+
+    // `path` and `to` come back normalized so listeners see the same form as their listings.
+    static String runOp(JsonObject op, String& path, String& to) {
+        String type = op["op"] | "";
+        if (type == "delete") {
+            if (!gateway_util::normalizePath(op["path"] | "", path) || path == "/") return "Invalid path";
+            File entry = SD.open(path);
+            if (!entry) return "Not found";
+            bool isDir = entry.isDirectory();
+            entry.close();
+            if (!isDir) return SD.remove(path) ? "" : "Remove failed";
+            if (op["recursive"] | false) return gateway_util::removeRecursive(path) ? "" : "Remove failed";
+            return SD.rmdir(path) ? "" : "Directory not empty";
+        }
+        if (type == "mkdir") {
+            if (!gateway_util::normalizePath(op["path"] | "", path) || path == "/") return "Invalid path";
+            if (SD.exists(path)) return "";
+            if (!gateway_util::ensureParentDirs(path)) return "Parent create failed";
+            return SD.mkdir(path) ? "" : "Mkdir failed";
+        }
+        if (type == "move" || type == "rename") {
+            if (!gateway_util::normalizePath(op[type == "move" ? "from" : "path"] | "", path) || path == "/") return "Invalid path";
+            if (type == "move") {
+                if (!gateway_util::normalizePath(op["to"] | "", to) || to == "/") return "Invalid target";
+            } else {
+                String name = op["name"] | "";
+                if (name.length() == 0 || name.indexOf('/') >= 0 || name == "." || name == "..") return "Invalid name";
+                to = gateway_util::joinPath(gateway_util::parentPath(path), name);
+            }
+            // Checked before any overwrite: removing such a target would take the source with it.
+            if (isSameOrInside(to, path)) return "Target is the source or inside it";
+            if (isSameOrInside(path, to)) return "Target contains the source";
+            if (!SD.exists(path)) return "Not found";
+            if (SD.exists(to)) {
+                if (!(op["overwrite"] | false)) return "Target exists";
+                if (!gateway_util::removeRecursive(to)) return "Overwrite failed";
+            }
+            if (!gateway_util::ensureParentDirs(to)) return "Parent create failed";
+            return SD.rename(path, to) ? "" : "Rename failed";
+        }
+        return "Unknown op";
+    }
+
+    void handleOps() {
+        PROFILE_SCOPE("gateway.handleOps");
+        JsonDocument request;
+        DeserializationError error = deserializeJson(request, server->arg("plain"));
+        if (error) {
+            gateway_util::sendError(server, 400, String("Bad JSON: ") + error.c_str());
+            return;
+        }
+        JsonArray ops = request["ops"].as<JsonArray>();
+        if (ops.isNull()) {
+            gateway_util::sendError(server, 400, "Missing ops array");
+            return;
+        }
+
+        JsonDocument doc(pools::jsonAllocator());
+        doc["v"] = gateway_util::API_VERSION;
+        JsonArray results = doc["results"].to<JsonArray>();
+        int failed = 0;
+        for (JsonVariant op : ops) {
+            String path;
+            String to;
+            String err = runOp(op.as<JsonObject>(), path, to);
+            if (err.length() == 0) {
+                gateway_events::notifyFileChanged(path, op["op"] | "changed");
+                if (to.length() > 0) gateway_events::notifyFileChanged(to, "created");
+            }
+            JsonObject result = results.add<JsonObject>();
+            result["ok"] = err.length() == 0;
+            if (err.length() > 0) {
+                result["error"] = err;
+                failed++;
+            }
+            #ifdef DEBUG_SD_GATEWAY
+            Serial.printf("[SD Gateway] op %s: %s\n", (op["op"] | "?"), err.length() ? err.c_str() : "ok");
+            #endif
+        }
+        doc["failed"] = failed;
+
+        String json;
+        serializeJson(doc, json);
+        gateway_util::sendJson(server, 200, json);
+    }
+
+    void registerRoutes(WebServer* webServer) {
+        server = webServer;
+        server->on("/api/ls", HTTP_GET, handleLs);
+        server->on("/api/ops", HTTP_POST, handleOps);
+    }
+}
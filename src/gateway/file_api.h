@@ -0,0 +1,11 @@
+#ifndef GATEWAY_FILE_API_H
+#define GATEWAY_FILE_API_H
+
+class WebServer;
+
+namespace gateway_file_api {
+    void registerRoutes(WebServer* server);
+    void closeCursors();
+}
+
+#endif // GATEWAY_FILE_API_H
@@ -0,0 +1,116 @@
+#include "gateway_util.h"
+#include <WebServer.h>
+#include "../pools.h"
+
+namespace gateway_util {
+
+    bool normalizePath(const String& raw, String& out) {
+        out = "/";
+        unsigned int i = 0;
+        while (i < raw.length()) {
+            while (i < raw.length() && (raw[i] == '/' || raw[i] == '\\')) i++;
+            unsigned int start = i;
+            while (i < raw.length() && raw[i] != '/' && raw[i] != '\\') i++;
+            if (i == start) break;
+
+            String segment = raw.substring(start, i);
+            if (segment == ".") continue;
+            if (segment == "..") return false;
+
+            if (!out.endsWith("/")) out += "/";
+            out += segment;
+        }
+        return true;
+    }
+
+    String joinPath(const String& dir, const String& name) {
+        if (dir.endsWith("/")) return dir + name;
+        return dir + "/" + name;
+    }
+
+    String parentPath(const String& path) {
+        int lastSlash = path.lastIndexOf('/');
+        if (lastSlash <= 0) return "/";
+        return path.substring(0, lastSlash);
+    }
+
+    bool ensureParentDirs(const String& path) {
+        int slash = path.indexOf('/', 1);
+        while (slash > 0) {
+            String dir = path.substring(0, slash);
+            if (!SD.exists(dir) && !SD.mkdir(dir)) {
+                return false;
+            }
+            slash = path.indexOf('/', slash + 1);
+        }
+        return true;
+    }
+
+    bool removeRecursive(const String& path) {
+        File entry = SD.open(path);
+        if (!entry) return false;
+
+        if (!entry.isDirectory()) {
+            entry.close();
+            return SD.remove(path);
+        }
+
+        while (true) {
+            File child = entry.openNextFile();
+            if (!child) break;
+            String childPath = joinPath(path, child.name());
+            child.close();
+            if (!removeRecursive(childPath)) {
+                entry.close();
+                return false;
+            }
+        }
+        entry.close();
+        return SD.rmdir(path);
+    }
+
+    String hexEncode(const uint8_t* data, size_t length) {
+        static const char digits[] = "0123456789abcdef";
+        String out;
+        out.reserve(length * 2);
+        for (size_t i = 0; i < length; ++i) {
+            out += digits[data[i] >> 4];
+            out += digits[data[i] & 0x0F];
+        }
+        return out;
+    }
+
+    static uint8_t* ioBlock = nullptr;
+
+    bool acquireIoBuffers() {
+        if (!ioBlock) {
+            // Cache-line aligned so SD reads into PSRAM do not straddle lines.
+            ioBlock = (uint8_t*)pools::allocate(pools::POOL_BULK, IO_BUFFER_SIZE * IO_BUFFER_COUNT, 32);
+        }
+        return ioBlock != nullptr;
+    }
+
+    void releaseIoBuffers() {
+        pools::release(ioBlock);
+        ioBlock = nullptr;
+    }
+
+    uint8_t* ioBuffer(IoBuffer which) {
+        return ioBlock + (size_t)which * IO_BUFFER_SIZE;
+    }
+
+    void sendJson(WebServer* server, int code, const String& json) {
+        server->send(code, "application/json", json);
+    }
+
+    void sendError(WebServer* server, int code, const String& message) {
+        String json = "{\"v\":" + String(API_VERSION) + ",\"error\":\"";
+        for (unsigned int i = 0; i < message.length(); ++i) {
+            char c = message[i];
+            if (c == '"' || c == '\\') json += '\\';
+            json += c;
+        }
+        json += "\"}";
+        sendJson(server, code, json);
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef GATEWAY_UTIL_H
+#define GATEWAY_UTIL_H
+
+#include <Arduino.h>
+#include <SD.h>
+
+class WebServer;
+
+namespace gateway_util {
+    const int API_VERSION = 1;
+    const size_t IO_BUFFER_SIZE = 4096;
+
+    // Scratch buffers for SD and HTTP streaming, one per user so they never alias.
+    enum IoBuffer : uint8_t {
+        IO_ZIP,
+        IO_UPLOAD_HASH,
+        IO_SYNC_HASH,
+        IO_BUFFER_COUNT
+    };
+
+    bool normalizePath(const String& raw, String& out);
+    String joinPath(const String& dir, const String& name);
+    String parentPath(const String& path);
+    bool ensureParentDirs(const String& path);
+    bool removeRecursive(const String& path);
+    String hexEncode(const uint8_t* data, size_t length);
+
+    // The buffers live in PSRAM while the gateway runs; ioBuffer() is only
+    // valid between acquireIoBuffers() and releaseIoBuffers().
+    bool acquireIoBuffers();
+    void releaseIoBuffers();
+    uint8_t* ioBuffer(IoBuffer which);
+
+    void sendJson(WebServer* server, int code, const String& json);
+    void sendError(WebServer* server, int code, const String& message);
+}
+
+#endif // GATEWAY_UTIL_H
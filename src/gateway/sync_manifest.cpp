@@ -0,0 +1,269 @@
+#include <Arduino.h>
+#include <SD.h>
+#include <WebServer.h>
+#include <ArduinoJson.h>
+#include <mbedtls/md.h>
+#include <map>
+#include <vector>
+#include "sync_manifest.h"
+#include "gateway_util.h"
+#include "../services/profiler.h"
+#include "../debug_config.h"
+
+namespace gateway_sync {
+    static WebServer* server = nullptr;
+
+    const char* MANIFEST_DIR = "/.hi5sync";
+    const char* PART_SUFFIX = ".part";
+    const size_t MAX_RECENT_HASHES = 16;
+
+    struct ManifestEntry {
+        uint32_t size;
+        uint32_t mtime;
+        String sha256;
+    };
+
+    typedef std::map<String, ManifestEntry> Manifest;
+
+    struct RecentHash {
+        String path;
+        uint32_t size;
+        String sha256;
+    };
+
+    static std::vector<RecentHash> recentHashes;
+
+    void recordHash(const String& path, uint32_t size, const String& sha256) {
+        for (size_t i = 0; i < recentHashes.size(); ++i) {
+            if (recentHashes[i].path == path) {
+                recentHashes.erase(recentHashes.begin() + i);
+                break;
+            }
+        }
+        if (recentHashes.size() >= MAX_RECENT_HASHES) {
+            recentHashes.erase(recentHashes.begin());
+        }
+        recentHashes.push_back(RecentHash{path, size, sha256});
+    }
+
+    static bool takeRecentHash(const String& path, uint32_t size, String& sha256) {
+        for (size_t i = 0; i < recentHashes.size(); ++i) {
+            if (recentHashes[i].path != path) continue;
+            bool match = recentHashes[i].size == size;
+            if (match) sha256 = recentHashes[i].sha256;
+            recentHashes.erase(recentHashes.begin() + i);
+            return match;
+        }
+        return false;
+    }
+
+    // Named after a hash of the root, so "/a_b" and "/a/b" get separate files; the
+    // first line records the root itself and a file for any other root is ignored.
+    static String manifestFileFor(const String& root) {
+        uint8_t digest[32];
+        mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), (const uint8_t*)root.c_str(), root.length(), digest);
+        return String(MANIFEST_DIR) + "/" + gateway_util::hexEncode(digest, 8) + ".tsv";
+    }
+
+    static String manifestHeader(const String& root) {
+        return "#root\t" + root;
+    }
+
+    static void loadManifest(const String& file, const String& root, Manifest& manifest) {
+        File in = SD.open(file, FILE_READ);
+        if (!in) return;
+        String header = in.readStringUntil('\n');
+        header.trim();
+        if (header != manifestHeader(root)) {
+            in.close();
+            return;
+        }
+        while (in.available()) {
+            String line = in.readStringUntil('\n');
+            int a = line.indexOf('\t');
+            int b = line.indexOf('\t', a + 1);
+            int c = line.indexOf('\t', b + 1);
+            if (a <= 0 || b < 0 || c < 0) continue;
+            ManifestEntry entry;
+            entry.size = (uint32_t)strtoul(line.substring(a + 1, b).c_str(), nullptr, 10);
+            entry.mtime = (uint32_t)strtoul(line.substring(b + 1, c).c_str(), nullptr, 10);
+            entry.sha256 = line.substring(c + 1);
+            entry.sha256.trim();
+            if (entry.sha256.length() != 64) continue;
+            manifest[line.substring(0, a)] = entry;
+        }
+        in.close();
+    }
+
+    static bool saveManifest(const String& file, const String& root, const Manifest& manifest) {
+        if (!SD.exists(MANIFEST_DIR)) SD.mkdir(MANIFEST_DIR);
+        String tmp = file + ".tmp";
+        File out = SD.open(tmp, FILE_WRITE);
+        if (!out) return false;
+        out.print(manifestHeader(root));
+        out.print('\n');
+        for (Manifest::const_iterator it = manifest.begin(); it != manifest.end(); ++it) {
+            out.print(it->first);
+            out.print('\t');
+            out.print((unsigned long)it->second.size);
+            out.print('\t');
+            out.print((unsigned long)it->second.mtime);
+            out.print('\t');
+            out.print(it->second.sha256);
+            out.print('\n');
+        }
+        out.close();
+        if (SD.exists(file)) SD.remove(file);
+        return SD.rename(tmp, file);
+    }
+
+    static bool hashFile(File& file, String& sha256) {
+        mbedtls_md_context_t ctx;
+        mbedtls_md_init(&ctx);
+        if (mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0) != 0) {
+            mbedtls_md_free(&ctx);
+            return false;
+        }
+        mbedtls_md_starts(&ctx);
+        uint8_t* hashBuffer = gateway_util::ioBuffer(gateway_util::IO_SYNC_HASH);
+        while (true) {
+            int n = file.read(hashBuffer, gateway_util::IO_BUFFER_SIZE);
+            if (n <= 0) break;
+            mbedtls_md_update(&ctx, hashBuffer, n);
+        }
+        uint8_t digest[32];
+        mbedtls_md_finish(&ctx, digest);
+        mbedtls_md_free(&ctx);
+        sha256 = gateway_util::hexEncode(digest, sizeof(digest));
+        return true;
+    }
+
+    static bool isSyncable(const String& name) {
+        if (name.length() == 0 || name[0] == '.') return false;
+        return !name.endsWith(PART_SUFFIX);
+    }
+
+    static String relativePath(const String& root, const String& path) {
+        return root == "/" ? path.substring(1) : path.substring(root.length() + 1);
+    }
+
+    void handleManifest() {
+        PROFILE_SCOPE("gateway.handleManifest");
+        String root;
+        if (!gateway_util::normalizePath(server->arg("path"), root)) {
+            gateway_util::sendError(server, 400, "Invalid path");
+            return;
+        }
+        File rootDir = SD.open(root);
+        if (!rootDir || !rootDir.isDirectory()) {
+            if (rootDir) rootDir.close();
+            gateway_util::sendError(server, 404, "Not a directory");
+            return;
+        }
+        rootDir.close();
+
+        String manifestFile = manifestFileFor(root);
+        Manifest cached;
+        loadManifest(manifestFile, root, cached);
+        Manifest fresh;
+        int hashed = 0;
+        int updated = 0;
+
+        server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server->send(200, "application/json", "");
+        server->sendContent("{\"v\":" + String(gateway_util::API_VERSION) + ",\"root\":\"" + root + "\",\"entries\":[");
+
+        bool first = true;
+        std::vector<String> pendingDirs;
+        pendingDirs.push_back(root);
+        while (!pendingDirs.empty()) {
+            String dirPath = pendingDirs.back();
+            pendingDirs.pop_back();
+            File dir = SD.open(dirPath);
+            if (!dir || !dir.isDirectory()) {
+                if (dir) dir.close();
+                continue;
+            }
+            while (true) {
+                File entry = dir.openNextFile();
+                if (!entry) break;
+                String name = entry.name();
+                String path = gateway_util::joinPath(dirPath, name);
+                if (!isSyncable(name)) {
+                    entry.close();
+                    continue;
+                }
+                if (entry.isDirectory()) {
+                    pendingDirs.push_back(path);
+                    entry.close();
+                    continue;
+                }
+
+                String rel = relativePath(root, path);
+                ManifestEntry item;
+                item.size = entry.size();
+                item.mtime = (uint32_t)entry.getLastWrite();
+                Manifest::iterator known = cached.find(rel);
+                if (known != cached.end() && known->second.size == item.size && known->second.mtime == item.mtime) {
+                    item.sha256 = known->second.sha256;
+                } else {
+                    if (!takeRecentHash(path, item.size, item.sha256)) {
+                        hashFile(entry, item.sha256);
+                        hashed++;
+                    }
+                    updated++;
+                }
+                entry.close();
+                fresh[rel] = item;
+
+                JsonDocument doc;
+                doc["path"] = rel;
+                doc["size"] = item.size;
+                doc["mtime"] = item.mtime;
+                doc["sha256"] = item.sha256;
+                // serializeJson() replaces the string's content, so the separator goes on afterwards.
+                String json;
+                serializeJson(doc, json);
+                server->sendContent(first ? json : "," + json);
+                first = false;
+            }
+            dir.close();
+        }
+
+        bool changed = updated > 0 || fresh.size() != cached.size();
+        if (changed && !saveManifest(manifestFile, root, fresh)) {
+            #ifdef DEBUG_SD_GATEWAY
+            Serial.println("[SD Gateway] failed to save sync manifest " + manifestFile);
+            #endif
+        }
+        #ifdef DEBUG_SD_GATEWAY
+        Serial.printf("[SD Gateway] manifest %s: %u files, %d hashed\n", root.c_str(), (unsigned)fresh.size(), hashed);
+        #endif
+        server->sendContent("],\"hashed\":" + String(hashed) + "}");
+        server->sendContent("");
+    }
+
+    void handleDownload() {
+        PROFILE_SCOPE("gateway.handleDownload");
+        String path;
+        if (!gateway_util::normalizePath(server->arg("path"), path)) {
+            gateway_util::sendError(server, 400, "Invalid path");
+            return;
+        }
+        File file = SD.open(path, FILE_READ);
+        if (!file || file.isDirectory()) {
+            if (file) file.close();
+            gateway_util::sendError(server, 404, "Not found");
+            return;
+        }
+        server->sendHeader("X-Mtime", String((unsigned long)file.getLastWrite()));
+        server->streamFile(file, "application/octet-stream");
+        file.close();
+    }
+
+    void registerRoutes(WebServer* webServer) {
+        server = webServer;
+        server->on("/api/sync/manifest", HTTP_GET, handleManifest);
+        server->on("/api/file", HTTP_GET, handleDownload);
+    }
+}
@@ -0,0 +1,13 @@
+#ifndef GATEWAY_SYNC_MANIFEST_H
+#define GATEWAY_SYNC_MANIFEST_H
+
+#include <Arduino.h>
+
+class WebServer;
+
+namespace gateway_sync {
+    void registerRoutes(WebServer* server);
+    void recordHash(const String& path, uint32_t size, const String& sha256);
+}
+
+#endif // GATEWAY_SYNC_MANIFEST_H
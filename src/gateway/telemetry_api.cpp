@@ -0,0 +1,84 @@
+#include <Arduino.h>
+#include <WebServer.h>
+#include <ArduinoJson.h>
+#include "telemetry_api.h"
+#include "gateway_util.h"
+#include "../services/power_telemetry.h"
+#include "../services/battery_estimator.h"
+#include "../services/latency_trace.h"
+#include "../services/profiler.h"
+#include "../services/heap_telemetry.h"
+
+namespace gateway_telemetry {
+    static WebServer* server = nullptr;
+
+    static void handlePower() {
+        PROFILE_SCOPE("gateway.handlePower");
+        JsonDocument doc;
+        JsonObject root = doc.to<JsonObject>();
+        root["v"] = gateway_util::API_VERSION;
+        power_telemetry::writeJson(root);
+        String json;
+        serializeJson(doc, json);
+        gateway_util::sendJson(server, 200, json);
+    }
+
+    static void handleBattery() {
+        PROFILE_SCOPE("gateway.handleBattery");
+        JsonDocument doc;
+        JsonObject root = doc.to<JsonObject>();
+        root["v"] = gateway_util::API_VERSION;
+        battery_estimator::writeJson(root);
+        String json;
+        serializeJson(doc, json);
+        gateway_util::sendJson(server, 200, json);
+    }
+
+    static void handleTrace() {
+        PROFILE_SCOPE("gateway.handleTrace");
+        if (server->hasArg("clear")) {
+            latency_trace::clear();
+        }
+        JsonDocument doc;
+        JsonObject root = doc.to<JsonObject>();
+        root["v"] = gateway_util::API_VERSION;
+        latency_trace::writeJson(root);
+        String json;
+        serializeJson(doc, json);
+        gateway_util::sendJson(server, 200, json);
+    }
+
+    static void handleProfile() {
+        PROFILE_SCOPE("gateway.handleProfile");
+        if (server->hasArg("reset")) {
+            profiler::reset();
+        }
+        JsonDocument doc;
+        JsonObject root = doc.to<JsonObject>();
+        root["v"] = gateway_util::API_VERSION;
+        profiler::writeJson(root);
+        String json;
+        serializeJson(doc, json);
+        gateway_util::sendJson(server, 200, json);
+    }
+
+    static void handleHeap() {
+        PROFILE_SCOPE("gateway.handleHeap");
+        JsonDocument doc;
+        JsonObject root = doc.to<JsonObject>();
+        root["v"] = gateway_util::API_VERSION;
+        heap_telemetry::writeJson(root);
+        String json;
+        serializeJson(doc, json);
+        gateway_util::sendJson(server, 200, json);
+    }
+
+    void registerRoutes(WebServer* webServer) {
+        server = webServer;
+        server->on("/api/power", HTTP_GET, handlePower);
+        server->on("/api/battery", HTTP_GET, handleBattery);
+        server->on("/api/trace", HTTP_GET, handleTrace);
+        server->on("/api/profile", HTTP_GET, handleProfile);
+        server->on("/api/heap", HTTP_GET, handleHeap);
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef GATEWAY_TELEMETRY_API_H
+#define GATEWAY_TELEMETRY_API_H
+
+#include <Arduino.h>
+
+class WebServer;
+
+namespace gateway_telemetry {
+    void registerRoutes(WebServer* server);
+}
+
+#endif // GATEWAY_TELEMETRY_API_H
@@ -0,0 +1,560 @@
+#include <Arduino.h>
+#include <SD.h>
+#include <WebServer.h>
+#include <time.h>
+#include <vector>
+#include "zip_stream.h"
+#include "gateway_util.h"
+#include "events.h"
+#include "../crc32.h"
+#include "../services/profiler.h"
+#include "../debug_config.h"
+
+namespace gateway_zip {
+    static WebServer* server = nullptr;
+
+    const uint32_t SIG_LOCAL_HEADER = 0x04034b50;
+    const uint32_t SIG_DATA_DESCRIPTOR = 0x08074b50;
+    const uint32_t SIG_CENTRAL_HEADER = 0x02014b50;
+    const uint32_t SIG_END_OF_CENTRAL = 0x06054b50;
+    const uint16_t FLAG_DATA_DESCRIPTOR = 0x0008;
+    const uint16_t FLAG_UTF8 = 0x0800;
+    const uint16_t METHOD_STORED = 0;
+    using gateway_util::IO_BUFFER_SIZE;
+
+    static uint8_t* ioBuffer() {
+        return gateway_util::ioBuffer(gateway_util::IO_ZIP);
+    }
+
+    static void put16(uint8_t* p, uint16_t v) {
+        p[0] = v & 0xFF;
+        p[1] = (v >> 8) & 0xFF;
+    }
+
+    static void put32(uint8_t* p, uint32_t v) {
+        p[0] = v & 0xFF;
+        p[1] = (v >> 8) & 0xFF;
+        p[2] = (v >> 16) & 0xFF;
+        p[3] = (v >> 24) & 0xFF;
+    }
+
+    static uint16_t get16(const uint8_t* p) {
+        return p[0] | (p[1] << 8);
+    }
+
+    static uint32_t get32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    static uint32_t toDosDateTime(time_t t) {
+        struct tm tmv;
+        gmtime_r(&t, &tmv);
+        if (tmv.tm_year < 80) return (1 << 21) | (1 << 16);
+        uint32_t date = ((tmv.tm_year - 80) << 9) | ((tmv.tm_mon + 1) << 5) | tmv.tm_mday;
+        uint32_t time = (tmv.tm_hour << 11) | (tmv.tm_min << 5) | (tmv.tm_sec / 2);
+        return (date << 16) | time;
+    }
+
+
+    class FileWalker {
+    public:
+        explicit FileWalker(const String& root) : _root(root) {
+            _pending.push_back(root);
+        }
+
+        ~FileWalker() {
+            if (_dir) _dir.close();
+        }
+
+        bool next(File& file, String& relativePath) {
+            while (true) {
+                if (!_dir) {
+                    if (_pending.empty()) return false;
+                    _dirPath = _pending.front();
+                    _pending.erase(_pending.begin());
+                    _dir = SD.open(_dirPath);
+                    if (!_dir || !_dir.isDirectory()) {
+                        if (_dir) _dir.close();
+                        continue;
+                    }
+                }
+                File entry = _dir.openNextFile();
+                if (!entry) {
+                    _dir.close();
+                    continue;
+                }
+                String path = gateway_util::joinPath(_dirPath, entry.name());
+                if (entry.isDirectory()) {
+                    entry.close();
+                    _pending.push_back(path);
+                    continue;
+                }
+                relativePath = path.substring(_root == "/" ? 1 : _root.length() + 1);
+                file = entry;
+                return true;
+            }
+        }
+
+    private:
+        String _root;
+        String _dirPath;
+        File _dir;
+        std::vector<String> _pending;
+    };
+
+
+    struct CentralRecord {
+        uint32_t crc;
+        uint32_t size;
+        uint32_t offset;
+        uint32_t dosDateTime;
+    };
+
+    class ZipWriter {
+    public:
+        ZipWriter() : _used(0), _offset(0) {}
+
+        void write(const uint8_t* data, size_t length) {
+            while (length > 0) {
+                size_t n = min(length, IO_BUFFER_SIZE - _used);
+                memcpy(ioBuffer() + _used, data, n);
+                _used += n;
+                data += n;
+                length -= n;
+                _offset += n;
+                if (_used == IO_BUFFER_SIZE) flush();
+            }
+        }
+
+        uint8_t* reserve(size_t& available) {
+            if (_used == IO_BUFFER_SIZE) flush();
+            available = IO_BUFFER_SIZE - _used;
+            return ioBuffer() + _used;
+        }
+
+        void commit(size_t length) {
+            _used += length;
+            _offset += length;
+            if (_used == IO_BUFFER_SIZE) flush();
+        }
+
+        void flush() {
+            if (_used > 0) {
+                server->sendContent((const char*)ioBuffer(), _used);
+                _used = 0;
+            }
+        }
+
+        uint32_t offset() const { return _offset; }
+
+    private:
+        size_t _used;
+        uint32_t _offset;
+    };
+
+    void handleZipDownload() {
+        PROFILE_SCOPE("gateway.handleZipDownload");
+        String rootPath;
+        if (!gateway_util::normalizePath(server->hasArg("path") ? server->arg("path") : "/", rootPath)) {
+            gateway_util::sendError(server, 400, "Invalid path");
+            return;
+        }
+        File root = SD.open(rootPath);
+        if (!root || !root.isDirectory()) {
+            if (root) root.close();
+            gateway_util::sendError(server, 404, "Not a directory: " + rootPath);
+            return;
+        }
+        root.close();
+        if (server->hasArg("method") && server->arg("method") != "store") {
+            gateway_util::sendError(server, 501, "Only store method is supported");
+            return;
+        }
+
+        String archiveName = rootPath == "/" ? "sd" : rootPath.substring(rootPath.lastIndexOf('/') + 1);
+        server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server->sendHeader("Content-Disposition", "attachment; filename=\"" + archiveName + ".zip\"");
+        server->send(200, "application/zip", "");
+
+        #ifdef DEBUG_SD_GATEWAY
+        unsigned long startTime = millis();
+        #endif
+
+        ZipWriter out;
+        std::vector<CentralRecord> records;
+        uint8_t header[46];
+
+        {
+            FileWalker walker(rootPath);
+            File file;
+            String name;
+            while (walker.next(file, name)) {
+                CentralRecord record;
+                record.offset = out.offset();
+                record.dosDateTime = toDosDateTime(file.getLastWrite());
+                record.crc = 0;
+                record.size = 0;
+
+                put32(header, SIG_LOCAL_HEADER);
+                put16(header + 4, 20);
+                put16(header + 6, FLAG_DATA_DESCRIPTOR | FLAG_UTF8);
+                put16(header + 8, METHOD_STORED);
+                put32(header + 10, record.dosDateTime);
+                put32(header + 14, 0);
+                put32(header + 18, 0);
+                put32(header + 22, 0);
+                put16(header + 26, name.length());
+                put16(header + 28, 0);
+                out.write(header, 30);
+                out.write((const uint8_t*)name.c_str(), name.length());
+
+                while (true) {
+                    size_t available = 0;
+                    uint8_t* dst = out.reserve(available);
+                    int n = file.read(dst, available);
+                    if (n <= 0) break;
+                    record.crc = crc32Update(record.crc, dst, n);
+                    record.size += n;
+                    out.commit(n);
+                }
+                file.close();
+
+                put32(header, SIG_DATA_DESCRIPTOR);
+                put32(header + 4, record.crc);
+                put32(header + 8, record.size);
+                put32(header + 12, record.size);
+                out.write(header, 16);
+
+                records.push_back(record);
+            }
+        }
+
+        uint32_t centralStart = out.offset();
+        size_t index = 0;
+        {
+            FileWalker walker(rootPath);
+            File file;
+            String name;
+            while (index < records.size() && walker.next(file, name)) {
+                file.close();
+                const CentralRecord& record = records[index++];
+                put32(header, SIG_CENTRAL_HEADER);
+                put16(header + 4, 20);
+                put16(header + 6, 20);
+                put16(header + 8, FLAG_DATA_DESCRIPTOR | FLAG_UTF8);
+                put16(header + 10, METHOD_STORED);
+                put32(header + 12, record.dosDateTime);
+                put32(header + 16, record.crc);
+                put32(header + 20, record.size);
+                put32(header + 24, record.size);
+                put16(header + 28, name.length());
+                put16(header + 30, 0);
+                put16(header + 32, 0);
+                put16(header + 34, 0);
+                put16(header + 36, 0);
+                put32(header + 38, 0);
+                put32(header + 42, record.offset);
+                out.write(header, 46);
+                out.write((const uint8_t*)name.c_str(), name.length());
+            }
+        }
+        uint32_t centralSize = out.offset() - centralStart;
+
+        put32(header, SIG_END_OF_CENTRAL);
+        put16(header + 4, 0);
+        put16(header + 6, 0);
+        put16(header + 8, index);
+        put16(header + 10, index);
+        put32(header + 12, centralSize);
+        put32(header + 16, centralStart);
+        put16(header + 20, 0);
+        out.write(header, 22);
+        out.flush();
+        server->sendContent("");
+
+        #ifdef DEBUG_SD_GATEWAY
+        Serial.printf("[SD Gateway] zip %s: %u entries, %u bytes in %lu ms\n",
+                      rootPath.c_str(), (unsigned)index, (unsigned)out.offset(), millis() - startTime);
+        #endif
+    }
+
+
+    enum ParseState {
+        PARSE_SIGNATURE,
+        PARSE_LOCAL_HEADER,
+        PARSE_NAME,
+        PARSE_EXTRA,
+        PARSE_DATA,
+        PARSE_DATA_SCAN,
+        PARSE_DESCRIPTOR,
+        PARSE_DONE,
+        PARSE_ERROR
+    };
+
+    struct ZipExtractor {
+        ParseState state;
+        String destRoot;
+        String error;
+        uint8_t header[30];
+        size_t headerUsed;
+        size_t need;
+        String name;
+        uint16_t flags;
+        uint16_t method;
+        uint32_t expectedCrc;
+        uint32_t remaining;
+        uint16_t extraRemaining;
+        uint32_t crc;
+        uint32_t written;
+        bool skipping;
+        File out;
+        String path;
+        size_t outUsed;
+        uint8_t tail[16];
+        size_t tailUsed;
+        int extracted;
+        int skipped;
+    };
+
+    static ZipExtractor extractor;
+
+    static void flushOut() {
+        if (extractor.outUsed > 0) {
+            if (extractor.out) extractor.out.write(ioBuffer(), extractor.outUsed);
+            extractor.outUsed = 0;
+        }
+    }
+
+    static void emitData(const uint8_t* data, size_t length) {
+        extractor.crc = crc32Update(extractor.crc, data, length);
+        extractor.written += length;
+        if (extractor.skipping) return;
+        while (length > 0) {
+            size_t n = min(length, IO_BUFFER_SIZE - extractor.outUsed);
+            memcpy(ioBuffer() + extractor.outUsed, data, n);
+            extractor.outUsed += n;
+            data += n;
+            length -= n;
+            if (extractor.outUsed == IO_BUFFER_SIZE) flushOut();
+        }
+    }
+
+    static void fail(const String& message) {
+        flushOut();
+        if (extractor.out) extractor.out.close();
+        extractor.error = message;
+        extractor.state = PARSE_ERROR;
+    }
+
+    static void beginEntry() {
+        extractor.flags = get16(extractor.header + 6);
+        extractor.method = get16(extractor.header + 8);
+        extractor.expectedCrc = get32(extractor.header + 14);
+        extractor.remaining = get32(extractor.header + 18);
+        extractor.need = get16(extractor.header + 26);
+        extractor.extraRemaining = get16(extractor.header + 28);
+        extractor.name = "";
+        extractor.state = extractor.need > 0 ? PARSE_NAME : PARSE_EXTRA;
+    }
+
+    static void openEntry() {
+        extractor.crc = 0;
+        extractor.written = 0;
+        extractor.tailUsed = 0;
+        extractor.outUsed = 0;
+        extractor.skipping = false;
+
+        String path;
+        if (extractor.name.length() == 0 ||
+            !gateway_util::normalizePath(extractor.destRoot + "/" + extractor.name, path) || path == "/") {
+            fail("Invalid entry name: " + extractor.name);
+            return;
+        }
+
+        bool sizeKnown = !(extractor.flags & FLAG_DATA_DESCRIPTOR) || extractor.remaining > 0;
+        if (extractor.name.endsWith("/")) {
+            gateway_util::ensureParentDirs(path + "/");
+            extractor.skipping = true;
+        } else if (extractor.method != METHOD_STORED) {
+            if (!sizeKnown) {
+                fail("Compressed entry without size: " + extractor.name);
+                return;
+            }
+            extractor.skipping = true;
+            extractor.skipped++;
+        } else {
+            gateway_util::ensureParentDirs(path);
+            extractor.out = SD.open(path, FILE_WRITE);
+            extractor.path = path;
+            if (!extractor.out) {
+                fail("Cannot create " + path);
+                return;
+            }
+        }
+
+        if (sizeKnown) {
+            extractor.state = extractor.remaining > 0 ? PARSE_DATA : PARSE_DESCRIPTOR;
+            extractor.need = (extractor.flags & FLAG_DATA_DESCRIPTOR) ? 12 : 0;
+        } else {
+            extractor.state = PARSE_DATA_SCAN;
+        }
+        extractor.headerUsed = 0;
+    }
+
+    static void finishEntry() {
+        flushOut();
+        bool wasFile = (bool)extractor.out;
+        if (extractor.out) extractor.out.close();
+        bool verify = extractor.method == METHOD_STORED && !extractor.name.endsWith("/");
+        if (verify && !(extractor.flags & FLAG_DATA_DESCRIPTOR) && extractor.crc != extractor.expectedCrc) {
+            fail("CRC mismatch: " + extractor.name);
+            return;
+        }
+        if (wasFile) {
+            extractor.extracted++;
+            gateway_events::notifyFileChanged(extractor.path, "created");
+        }
+        extractor.state = PARSE_SIGNATURE;
+        extractor.headerUsed = 0;
+    }
+
+    static void feed(const uint8_t* data, size_t length) {
+        size_t pos = 0;
+        while (pos < length && extractor.state != PARSE_ERROR && extractor.state != PARSE_DONE) {
+            switch (extractor.state) {
+                case PARSE_SIGNATURE:
+                case PARSE_LOCAL_HEADER: {
+                    size_t target = extractor.state == PARSE_SIGNATURE ? 4 : 30;
+                    while (pos < length && extractor.headerUsed < target) {
+                        extractor.header[extractor.headerUsed++] = data[pos++];
+                    }
+                    if (extractor.headerUsed < target) break;
+                    if (extractor.state == PARSE_SIGNATURE) {
+                        uint32_t sig = get32(extractor.header);
+                        if (sig == SIG_LOCAL_HEADER) {
+                            extractor.state = PARSE_LOCAL_HEADER;
+                        } else if (sig == SIG_CENTRAL_HEADER || sig == SIG_END_OF_CENTRAL) {
+                            extractor.state = PARSE_DONE;
+                        } else {
+                            fail("Bad signature");
+                        }
+                    } else {
+                        beginEntry();
+                    }
+                    break;
+                }
+                case PARSE_NAME:
+                    while (pos < length && extractor.need > 0) {
+                        extractor.name += (char)data[pos++];
+                        extractor.need--;
+                    }
+                    if (extractor.need == 0) extractor.state = PARSE_EXTRA;
+                    break;
+                case PARSE_EXTRA: {
+                    size_t n = min((size_t)extractor.extraRemaining, length - pos);
+                    pos += n;
+                    extractor.extraRemaining -= n;
+                    if (extractor.extraRemaining == 0) openEntry();
+                    break;
+                }
+                case PARSE_DATA: {
+                    size_t n = min((size_t)extractor.remaining, length - pos);
+                    emitData(data + pos, n);
+                    pos += n;
+                    extractor.remaining -= n;
+                    if (extractor.remaining == 0) {
+                        extractor.state = PARSE_DESCRIPTOR;
+                        extractor.headerUsed = 0;
+                    }
+                    break;
+                }
+                case PARSE_DATA_SCAN: {
+                    uint8_t b = data[pos++];
+                    if (extractor.tailUsed == sizeof(extractor.tail)) {
+                        emitData(extractor.tail, 1);
+                        memmove(extractor.tail, extractor.tail + 1, sizeof(extractor.tail) - 1);
+                        extractor.tailUsed--;
+                    }
+                    extractor.tail[extractor.tailUsed++] = b;
+                    if (extractor.tailUsed == sizeof(extractor.tail) &&
+                        get32(extractor.tail) == SIG_DATA_DESCRIPTOR &&
+                        get32(extractor.tail + 4) == extractor.crc &&
+                        get32(extractor.tail + 8) == extractor.written &&
+                        get32(extractor.tail + 12) == extractor.written) {
+                        finishEntry();
+                    }
+                    break;
+                }
+                case PARSE_DESCRIPTOR: {
+                    if (!(extractor.flags & FLAG_DATA_DESCRIPTOR)) {
+                        finishEntry();
+                        break;
+                    }
+                    while (pos < length && extractor.headerUsed < 16) {
+                        extractor.header[extractor.headerUsed++] = data[pos++];
+                        if (extractor.headerUsed == 4 && get32(extractor.header) != SIG_DATA_DESCRIPTOR) {
+                            extractor.need = 12;
+                        } else if (extractor.headerUsed == 4) {
+                            extractor.need = 16;
+                        }
+                        if (extractor.headerUsed >= 4 && extractor.headerUsed == extractor.need) break;
+                    }
+                    if (extractor.headerUsed < 4 || extractor.headerUsed < extractor.need) break;
+                    const uint8_t* crcField = extractor.need == 16 ? extractor.header + 4 : extractor.header;
+                    extractor.expectedCrc = get32(crcField);
+                    extractor.flags &= ~FLAG_DATA_DESCRIPTOR;
+                    finishEntry();
+                    break;
+                }
+                default:
+                    pos = length;
+                    break;
+            }
+        }
+    }
+
+    void handleUnzipRaw() {
+        PROFILE_SCOPE("gateway.handleUnzipRaw");
+        HTTPRaw& raw = server->raw();
+        if (raw.status == RAW_START) {
+            extractor.state = PARSE_SIGNATURE;
+            extractor.headerUsed = 0;
+            extractor.error = "";
+            extractor.extracted = 0;
+            extractor.skipped = 0;
+            extractor.outUsed = 0;
+            if (!gateway_util::normalizePath(server->hasArg("path") ? server->arg("path") : "/", extractor.destRoot)) {
+                fail("Invalid path");
+            }
+            #ifdef DEBUG_SD_GATEWAY
+            Serial.println("[SD Gateway] unzip into " + extractor.destRoot);
+            #endif
+        } else if (raw.status == RAW_WRITE) {
+            feed(raw.buf, raw.currentSize);
+        } else if (raw.status == RAW_END) {
+            if (extractor.state != PARSE_DONE && extractor.state != PARSE_SIGNATURE && extractor.state != PARSE_ERROR) {
+                fail("Truncated archive");
+            }
+        } else if (raw.status == RAW_ABORTED) {
+            fail("Upload aborted");
+        }
+    }
+
+    void handleUnzipDone() {
+        PROFILE_SCOPE("gateway.handleUnzipDone");
+        if (extractor.state == PARSE_ERROR) {
+            gateway_util::sendError(server, 422, extractor.error + " (" + String(extractor.extracted) + " extracted)");
+            return;
+        }
+        String json = "{\"v\":" + String(gateway_util::API_VERSION) +
+                      ",\"extracted\":" + String(extractor.extracted) +
+                      ",\"skipped\":" + String(extractor.skipped) + "}";
+        gateway_util::sendJson(server, 200, json);
+    }
+
+    void registerRoutes(WebServer* webServer) {
+        server = webServer;
+        server->on("/api/zip", HTTP_GET, handleZipDownload);
+        server->on("/api/unzip", HTTP_POST, handleUnzipDone, handleUnzipRaw);
+    }
+}
@@ -0,0 +1,10 @@
+#ifndef GATEWAY_ZIP_STREAM_H
+#define GATEWAY_ZIP_STREAM_H
+
+class WebServer;
+
+namespace gateway_zip {
+    void registerRoutes(WebServer* server);
+}
+
+#endif // GATEWAY_ZIP_STREAM_H
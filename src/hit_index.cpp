@@ -0,0 +1,103 @@
+#include "hit_index.h"
+#include "ui.h"
+
+namespace hit_index {
+    static const int GRID_COLS = (EPD_WIDTH + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE;
+    static const int GRID_ROWS = (EPD_HEIGHT + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE;
+    static const int CELL_SLOTS = 6;
+
+    struct GridCell {
+        uint8_t slots[CELL_SLOTS];
+        uint8_t count;
+        bool overflow;
+    };
+
+    static HitTarget targets[MAX_TARGETS];
+    static int targetCount = 0;
+    static GridCell grid[GRID_ROWS][GRID_COLS];
+
+    static int clampCol(int x) {
+        int col = x / GRID_CELL_SIZE;
+        return col < 0 ? 0 : (col >= GRID_COLS ? GRID_COLS - 1 : col);
+    }
+
+    static int clampRow(int y) {
+        int row = y / GRID_CELL_SIZE;
+        return row < 0 ? 0 : (row >= GRID_ROWS ? GRID_ROWS - 1 : row);
+    }
+
+    static bool contains(const HitTarget& target, int x, int y) {
+        return x >= target.x && x < target.x + target.width &&
+               y >= target.y && y < target.y + target.height;
+    }
+
+    static bool sameTarget(const HitTarget& a, int x, int y, int width, int height, uint16_t action, int16_t param) {
+        return a.x == x && a.y == y && a.width == width && a.height == height &&
+               a.action == action && a.param == param;
+    }
+
+    void clear() {
+        targetCount = 0;
+        memset(grid, 0, sizeof(grid));
+    }
+
+    bool add(int x, int y, int width, int height, uint16_t action, int16_t param) {
+        if (width <= 0 || height <= 0) return false;
+        int firstCol = clampCol(x);
+        int lastCol = clampCol(x + width - 1);
+        int firstRow = clampRow(y);
+        int lastRow = clampRow(y + height - 1);
+
+        GridCell& anchor = grid[firstRow][firstCol];
+        for (int i = 0; i < anchor.count; ++i) {
+            if (sameTarget(targets[anchor.slots[i]], x, y, width, height, action, param)) return true;
+        }
+        if (targetCount >= MAX_TARGETS) return false;
+
+        uint8_t index = (uint8_t)targetCount++;
+        targets[index] = { (int16_t)x, (int16_t)y, (int16_t)width, (int16_t)height, action, param };
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int col = firstCol; col <= lastCol; ++col) {
+                GridCell& cell = grid[row][col];
+                if (cell.count < CELL_SLOTS) {
+                    cell.slots[cell.count++] = index;
+                } else {
+                    cell.overflow = true;
+                }
+            }
+        }
+        return true;
+    }
+
+    const HitTarget* lookup(int x, int y) {
+        if (x < 0 || y < 0 || x >= EPD_WIDTH || y >= EPD_HEIGHT) return nullptr;
+        const GridCell& cell = grid[clampRow(y)][clampCol(x)];
+        if (cell.overflow) {
+            for (int i = targetCount - 1; i >= 0; --i) {
+                if (contains(targets[i], x, y)) return &targets[i];
+            }
+            return nullptr;
+        }
+        for (int i = cell.count - 1; i >= 0; --i) {
+            const HitTarget& target = targets[cell.slots[i]];
+            if (contains(target, x, y)) return &target;
+        }
+        return nullptr;
+    }
+
+    void highlight(const HitTarget& target) {
+        epd_mode_t mode = M5.Display.getEpdMode();
+        M5.Display.setEpdMode(epd_mode_t::epd_fastest);
+        M5.Display.drawRect(target.x, target.y, target.width, target.height, TFT_BLACK);
+        M5.Display.drawRect(target.x + 1, target.y + 1, target.width - 2, target.height - 2, TFT_BLACK);
+        M5.Display.display(target.x, target.y, target.width, target.height);
+        // Erased from the frame buffer only; the frame that follows the touch repaints it.
+        M5.Display.drawRect(target.x, target.y, target.width, target.height, TFT_WHITE);
+        M5.Display.drawRect(target.x + 1, target.y + 1, target.width - 2, target.height - 2, TFT_WHITE);
+        M5.Display.setEpdMode(mode);
+    }
+
+    int count() {
+        return targetCount;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef HIT_INDEX_H
+#define HIT_INDEX_H
+
+#include <stdint.h>
+
+// Touch targets registered while a frame is drawn, bucketed into a uniform
+// grid so a touch resolves with one cell lookup.
+namespace hit_index {
+
+    enum HitAction : uint16_t {
+        HIT_NONE = 0,
+        HIT_FOOTER_BUTTON,
+        HIT_ROW,
+        HIT_PAGE_FIRST,
+        HIT_PAGE_PREV,
+        HIT_PAGE_NEXT,
+        HIT_PAGE_LAST,
+        HIT_KEY,
+        HIT_NUMBER_KEY,
+        HIT_CELL,
+        HIT_RESTART,
+        HIT_HINT,
+        // Screens number their own actions from here.
+        HIT_SCREEN_BASE = 64
+    };
+
+    struct HitTarget {
+        int16_t x;
+        int16_t y;
+        int16_t width;
+        int16_t height;
+        uint16_t action;
+        int16_t param;
+    };
+
+    static const int MAX_TARGETS = 200;
+    static const int GRID_CELL_SIZE = 60;
+
+    void clear();
+    bool add(int x, int y, int width, int height, uint16_t action, int16_t param = 0);
+
+    // Topmost (last registered) target containing the point, or nullptr.
+    const HitTarget* lookup(int x, int y);
+
+    // Outlines the target with a fast partial refresh as touch feedback.
+    void highlight(const HitTarget& target);
+
+    int count();
+}
+
+#endif // HIT_INDEX_H
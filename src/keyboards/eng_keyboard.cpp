@@ -1,11 +1,33 @@
 #include "eng_keyboard.h"
 #include "../ui.h"
+#include "../hit_index.h"
 
 namespace keyboards {
     KeyboardState currentKeyboardState = LOWERCASE;
 
+    static constexpr const char* ENG_KEYBOARD_LAYOUT_LOWER[KEYBOARD_ROWS][KEYBOARD_COLS] = {
+        {"1", "2", "3", "4", "5", "6", "7", "8", "9", "0", "<"},
+        {"q", "w", "e", "r", "t", "y", "u", "i", "o", "p", ">"},
+        {"a", "s", "d", "f", "g", "h", "j", "k", "l", ".", "~"},
+        {"z", "x", "c", "v", "b", "n", "m", ",", "?", " ", " "}
+    };
 
-    const String (*getCurrentLayout())[KEYBOARD_COLS] {
+    static constexpr const char* ENG_KEYBOARD_LAYOUT_UPPER[KEYBOARD_ROWS][KEYBOARD_COLS] = {
+        {"!", "@", "#", "$", "%", "^", "&", "*", "(", ")", "<"},
+        {"Q", "W", "E", "R", "T", "Y", "U", "I", "O", "P", ">"},
+        {"A", "S", "D", "F", "G", "H", "J", "K", "L", ".", "~"},
+        {"Z", "X", "C", "V", "B", "N", "M", ",", "?", " ", " "}
+    };
+
+    static constexpr const char* ENG_KEYBOARD_LAYOUT_SYMBOLS[KEYBOARD_ROWS][KEYBOARD_COLS] = {
+        {"!", "@", "#", "$", "%", "^", "&", "*", "(", ")", "<"},
+        {"`", "~", "|", "(", ")", "{", "}", "[", "]", "\\", ">"},
+        {";", ":", "'", "\"", "<", ">", ",", ".", "/", " ", "~"},
+        {"-", "_", "=", "+", "*", "&", " ", ",", "?", " ", " "}
+    };
+
+
+    const KeyboardRow* getCurrentLayout() {
         switch (currentKeyboardState) {
             case UPPERCASE:
                 return ENG_KEYBOARD_LAYOUT_UPPER;
@@ -24,17 +46,18 @@ namespace keyboards {
 
         M5.Display.fillRect(0, startY, EPD_WIDTH, KEYBOARD_ROWS * keyHeight, TFT_WHITE);
 
-        const String (*currentLayout)[KEYBOARD_COLS] = getCurrentLayout();
+        const KeyboardRow* currentLayout = getCurrentLayout();
         for (int row = 0; row < KEYBOARD_ROWS; ++row) {
             for (int col = 0; col < KEYBOARD_COLS; ++col) {
                 int x = col * keyWidth;
                 int y = startY + row * keyHeight;
 
-                M5.Display.setCursor(x + (keyWidth - M5.Display.textWidth(currentLayout[row][col].c_str())) / 2,
+                M5.Display.setCursor(x + (keyWidth - M5.Display.textWidth(currentLayout[row][col])) / 2,
                                    y + (keyHeight - M5.Display.fontHeight()) / 2);
                 M5.Display.setTextColor(TFT_BLACK);
                 M5.Display.setTextSize(2);
                 M5.Display.print(currentLayout[row][col]);
+                hit_index::add(x, y, keyWidth, keyHeight, hit_index::HIT_KEY, row * KEYBOARD_COLS + col);
             }
         }
     }
@@ -49,19 +72,9 @@ namespace keyboards {
         }
     }
 
-    String getKeyFromTouch(int x, int y) {
-        const int keyWidth = EPD_WIDTH / KEYBOARD_COLS;
-        const int keyHeight = 60;
-        const int startY = EPD_HEIGHT - (KEYBOARD_ROWS * keyHeight) - 60;
-
-        if (y < startY) return "";
-
-        int row = (y - startY) / keyHeight;
-        int col = x / keyWidth;
-
-        if (row >= 0 && row < KEYBOARD_ROWS && col >= 0 && col < KEYBOARD_COLS) {
-            return getCurrentLayout()[row][col];
-        }
-        return "";
+    const char* getKeyFromTouch(int x, int y) {
+        const hit_index::HitTarget* hit = hit_index::lookup(x, y);
+        if (!hit || hit->action != hit_index::HIT_KEY) return "";
+        return getCurrentLayout()[hit->param / KEYBOARD_COLS][hit->param % KEYBOARD_COLS];
     }
 }
\ No newline at end of file
@@ -1,7 +1,15 @@
 #include "numbers_keyboard.h"
 #include "../ui.h"
+#include "../hit_index.h"
 
 namespace keyboards {
+    static constexpr const char* NUMBERS_KEYBOARD_LAYOUT[NUMBERS_KEYBOARD_ROWS][NUMBERS_KEYBOARD_COLS] = {
+        {"1", "2", "3"},
+        {"4", "5", "6"},
+        {"7", "8", "9"},
+        {"<", "0", "."}
+    };
+
     void drawNumbersKeyboard() {
         const int keyWidth = EPD_WIDTH / NUMBERS_KEYBOARD_COLS;
         const int keyHeight = 80;
@@ -16,28 +24,19 @@ namespace keyboards {
 
                 M5.Display.drawRect(x, y, keyWidth, keyHeight, TFT_BLACK);
                 
-                M5.Display.setCursor(x + (keyWidth - M5.Display.textWidth(NUMBERS_KEYBOARD_LAYOUT[row][col].c_str())) / 2,
+                M5.Display.setCursor(x + (keyWidth - M5.Display.textWidth(NUMBERS_KEYBOARD_LAYOUT[row][col])) / 2,
                                    y + (keyHeight - M5.Display.fontHeight()) / 2);
                 M5.Display.setTextColor(TFT_BLACK);
                 M5.Display.setTextSize(3);
                 M5.Display.print(NUMBERS_KEYBOARD_LAYOUT[row][col]);
+                hit_index::add(x, y, keyWidth, keyHeight, hit_index::HIT_NUMBER_KEY, row * NUMBERS_KEYBOARD_COLS + col);
             }
         }
     }
 
-    String getNumberKeyFromTouch(int x, int y) {
-        const int keyWidth = EPD_WIDTH / NUMBERS_KEYBOARD_COLS;
-        const int keyHeight = 80;
-        const int startY = EPD_HEIGHT - (NUMBERS_KEYBOARD_ROWS * keyHeight) - 60;
-
-        if (y < startY) return "";
-
-        int row = (y - startY) / keyHeight;
-        int col = x / keyWidth;
-
-        if (row >= 0 && row < NUMBERS_KEYBOARD_ROWS && col >= 0 && col < NUMBERS_KEYBOARD_COLS) {
-            return NUMBERS_KEYBOARD_LAYOUT[row][col];
-        }
-        return "";
+    const char* getNumberKeyFromTouch(int x, int y) {
+        const hit_index::HitTarget* hit = hit_index::lookup(x, y);
+        if (!hit || hit->action != hit_index::HIT_NUMBER_KEY) return "";
+        return NUMBERS_KEYBOARD_LAYOUT[hit->param / NUMBERS_KEYBOARD_COLS][hit->param % NUMBERS_KEYBOARD_COLS];
     }
 }
\ No newline at end of file
@@ -7,16 +7,10 @@
 namespace keyboards {
     static const int NUMBERS_KEYBOARD_ROWS = 4;
     static const int NUMBERS_KEYBOARD_COLS = 3;
-    
-    const String NUMBERS_KEYBOARD_LAYOUT[NUMBERS_KEYBOARD_ROWS][NUMBERS_KEYBOARD_COLS] = {
-        {"1", "2", "3"},
-        {"4", "5", "6"},
-        {"7", "8", "9"},
-        {"<", "0", "."}
-    };
 
     void drawNumbersKeyboard();
-    String getNumberKeyFromTouch(int x, int y);
+    // Key label under the touch, or "" when no key was hit.
+    const char* getNumberKeyFromTouch(int x, int y);
 }
 
 #endif
\ No newline at end of file
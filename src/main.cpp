@@ -7,43 +7,39 @@
 #include "sdcard.h"
 #include "debug_config.h"
 #include "ui.h"
+#include "screen_registry.h"
+#include "hit_index.h"
 #include "footer.h"
 #include "settings.h"
-#include "screens/wifi_screen.h"
-#include "screens/apps_screen.h"
-#include "screens/games_screen.h"
-#include "keyboards/eng_keyboard.h"
+#include "services/reading_state.h"
+#include "services/idle_scheduler.h"
+#include "services/resume_state.h"
+#include "services/power_telemetry.h"
+#include "services/battery_estimator.h"
+#include "services/serial_console.h"
+#include "services/touch_input.h"
+#include "services/gestures.h"
+#include "services/latency_trace.h"
+#include "services/profiler.h"
+#include "services/heap_telemetry.h"
 #include "sd_gateway.h"
 #include "network/wifi_manager.h"
-#include "apps/text_lang_test/app_screen.h"
-#include "apps/geometry_test/app_screen.h"
-#include "apps/swipe_test/app_screen.h"
-#include "apps/reader/app_screen.h"
-#include "apps/calculator/app_screen.h"
-#include "games/minesweeper/game.h"
-#include "games/sudoku/game.h"
-#include "games/test/game.h"
-#include "screens/games_screen.h"
 
 bool isRendering = false;
 bool ui_needs_update = true;
 unsigned long lastTouchTime = 0;
-const unsigned long TOUCH_DEBOUNCE_DELAY = 300;
-bool previousTouchState = false;
-int lastTouchX = 0, lastTouchY = 0;
+const unsigned long IDLE_WAKE_INTERVAL_MS = 60000;
+const unsigned long PENDING_FLUSH_POLL_MS = 500;
+const int TAP_CELL_SIZE = 40;
+uint32_t lastDownUs = 0;
 
 
-template <typename T>
-T customClamp(T value, T minVal, T maxVal) {
-    return (value < minVal) ? minVal : (value > maxVal) ? maxVal : value;
-}
-
 void setup() {
+    heap_telemetry::begin();
     M5.begin();
     M5.Display.begin();
     Serial.begin(115200);
 
-    M5.Display.fillScreen(TFT_WHITE);
     M5.Display.setRotation(0);
 
 
@@ -54,15 +50,110 @@ void setup() {
     }
 
 
-    Settings settings;
-    WiFiSettings wifiSettings = settings.getWiFiSettings();
+    Settings::getInstance().begin();
+    battery_estimator::begin();
+    WiFiManager::getInstance().autoConnect();
+
+
+    if (resume_state::restore()) {
+        ui_needs_update = false;
+    } else {
+        M5.Display.fillScreen(TFT_WHITE);
+        setupUI();
+        M5.Display.display();
+    }
+    touch_input::begin();
+    gestures::begin();
+    latency_trace::begin();
+    profiler::begin();
+    idle_scheduler::begin();
+    power_telemetry::begin();
+}
+
+// Debounce is per target: a repeat on the same button is dropped, a tap elsewhere is not.
+static uint32_t tapTargetKey(const hit_index::HitTarget* hit, int16_t x, int16_t y) {
+    if (hit) {
+        return ((uint32_t)hit->action << 16) | (uint16_t)hit->param;
+    }
+    return 0x80000000UL | ((uint32_t)(y / TAP_CELL_SIZE) << 8) | (uint32_t)(x / TAP_CELL_SIZE);
+}
 
+// Presses the target under (x, y) in the current frame; returns whether one was hit.
+static bool pressTarget(const ScreenDescriptor& screen, int16_t x, int16_t y, uint32_t timeUs) {
+    const hit_index::HitTarget* hit = hit_index::lookup(x, y);
+    if (!touch_input::acceptTap(tapTargetKey(hit, x, y), timeUs)) {
+        return hit != nullptr;
+    }
+    ui_needs_update = true;
+    if (hit) {
+        hit_index::highlight(*hit);
+    }
 
+    latency_trace::mark(latency_trace::TRACE_DISPATCHED, currentScreen);
+    if (hit && hit->action == hit_index::HIT_FOOTER_BUTTON) {
+        #ifdef DEBUG_TOUCH
+        Serial.printf("%s button pressed\n", footer.getButtons()[hit->param].label);
+        #endif
+        footer.invokeButtonAction(hit->param);
+        isRendering = false;
+        return true;
+    }
+    bool targeted = hit != nullptr;
+    if (screen.handleTouch) {
+        int touchedRow = (hit && hit->action == hit_index::HIT_ROW) ? hit->param : getRowFromY(y);
+        screen.handleTouch(touchedRow, x, y);
+    }
+    isRendering = (screen.flags & SCREEN_HOLD_INPUT) != 0;
+    return targeted;
+}
 
+static void handleTouchDown(const ScreenDescriptor& screen, const touch_input::TouchEvent& event) {
+    lastDownUs = event.timeUs;
+    lastTouchTime = millis();
+    power_telemetry::noteTouch(currentScreen);
+    idle_scheduler::keepAwake((unsigned long)Settings::getInstance().getInt(SETTING_LIGHT_SLEEP_TIMEOUT));
+    if (resume_state::consumeStalePanel()) {
+        latency_trace::beginTouch(event.timeUs, currentScreen);
+        gestures::claim(event.timeUs);
+        renderCurrentScreen();
+        ui_needs_update = true;
+        isRendering = true;
+        return;
+    }
 
-    setupUI();
+    if (screen.flags & SCREEN_TAP_ON_RELEASE) {
+        const hit_index::HitTarget* hit = hit_index::lookup(event.x, event.y);
+        if (!hit || hit->action != hit_index::HIT_FOOTER_BUTTON) return;
+    }
+    latency_trace::beginTouch(event.timeUs, currentScreen);
+    ScreenType pressedOn = currentScreen;
+    // A touch that pressed something is not also a gesture.
+    if (pressTarget(screen, event.x, event.y, event.timeUs) || currentScreen != pressedOn) {
+        gestures::claim(event.timeUs);
+    }
+}
 
-    M5.Display.display();
+// Gestures wait until main has seen the touch-down they started with.
+static void dispatchGestures() {
+    gestures::Gesture gesture;
+    while (!isRendering && gestures::peek(gesture)) {
+        if ((int32_t)(gesture.startUs - lastDownUs) > 0 && touch_input::pending() > 0) return;
+        gestures::next(gesture);
+        const ScreenDescriptor& screen = getScreenDescriptor(currentScreen);
+        uint32_t releasedUs = gesture.startUs + (uint32_t)gesture.durationMs * 1000;
+        if (gesture.type == gestures::GESTURE_TAP && (screen.flags & SCREEN_TAP_ON_RELEASE)) {
+            latency_trace::beginTouch(releasedUs, currentScreen);
+            pressTarget(screen, gesture.x, gesture.y, gesture.startUs);
+            return;
+        }
+        if (screen.handleGesture && (screen.gestureMask & gestures::gestureBit(gesture.type))) {
+            latency_trace::beginTouch(releasedUs, currentScreen);
+            latency_trace::mark(latency_trace::TRACE_DISPATCHED, currentScreen);
+            screen.handleGesture(gesture);
+            ui_needs_update = true;
+            return;
+        }
+    }
 }
 
 void loop() {
@@ -71,20 +162,26 @@ void loop() {
         updateUI();
         ui_needs_update = false;
     }
+    latency_trace::loop();
     sd_gateway::loop();
+    Settings::getInstance().loop();
+    ReadingStateStore::getInstance().loop();
+    serial_console::loop();
+    power_telemetry::loop();
+    battery_estimator::loop();
     
 
-    WiFiManager::getInstance().updateScanResults();
+    WiFiManager::getInstance().loop();
     
 
-    if (currentScreen == GEOMETRY_TEST_SCREEN) {
-        apps_geometry_test::updateAnimation();
+    const ScreenDescriptor& screen = getScreenDescriptor(currentScreen);
+    if (screen.tick) {
+        screen.tick();
     }
-    
 
-    if (currentScreen == SWIPE_TEST_SCREEN) {
-        apps_swipe_test::updateAnimation();
-    }
+    // Sampled even while a frame is rendering so taps made meanwhile stay queued.
+    touch_input::poll();
+    gestures::update();
 
     if (isRendering) {
     
@@ -92,135 +189,31 @@ void loop() {
     }
 
 
-    bool currentTouchState = M5.Display.touch();
-    
-    if (currentTouchState && !isRendering && (millis() - lastTouchTime > TOUCH_DEBOUNCE_DELAY)) {
-        lgfx::touch_point_t tp;
-        if (M5.Display.getTouchRaw(&tp, 1)) {
-            M5.Display.convertRawXY(&tp, 1);
-            int16_t x = tp.x;
-            int16_t y = tp.y;
-            
-            lastTouchX = x;
-            lastTouchY = y;
-            
-            lastTouchTime = millis();
-            if (currentScreen != SWIPE_TEST_SCREEN) {
-                isRendering = true;
-            }
-            ui_needs_update = true;
-            
-
-
-            if (footer.isVisible() && y >= (EPD_HEIGHT - 60) && 
-                currentScreen != MINESWEEPER_GAME_SCREEN && 
-                currentScreen != SUDOKU_GAME_SCREEN && 
-                currentScreen != TEST_GAME_SCREEN) {
-                int buttonCount = footer.getButtonCount();
-                if (buttonCount == 0) return;
-
-                int buttonWidth = EPD_WIDTH / buttonCount;
-                int buttonIndex = x / buttonWidth;
-                buttonIndex = customClamp(buttonIndex, 0, buttonCount - 1);
-
-                if (buttonIndex < footer.getButtonCount()) {
-                    #ifdef DEBUG_TOUCH
-                    Serial.println(footer.getButtons()[buttonIndex].label + " button pressed");
-                    #endif
-                    footer.invokeButtonAction(buttonIndex);
-                }
-                isRendering = false;
-            } else {
-
-                if (currentScreen == FILES_SCREEN) {
-                    int touchedRow = getRowFromY(y);
-                    screens::handleTouch(touchedRow, x, y);
-                }
-
-                else if (currentScreen == MAIN_SCREEN) {
-                    int touchedRow = getRowFromY(y);
-                    if (touchedRow == 5) {
-                        displayMessage("Wi-Fi pressed");
-                        screens::resetWiFiScreen();
-                        currentScreen = WIFI_SCREEN;
-                        renderCurrentScreen();
-                    } else if (touchedRow == 6) {
-                        if (WiFi.status() != WL_CONNECTED) {
-                            displayMessage("Wi-Fi not connected");
-                        } else {
-                            sd_gateway::toggleOrShow();
-                        }
-                        renderCurrentScreen();
-                    } else if (touchedRow == 7) {
-                        displayMessage("Apps pressed");
-                        currentScreen = APPS_SCREEN;
-                        renderCurrentScreen();
-                    } else if (touchedRow == 8) {
-                        displayMessage("Games pressed");
-                        currentScreen = GAMES_SCREEN;
-                        renderCurrentScreen();
-                    }
-                }
-
-                else if (currentScreen == WIFI_SCREEN) {
-                    screens::handleWiFiScreenTouch(x, y);
-                }
-
-                else if (currentScreen == APPS_SCREEN) {
-                    int touchedRow = getRowFromY(y);
-                    if (touchedRow >= 3) {
-                         screens::handleAppsSelection(touchedRow);
-                    }
-                }
-
-                else if (currentScreen == GAMES_SCREEN) {
-                    int touchedRow = getRowFromY(y);
-                    if (touchedRow >= 3) {
-                         handleGamesScreenTouch(touchedRow, x, y);
-                    }
-                    isRendering = false;
-                }
-
-                else if (currentScreen == SWIPE_TEST_SCREEN) {
-                    apps_swipe_test::handleTouch(x, y, true);
-
-                }
-
-                else if (currentScreen == READER_APP_SCREEN) {
-                    int touchedRow = getRowFromY(y);
-                    apps_reader::handleTouch(touchedRow, x, y);
-                    isRendering = false;
-                } else if (currentScreen == CALCULATOR_APP_SCREEN) {
-                    int touchedRow = getRowFromY(y);
-                    apps_calculator::handleTouch(touchedRow, x, y);
-                    isRendering = false;
-                } else if (currentScreen == MINESWEEPER_GAME_SCREEN) {
-                    int touchedRow = getRowFromY(y);
-                    games_minesweeper::handleTouch(touchedRow, x, y);
-                    isRendering = false;
-                } else if (currentScreen == SUDOKU_GAME_SCREEN) {
-                    int touchedRow = getRowFromY(y);
-                    games_sudoku::handleTouch(touchedRow, x, y);
-                    isRendering = false;
-                } else if (currentScreen == TEST_GAME_SCREEN) {
-                    int touchedRow = getRowFromY(y);
-                    games_test::handleTouch(touchedRow, x, y);
-                    isRendering = false;
-                } else {
-                    isRendering = false;
-                }
-            }
-            
-
+    // A press ends the drain: later events must hit-test against the frame it produces.
+    touch_input::TouchEvent event;
+    while (!isRendering && touch_input::next(event)) {
+        if (!event.primary) continue;
+        if (event.type == touch_input::TOUCH_DOWN) {
+            handleTouchDown(screen, event);
+            break;
+        } else if (event.type == touch_input::TOUCH_UP && screen.handleRelease) {
+            screen.handleRelease(getRowFromY(event.y), event.x, event.y);
+            isRendering = false;
         }
-
     }
-    
-
-    if (previousTouchState && !currentTouchState && currentScreen == SWIPE_TEST_SCREEN) {
-        apps_swipe_test::handleTouch(lastTouchX, lastTouchY, false);
-        isRendering = false;
+    dispatchGestures();
+
+    WiFiManager& wifiManager = WiFiManager::getInstance();
+    WiFiManager::ConnectionState wifiState = wifiManager.getState();
+    bool busy = touch_input::isTouching() || touch_input::pending() > 0 || gestures::pending() > 0 || ui_needs_update || isRendering ||
+                getScreenDescriptor(currentScreen).tick != nullptr ||
+                sd_gateway::isActive() || wifiManager.isScanning();
+    bool radioActive = wifiState != WiFiManager::ConnectionState::IDLE &&
+                       wifiState != WiFiManager::ConnectionState::FAILED;
+    unsigned long deepSleepMin = (unsigned long)Settings::getInstance().getInt(SETTING_DEEP_SLEEP_TIMEOUT);
+    if (deepSleepMin > 0 && !busy && millis() - lastTouchTime > deepSleepMin * 60000UL) {
+        resume_state::suspend();
     }
-    
-    previousTouchState = currentTouchState;
+    bool flushPending = Settings::getInstance().isDirty() || ReadingStateStore::getInstance().hasPendingWrites();
+    idle_scheduler::idle(busy, radioActive, flushPending ? PENDING_FLUSH_POLL_MS : IDLE_WAKE_INTERVAL_MS);
 }
@@ -0,0 +1,223 @@
+#include "credential_store.h"
+#include <Preferences.h>
+#include "../crc32.h"
+#include "../settings.h"
+#include "../debug_config.h"
+
+namespace {
+    const char* NVS_NAMESPACE = "hi5wifi";
+    const char* NVS_PROFILES_KEY = "profiles";
+    const uint8_t BLOB_MAGIC_0 = 'W';
+    const uint8_t BLOB_MAGIC_1 = 'P';
+    const uint8_t BLOB_VERSION = 1;
+    const size_t BLOB_HEADER = 4;
+    const size_t BLOB_CAPACITY = BLOB_HEADER + CredentialStore::MAX_PROFILES * sizeof(WiFiProfile) + 4;
+    const int32_t PRIORITY_WEIGHT_DB = 10;
+    const int32_t FAILURE_PENALTY_DB = 3;
+    const uint16_t MAX_FAILURE_PENALTY = 5;
+}
+
+bool CredentialStore::begin() {
+    if (_loaded) return true;
+    _loaded = true;
+    if (!_load()) {
+        _count = 0;
+    }
+    if (_count == 0) {
+        _importLegacy();
+    }
+    for (int i = 0; i < _count; ++i) {
+        if (_profiles[i].lastUsed > _useCounter) _useCounter = _profiles[i].lastUsed;
+    }
+    return true;
+}
+
+void CredentialStore::_importLegacy() {
+    Settings& settings = Settings::getInstance();
+    String lastSSID = settings.getLastConnectedSSID();
+    String lastPassword = settings.getLastConnectedPassword();
+    WiFiSettings wifi = settings.getWiFiSettings();
+    bool imported = false;
+    if (!lastSSID.isEmpty() && !lastPassword.isEmpty()) {
+        imported = upsert(lastSSID, lastPassword) || imported;
+    }
+    if (!wifi.ssid.isEmpty() && !wifi.password.isEmpty() && !find(wifi.ssid)) {
+        imported = upsert(wifi.ssid, wifi.password) || imported;
+    }
+#ifdef DEBUG_WIFI_TOUCH
+    if (imported) Serial.printf("[WiFi] imported %d legacy profile(s)\n", _count);
+#endif
+}
+
+bool CredentialStore::_load() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) return false;
+    size_t length = prefs.getBytesLength(NVS_PROFILES_KEY);
+    if (length < BLOB_HEADER + 4 || length > BLOB_CAPACITY) {
+        prefs.end();
+        return false;
+    }
+    uint8_t blob[BLOB_CAPACITY];
+    prefs.getBytes(NVS_PROFILES_KEY, blob, length);
+    prefs.end();
+
+    uint32_t storedCrc = (uint32_t)blob[length - 4] | ((uint32_t)blob[length - 3] << 8) |
+                         ((uint32_t)blob[length - 2] << 16) | ((uint32_t)blob[length - 1] << 24);
+    if (blob[0] != BLOB_MAGIC_0 || blob[1] != BLOB_MAGIC_1 || blob[2] != BLOB_VERSION) return false;
+    if (crc32(blob, length - 4) != storedCrc) return false;
+    int count = blob[3];
+    if (count > MAX_PROFILES || BLOB_HEADER + count * sizeof(WiFiProfile) + 4 != length) return false;
+
+    memcpy(_profiles, blob + BLOB_HEADER, count * sizeof(WiFiProfile));
+    for (int i = 0; i < count; ++i) {
+        _profiles[i].ssid[sizeof(_profiles[i].ssid) - 1] = '\0';
+        _profiles[i].password[sizeof(_profiles[i].password) - 1] = '\0';
+    }
+    _count = count;
+    return true;
+}
+
+bool CredentialStore::_save() {
+    uint8_t blob[BLOB_CAPACITY];
+    blob[0] = BLOB_MAGIC_0;
+    blob[1] = BLOB_MAGIC_1;
+    blob[2] = BLOB_VERSION;
+    blob[3] = (uint8_t)_count;
+    size_t pos = BLOB_HEADER;
+    memcpy(blob + pos, _profiles, _count * sizeof(WiFiProfile));
+    pos += _count * sizeof(WiFiProfile);
+    uint32_t crc = crc32(blob, pos);
+    for (int i = 0; i < 4; ++i) {
+        blob[pos++] = (uint8_t)(crc >> (8 * i));
+    }
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) return false;
+    bool ok = prefs.putBytes(NVS_PROFILES_KEY, blob, pos) == pos;
+    prefs.end();
+    return ok;
+}
+
+const WiFiProfile* CredentialStore::get(int index) const {
+    if (index < 0 || index >= _count) return nullptr;
+    return &_profiles[index];
+}
+
+const WiFiProfile* CredentialStore::find(TextSpan ssid) const {
+    for (int i = 0; i < _count; ++i) {
+        if (ssid == TextSpan(_profiles[i].ssid)) return &_profiles[i];
+    }
+    return nullptr;
+}
+
+WiFiProfile* CredentialStore::_find(TextSpan ssid) {
+    return const_cast<WiFiProfile*>(static_cast<const CredentialStore*>(this)->find(ssid));
+}
+
+bool CredentialStore::upsert(const String& ssid, const String& password) {
+    if (ssid.isEmpty() || ssid.length() >= sizeof(WiFiProfile::ssid) ||
+        password.length() >= sizeof(WiFiProfile::password)) {
+        return false;
+    }
+
+    WiFiProfile* profile = _find(ssid);
+    if (profile) {
+        if (password == profile->password) return true;
+    } else {
+        if (_count < MAX_PROFILES) {
+            profile = &_profiles[_count++];
+        } else {
+            profile = &_profiles[0];
+            for (int i = 1; i < _count; ++i) {
+                if (_profiles[i].lastUsed < profile->lastUsed) profile = &_profiles[i];
+            }
+        }
+        memset(profile, 0, sizeof(*profile));
+        strncpy(profile->ssid, ssid.c_str(), sizeof(profile->ssid) - 1);
+        profile->priority = DEFAULT_PRIORITY;
+        profile->lastUsed = ++_useCounter;
+    }
+    memset(profile->password, 0, sizeof(profile->password));
+    strncpy(profile->password, password.c_str(), sizeof(profile->password) - 1);
+    profile->failCount = 0;
+    return _save();
+}
+
+bool CredentialStore::remove(const String& ssid) {
+    WiFiProfile* profile = _find(ssid);
+    if (!profile) return false;
+    int index = profile - _profiles;
+    for (int i = index; i < _count - 1; ++i) {
+        _profiles[i] = _profiles[i + 1];
+    }
+    _count--;
+    return _save();
+}
+
+bool CredentialStore::setPriority(const String& ssid, int8_t priority) {
+    WiFiProfile* profile = _find(ssid);
+    if (!profile) return false;
+    if (profile->priority == priority) return true;
+    profile->priority = priority;
+    return _save();
+}
+
+uint16_t CredentialStore::knownChannels() const {
+    uint16_t channels = 0;
+    for (int i = 0; i < _count; ++i) {
+        if (_profiles[i].channel > 0 && _profiles[i].channel < 16) {
+            channels |= (1 << _profiles[i].channel);
+        }
+    }
+    return channels;
+}
+
+bool CredentialStore::allChannelsKnown() const {
+    for (int i = 0; i < _count; ++i) {
+        if (_profiles[i].channel == 0) return false;
+    }
+    return _count > 0;
+}
+
+const WiFiProfile* CredentialStore::selectBest(const ScanNetwork* networks, int networksCount, const ScanNetwork** match) const {
+    const WiFiProfile* best = nullptr;
+    int32_t bestScore = 0;
+    for (int i = 0; i < networksCount; ++i) {
+        const WiFiProfile* profile = find(networks[i].ssid);
+        if (!profile) continue;
+        uint16_t failures = profile->failCount < MAX_FAILURE_PENALTY ? profile->failCount : MAX_FAILURE_PENALTY;
+        int32_t score = networks[i].rssi + PRIORITY_WEIGHT_DB * profile->priority - FAILURE_PENALTY_DB * failures;
+        if (!best || score > bestScore) {
+            best = profile;
+            bestScore = score;
+            if (match) *match = &networks[i];
+        }
+    }
+    return best;
+}
+
+void CredentialStore::recordConnect(const String& ssid, const uint8_t* bssid, uint8_t channel, uint32_t connectMs) {
+    WiFiProfile* profile = _find(ssid);
+    if (!profile) return;
+    memcpy(profile->bssid, bssid, sizeof(profile->bssid));
+    profile->channel = channel;
+    profile->lastConnectMs = connectMs;
+    profile->avgConnectMs = profile->connectCount == 0 ? connectMs
+                          : (profile->avgConnectMs * 3 + connectMs) / 4;
+    if (profile->connectCount < UINT16_MAX) profile->connectCount++;
+    profile->failCount = 0;
+    profile->lastUsed = ++_useCounter;
+    _save();
+#ifdef DEBUG_WIFI_TOUCH
+    Serial.printf("[WiFi] %s: connect %lu ms, avg %lu ms over %u connects\n", profile->ssid,
+                  (unsigned long)connectMs, (unsigned long)profile->avgConnectMs, (unsigned)profile->connectCount);
+#endif
+}
+
+void CredentialStore::recordFailure(const String& ssid) {
+    WiFiProfile* profile = _find(ssid);
+    if (!profile) return;
+    if (profile->failCount < UINT16_MAX) profile->failCount++;
+    profile->channel = 0;
+    _save();
+}
@@ -0,0 +1,60 @@
+#ifndef CREDENTIAL_STORE_H
+#define CREDENTIAL_STORE_H
+
+#include <Arduino.h>
+#include "scan_cache.h"
+
+struct WiFiProfile {
+    char ssid[33];
+    char password[65];
+    int8_t priority;
+    uint8_t channel;
+    uint8_t bssid[6];
+    uint16_t connectCount;
+    uint16_t failCount;
+    uint32_t lastConnectMs;
+    uint32_t avgConnectMs;
+    uint32_t lastUsed;
+};
+
+class CredentialStore {
+public:
+    static const int MAX_PROFILES = 8;
+    static const int8_t DEFAULT_PRIORITY = 0;
+
+    static CredentialStore& getInstance() {
+        static CredentialStore instance;
+        return instance;
+    }
+
+    bool begin();
+    int count() const { return _count; }
+    const WiFiProfile* get(int index) const;
+    const WiFiProfile* find(TextSpan ssid) const;
+    bool upsert(const String& ssid, const String& password);
+    bool remove(const String& ssid);
+    bool setPriority(const String& ssid, int8_t priority);
+    uint16_t knownChannels() const;
+    bool allChannelsKnown() const;
+    const WiFiProfile* selectBest(const ScanNetwork* networks, int networksCount, const ScanNetwork** match) const;
+
+    void recordConnect(const String& ssid, const uint8_t* bssid, uint8_t channel, uint32_t connectMs);
+    void recordFailure(const String& ssid);
+
+private:
+    CredentialStore() = default;
+    CredentialStore(const CredentialStore&) = delete;
+    CredentialStore& operator=(const CredentialStore&) = delete;
+
+    WiFiProfile* _find(TextSpan ssid);
+    void _importLegacy();
+    bool _load();
+    bool _save();
+
+    WiFiProfile _profiles[MAX_PROFILES];
+    int _count = 0;
+    bool _loaded = false;
+    uint32_t _useCounter = 0;
+};
+
+#endif // CREDENTIAL_STORE_H
@@ -0,0 +1,147 @@
+#include "scan_cache.h"
+#include <algorithm>
+
+namespace {
+    const float RSSI_SMOOTHING = 0.3f;
+    const unsigned long STALE_AFTER_MS = 3UL * 60UL * 1000UL;
+    const unsigned long FRESH_FOR_MS = 60UL * 1000UL;
+    const uint8_t MAX_MISSED_SCANS = 2;
+}
+
+void ScanCache::beginScan(uint8_t channel) {
+    _scanChannel = channel;
+    for (int i = 0; i < MAX_ENTRIES; ++i) {
+        _entries[i].seenThisScan = false;
+    }
+}
+
+void ScanCache::add(TextSpan ssid, const uint8_t* bssid, int32_t rssi, uint8_t channel, unsigned long now) {
+    if (ssid.empty()) return;
+
+    Entry* slot = nullptr;
+    Entry* weakest = nullptr;
+    for (int i = 0; i < MAX_ENTRIES; ++i) {
+        Entry& entry = _entries[i];
+        if (!entry.used) {
+            if (!slot) slot = &entry;
+            continue;
+        }
+        if (memcmp(entry.bssid, bssid, sizeof(entry.bssid)) == 0) {
+            entry.rssi += RSSI_SMOOTHING * ((float)rssi - entry.rssi);
+            entry.ssid = ssid;
+            entry.channel = channel;
+            entry.lastSeen = now;
+            entry.missedScans = 0;
+            entry.seenThisScan = true;
+            return;
+        }
+        if (!weakest || entry.rssi < weakest->rssi) weakest = &entry;
+    }
+
+    if (!slot) {
+        if (!weakest || weakest->rssi >= (float)rssi) return;
+        slot = weakest;
+    }
+    slot->ssid = ssid;
+    memcpy(slot->bssid, bssid, sizeof(slot->bssid));
+    slot->channel = channel;
+    slot->rssi = (float)rssi;
+    slot->lastSeen = now;
+    slot->missedScans = 0;
+    slot->seenThisScan = true;
+    slot->used = true;
+}
+
+void ScanCache::endScan(unsigned long now) {
+    for (int i = 0; i < MAX_ENTRIES; ++i) {
+        Entry& entry = _entries[i];
+        if (!entry.used) continue;
+        bool covered = _scanChannel == 0 || entry.channel == _scanChannel;
+        if (covered && !entry.seenThisScan) entry.missedScans++;
+        if (entry.missedScans >= MAX_MISSED_SCANS || now - entry.lastSeen > STALE_AFTER_MS) {
+            entry.used = false;
+            entry.ssid.clear();
+        }
+    }
+    if (_scanChannel == 0) {
+        _lastFullScan = now;
+        _hasFullScan = true;
+    }
+}
+
+int ScanCache::snapshot(ScanNetwork* out, int maxCount) const {
+    const Entry* ordered[MAX_ENTRIES];
+    int count = 0;
+    for (int i = 0; i < MAX_ENTRIES; ++i) {
+        if (_entries[i].used) ordered[count++] = &_entries[i];
+    }
+    std::sort(ordered, ordered + count, [](const Entry* a, const Entry* b) {
+        return a->rssi > b->rssi;
+    });
+
+    int written = 0;
+    for (int i = 0; i < count; ++i) {
+        const Entry& entry = *ordered[i];
+        bool duplicate = false;
+        for (int j = 0; j < written; ++j) {
+            if (out[j].ssid == entry.ssid) {
+                out[j].apCount++;
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate || written >= maxCount) continue;
+        ScanNetwork& network = out[written++];
+        network.ssid = entry.ssid;
+        network.rssi = (int32_t)(entry.rssi - 0.5f);
+        network.channel = entry.channel;
+        memcpy(network.bssid, entry.bssid, sizeof(network.bssid));
+        network.apCount = 1;
+    }
+    return written;
+}
+
+uint16_t ScanCache::knownChannels() const {
+    uint16_t channels = 0;
+    for (int i = 0; i < MAX_ENTRIES; ++i) {
+        if (_entries[i].used && _entries[i].channel > 0 && _entries[i].channel < 16) {
+            channels |= (1 << _entries[i].channel);
+        }
+    }
+    return channels;
+}
+
+bool ScanCache::isFresh(unsigned long now) const {
+    return _hasFullScan && now - _lastFullScan < FRESH_FOR_MS && size() > 0;
+}
+
+bool ScanCache::findBySSID(TextSpan ssid, ScanNetwork& out) const {
+    const Entry* best = nullptr;
+    for (int i = 0; i < MAX_ENTRIES; ++i) {
+        const Entry& entry = _entries[i];
+        if (entry.used && entry.ssid == ssid && (!best || entry.rssi > best->rssi)) best = &entry;
+    }
+    if (!best) return false;
+    out.ssid = best->ssid;
+    out.rssi = (int32_t)(best->rssi - 0.5f);
+    out.channel = best->channel;
+    memcpy(out.bssid, best->bssid, sizeof(out.bssid));
+    out.apCount = 1;
+    return true;
+}
+
+int ScanCache::size() const {
+    int count = 0;
+    for (int i = 0; i < MAX_ENTRIES; ++i) {
+        if (_entries[i].used) count++;
+    }
+    return count;
+}
+
+void ScanCache::clear() {
+    for (int i = 0; i < MAX_ENTRIES; ++i) {
+        _entries[i].used = false;
+        _entries[i].ssid.clear();
+    }
+    _hasFullScan = false;
+}
@@ -0,0 +1,50 @@
+#ifndef SCAN_CACHE_H
+#define SCAN_CACHE_H
+
+#include <Arduino.h>
+#include "../text_types.h"
+
+// 32-byte SSID plus terminator.
+typedef InlineString<33> SsidString;
+
+struct ScanNetwork {
+    SsidString ssid;
+    int32_t rssi;
+    uint8_t channel;
+    uint8_t bssid[6];
+    uint8_t apCount;
+};
+
+class ScanCache {
+public:
+    static const int MAX_ENTRIES = 32;
+
+    void beginScan(uint8_t channel);
+    void add(TextSpan ssid, const uint8_t* bssid, int32_t rssi, uint8_t channel, unsigned long now);
+    void endScan(unsigned long now);
+    int snapshot(ScanNetwork* out, int maxCount) const;
+    uint16_t knownChannels() const;
+    bool isFresh(unsigned long now) const;
+    bool findBySSID(TextSpan ssid, ScanNetwork& out) const;
+    int size() const;
+    void clear();
+
+private:
+    struct Entry {
+        SsidString ssid;
+        uint8_t bssid[6] = {};
+        uint8_t channel = 0;
+        float rssi = 0.0f;
+        unsigned long lastSeen = 0;
+        uint8_t missedScans = 0;
+        bool seenThisScan = false;
+        bool used = false;
+    };
+
+    Entry _entries[MAX_ENTRIES];
+    uint8_t _scanChannel = 0;
+    unsigned long _lastFullScan = 0;
+    bool _hasFullScan = false;
+};
+
+#endif // SCAN_CACHE_H
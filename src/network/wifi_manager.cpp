@@ -1,24 +1,280 @@
 #include "wifi_manager.h"
+#include <Preferences.h>
+#include <time.h>
+#include "credential_store.h"
+#include "../debug_config.h"
+#include "../services/heap_telemetry.h"
 
-bool WiFiManager::connect(const String& ssid, const String& password) {
+namespace {
+    const char* NVS_NAMESPACE = "hi5wifi";
+    const char* NVS_CACHE_KEY = "fast";
+    const uint8_t REASON_TIMEOUT = 0;
+    const uint8_t REASON_AUTH_FAIL = 202;
+    const uint8_t REASON_NO_AP_FOUND = 201;
+    // A wrong WPA2 key usually surfaces as a handshake timeout rather than AUTH_FAIL.
+    const uint8_t REASON_4WAY_HANDSHAKE_TIMEOUT = 15;
+    const uint8_t REASON_HANDSHAKE_TIMEOUT = 204;
+    // Reported for our own WiFi.disconnect(), which connect() and _attemptFailed() call
+    // right before the next attempt starts.
+    const uint8_t REASON_ASSOC_LEAVE = 8;
+    const time_t MIN_VALID_EPOCH = 1600000000;
+}
+
+void WiFiManager::_onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+    WiFiManager& self = getInstance();
+    if (event == ARDUINO_EVENT_WIFI_SCAN_DONE) {
+        self._scanDone.store(true);
+        return;
+    }
+    uint8_t head = self._eventHead.load();
+    uint8_t next = (head + 1) % EVENT_QUEUE_SIZE;
+    if (next == self._eventTail.load()) return;
+
+    PendingEvent& slot = self._events[head];
+    memset(&slot, 0, sizeof(slot));
+    slot.type = (uint8_t)event;
+    if (event == ARDUINO_EVENT_WIFI_STA_CONNECTED) {
+        memcpy(slot.bssid, info.wifi_sta_connected.bssid, sizeof(slot.bssid));
+        slot.channel = info.wifi_sta_connected.channel;
+    } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+        slot.reason = info.wifi_sta_disconnected.reason;
+    } else if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+        slot.ip = info.got_ip.ip_info.ip.addr;
+        slot.subnet = info.got_ip.ip_info.netmask.addr;
+        slot.gateway = info.got_ip.ip_info.gw.addr;
+    }
+    self._eventHead.store(next);
+}
+
+void WiFiManager::_ensureStarted() {
+    if (_started) return;
+    _started = true;
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false);
+    WiFi.onEvent(_onWiFiEvent, ARDUINO_EVENT_WIFI_STA_CONNECTED);
+    WiFi.onEvent(_onWiFiEvent, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    WiFi.onEvent(_onWiFiEvent, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFi.onEvent(_onWiFiEvent, ARDUINO_EVENT_WIFI_SCAN_DONE);
+    if (WiFi.getMode() != WIFI_STA) {
+        WiFi.mode(WIFI_STA);
+    }
+}
+
+void WiFiManager::_loadCache() {
+    if (_cacheLoaded) return;
+    _cacheLoaded = true;
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) return;
+    if (prefs.getBytesLength(NVS_CACHE_KEY) == sizeof(_cache)) {
+        prefs.getBytes(NVS_CACHE_KEY, &_cache, sizeof(_cache));
+        _cache.ssid[sizeof(_cache.ssid) - 1] = '\0';
+    }
+    prefs.end();
+}
+
+void WiFiManager::_saveCache() {
+    // A connect that reused the cached lease never asked DHCP, so the lease keeps its
+    // original stamp and expires LEASE_REUSE_S after the last real DHCP exchange.
+    uint32_t leaseEpoch = _cache.leaseEpoch;
+    bool reusedLease = _usedCachedLease && _targetSSID == _cache.ssid;
+    memset(&_cache, 0, sizeof(_cache));
+    strncpy(_cache.ssid, _targetSSID.c_str(), sizeof(_cache.ssid) - 1);
+    memcpy(_cache.bssid, _connectedBssid, sizeof(_cache.bssid));
+    _cache.channel = _connectedChannel;
+    _cache.ip = (uint32_t)WiFi.localIP();
+    _cache.gateway = (uint32_t)WiFi.gatewayIP();
+    _cache.subnet = (uint32_t)WiFi.subnetMask();
+    _cache.dns = (uint32_t)WiFi.dnsIP();
+    if (reusedLease) {
+        _cache.leaseEpoch = leaseEpoch;
+    } else {
+        time_t now = time(nullptr);
+        _cache.leaseEpoch = now >= MIN_VALID_EPOCH ? (uint32_t)now : 0;
+    }
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) return;
+    prefs.putBytes(NVS_CACHE_KEY, &_cache, sizeof(_cache));
+    prefs.end();
+}
+
+bool WiFiManager::connect(const String& ssid, const String& password, uint8_t channel, const uint8_t* bssid) {
     if (ssid.isEmpty()) return false;
+    _ensureStarted();
+    _loadCache();
+    _autoConnectPending = false;
+
+    _hintChannel = 0;
+    memset(_hintBssid, 0, sizeof(_hintBssid));
+    const WiFiProfile* profile = CredentialStore::getInstance().find(ssid);
+    if (channel != 0 && bssid) {
+        _hintChannel = channel;
+        memcpy(_hintBssid, bssid, sizeof(_hintBssid));
+    } else if (profile && profile->channel != 0) {
+        _hintChannel = profile->channel;
+        memcpy(_hintBssid, profile->bssid, sizeof(_hintBssid));
+    }
+
+    if (_state == ConnectionState::CONNECTED && ssid == _targetSSID) {
+        _setState(ConnectionState::CONNECTED);
+        return true;
+    }
+    if (_state != ConnectionState::IDLE) {
+        WiFi.disconnect();
+    }
 
+    _targetSSID = ssid;
+    _targetPassword = password;
+    _attempts = 0;
+    _fastPathFailed = false;
+    _lastFailureReason = REASON_TIMEOUT;
+    _connectStart = millis();
+    _beginAttempt();
+    return true;
+}
+
+void WiFiManager::_beginAttempt() {
+    bool cacheMatches = !_fastPathFailed && _cache.channel != 0 && _targetSSID == _cache.ssid;
+    bool useHint = !_fastPathFailed && !cacheMatches && _hintChannel != 0;
+    _usedFastPath = cacheMatches || useHint;
+
+    time_t now = time(nullptr);
+    bool leaseFresh = cacheMatches && _cache.ip != 0 && _cache.leaseEpoch != 0 &&
+                      now >= MIN_VALID_EPOCH && (uint32_t)now - _cache.leaseEpoch < LEASE_REUSE_S;
+    _usedCachedLease = leaseFresh;
+    if (leaseFresh) {
+        WiFi.config(IPAddress(_cache.ip), IPAddress(_cache.gateway), IPAddress(_cache.subnet), IPAddress(_cache.dns));
+    } else {
+        WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+    }
+
+    if (cacheMatches) {
+        WiFi.begin(_targetSSID.c_str(), _targetPassword.c_str(), _cache.channel, _cache.bssid);
+    } else if (useHint) {
+        WiFi.begin(_targetSSID.c_str(), _targetPassword.c_str(), _hintChannel, _hintBssid);
+    } else {
+        WiFi.begin(_targetSSID.c_str(), _targetPassword.c_str());
+    }
+    _attemptStart = millis();
+#ifdef DEBUG_WIFI_TOUCH
+    Serial.printf("[WiFi] attempt %u to %s (%s%s)\n", (unsigned)(_attempts + 1), _targetSSID.c_str(),
+                  _usedFastPath ? "cached BSSID" : "full scan", leaseFresh ? ", cached lease" : "");
+#endif
+    _setState(ConnectionState::CONNECTING);
+}
+
+void WiFiManager::_attemptFailed(uint8_t reason) {
     WiFi.disconnect();
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid.c_str(), password.c_str());
+    if (_usedFastPath) {
+        _fastPathFailed = true;
+    }
+    _attempts++;
+    _lastFailureReason = reason;
+#ifdef DEBUG_WIFI_TOUCH
+    Serial.printf("[WiFi] attempt %u failed, reason %u\n", (unsigned)_attempts, (unsigned)reason);
+#endif
+    bool retryable = reason != REASON_AUTH_FAIL || _usedFastPath;
+    if (!retryable || _attempts >= MAX_ATTEMPTS) {
+        CredentialStore::getInstance().recordFailure(_targetSSID);
+        _setState(ConnectionState::FAILED);
+        return;
+    }
+    bool immediate = _usedFastPath && (reason == REASON_NO_AP_FOUND || reason == REASON_TIMEOUT) && _attempts == 1;
+    unsigned long backoff = BACKOFF_BASE_MS << (_attempts - 1);
+    _retryDelay = immediate ? 0 : (backoff > BACKOFF_MAX_MS ? BACKOFF_MAX_MS : backoff);
+    _retryStart = millis();
+    _setState(ConnectionState::WAITING_RETRY);
+}
 
-    unsigned long startTime = millis();
-    while (millis() - startTime < 5000) {
-        if (WiFi.status() == WL_CONNECTED) {
-            return true;
-        }
-        yield();
+bool WiFiManager::failedOnCredentials() const {
+    return _state == ConnectionState::FAILED &&
+           (_lastFailureReason == REASON_AUTH_FAIL || _lastFailureReason == REASON_4WAY_HANDSHAKE_TIMEOUT ||
+            _lastFailureReason == REASON_HANDSHAKE_TIMEOUT);
+}
+
+void WiFiManager::_setState(ConnectionState state) {
+    _state = state;
+    if (_onConnectionStateChanged) {
+        _onConnectionStateChanged(state);
     }
+}
 
-    return false;
+unsigned long WiFiManager::getRetryInMs() const {
+    if (_state != ConnectionState::WAITING_RETRY) return 0;
+    unsigned long elapsed = millis() - _retryStart;
+    return elapsed >= _retryDelay ? 0 : _retryDelay - elapsed;
+}
+
+void WiFiManager::_drainEvents() {
+    while (_eventTail.load() != _eventHead.load()) {
+        uint8_t tail = _eventTail.load();
+        PendingEvent event = _events[tail];
+        _eventTail.store((tail + 1) % EVENT_QUEUE_SIZE);
+        _handleEvent(event);
+    }
+}
+
+void WiFiManager::_handleEvent(const PendingEvent& event) {
+    switch (event.type) {
+        case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+            memcpy(_connectedBssid, event.bssid, sizeof(_connectedBssid));
+            _connectedChannel = event.channel;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            if (_state == ConnectionState::CONNECTING) {
+                _lastConnectMs = millis() - _connectStart;
+                _attempts = 0;
+                _saveCache();
+                CredentialStore::getInstance().upsert(_targetSSID, _targetPassword);
+                CredentialStore::getInstance().recordConnect(_targetSSID, _connectedBssid, _connectedChannel, _lastConnectMs);
+#ifdef DEBUG_WIFI_TOUCH
+                Serial.printf("[WiFi] connected to %s in %lu ms\n", _targetSSID.c_str(), _lastConnectMs);
+#endif
+                _setState(ConnectionState::CONNECTED);
+            }
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            if (_state == ConnectionState::CONNECTING) {
+                if (event.reason != REASON_ASSOC_LEAVE) {
+                    _attemptFailed(event.reason);
+                }
+            } else if (_state == ConnectionState::CONNECTED) {
+                _attempts = 0;
+                _connectStart = millis();
+                _retryDelay = 0;
+                _retryStart = millis();
+                _setState(ConnectionState::WAITING_RETRY);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void WiFiManager::loop() {
+    HEAP_TAG(HEAP_NETWORK);
+    _drainEvents();
+
+    if (_state == ConnectionState::CONNECTING && millis() - _attemptStart > CONNECT_TIMEOUT_MS) {
+        _attemptFailed(REASON_TIMEOUT);
+    } else if (_state == ConnectionState::WAITING_RETRY && millis() - _retryStart >= _retryDelay) {
+        _beginAttempt();
+    }
+
+    if (_isScanning && (_scanDone.load() || millis() - _scanStart > SCAN_TIMEOUT_MS)) {
+        updateScanResults();
+    }
 }
 
 bool WiFiManager::disconnect() {
+    _autoConnectPending = false;
+    _targetSSID = "";
+    _targetPassword = "";
+    bool wasActive = _state != ConnectionState::IDLE;
+    _state = ConnectionState::IDLE;
+    if (wasActive && _onConnectionStateChanged) {
+        _onConnectionStateChanged(_state);
+    }
     if (WiFi.status() == WL_CONNECTED) {
         return WiFi.disconnect(true);
     }
@@ -27,42 +283,127 @@ bool WiFiManager::disconnect() {
 
 bool WiFiManager::startScan() {
     if (_isScanning) return false;
+    if (_state == ConnectionState::CONNECTING) return false;
+    _ensureStarted();
 
-    WiFi.mode(WIFI_STA);
-    WiFi.disconnect(true);
-    delay(100);
-
-    int result = WiFi.scanNetworks(true, true);
+    _scanChannel = 0;
+    _pendingChannels = 0;
+    _scanDone.store(false);
+    int result = WiFi.scanNetworks(true, false);
     if (result == WIFI_SCAN_FAILED) {
-        result = WiFi.scanNetworks(true, true);
+        result = WiFi.scanNetworks(true, false);
     }
 
     if (result != WIFI_SCAN_FAILED) {
         _isScanning = true;
+        _scanStart = millis();
         return true;
     }
 
     return false;
 }
 
+bool WiFiManager::autoConnect() {
+    CredentialStore& store = CredentialStore::getInstance();
+    store.begin();
+    if (store.count() == 0 || _state != ConnectionState::IDLE || _isScanning) return false;
+    _ensureStarted();
+
+    _autoConnectPending = true;
+    bool started;
+    if (store.allChannelsKnown()) {
+        _pendingChannels = store.knownChannels();
+        started = _startChannelScan();
+    } else {
+        started = startScan();
+    }
+    if (!started) {
+        _autoConnectPending = false;
+    }
+    return started;
+}
+
+void WiFiManager::_finishAutoConnect() {
+    _autoConnectPending = false;
+    if (_state != ConnectionState::IDLE) return;
+
+    const ScanNetwork* match = nullptr;
+    const WiFiProfile* profile = CredentialStore::getInstance().selectBest(_networks, _networksCount, &match);
+    if ((!profile || !match) && _scanChannel != 0) {
+        _autoConnectPending = startScan();
+        return;
+    }
+    if (!profile || !match) {
+#ifdef DEBUG_WIFI_TOUCH
+        Serial.println("[WiFi] auto-connect: no known network in range");
+#endif
+        return;
+    }
+#ifdef DEBUG_WIFI_TOUCH
+    Serial.printf("[WiFi] auto-connect: %s (%d dBm, ch %u)\n", profile->ssid, (int)match->rssi, (unsigned)match->channel);
+#endif
+    connect(profile->ssid, profile->password, match->channel, match->bssid);
+}
+
+bool WiFiManager::refreshScan() {
+    if (!_scanCache.isFresh(millis())) {
+        return startScan();
+    }
+    if (_isScanning) return false;
+    if (_state == ConnectionState::CONNECTING) return false;
+    _ensureStarted();
+
+    _publishNetworks();
+    _pendingChannels = _scanCache.knownChannels();
+    return _startChannelScan();
+}
+
+bool WiFiManager::_startChannelScan() {
+    while (_pendingChannels != 0) {
+        uint8_t channel = 1;
+        while (!(_pendingChannels & (1 << channel))) channel++;
+        _pendingChannels &= ~(1 << channel);
+
+        _scanDone.store(false);
+        if (WiFi.scanNetworks(true, false, true, PASSIVE_DWELL_MS, channel) != WIFI_SCAN_FAILED) {
+            _scanChannel = channel;
+            _isScanning = true;
+            _scanStart = millis();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WiFiManager::_publishNetworks() {
+    _networksCount = _scanCache.snapshot(_networks, MAX_NETWORKS);
+}
+
 int WiFiManager::updateScanResults() {
     if (!_isScanning) return -1;
 
     int result = WiFi.scanComplete();
     if (result >= 0) {
-        _networksCount = 0;
-
-        for (int i = 0; i < result && _networksCount < MAX_NETWORKS; ++i) {
-            if (WiFi.SSID(i).length() > 0) {
-                _networks[_networksCount].ssid = WiFi.SSID(i);
-                _networks[_networksCount].rssi = WiFi.RSSI(i);
-                _networksCount++;
-            }
+        unsigned long now = millis();
+        _scanCache.beginScan(_scanChannel);
+        for (int i = 0; i < result; ++i) {
+            _scanCache.add(WiFi.SSID(i), WiFi.BSSID(i), WiFi.RSSI(i), (uint8_t)WiFi.channel(i), now);
         }
-
-        _isScanning = false;
+        _scanCache.endScan(now);
         WiFi.scanDelete();
+        _isScanning = false;
+
+#ifdef DEBUG_WIFI_TOUCH
+        Serial.printf("[WiFi] scan ch %u: %d results, %d cached\n", (unsigned)_scanChannel, result, _scanCache.size());
+#endif
+        if (_startChannelScan()) {
+            return -1;
+        }
 
+        _publishNetworks();
+        if (_autoConnectPending) {
+            _finishAutoConnect();
+        }
         if (_onNetworkListUpdated) {
             _onNetworkListUpdated();
         }
@@ -70,5 +411,11 @@ int WiFiManager::updateScanResults() {
         return _networksCount;
     }
 
+    if (result == WIFI_SCAN_FAILED || millis() - _scanStart > SCAN_TIMEOUT_MS) {
+        WiFi.scanDelete();
+        _isScanning = false;
+        _pendingChannels = 0;
+        _autoConnectPending = false;
+    }
     return -1;
-}
\ No newline at end of file
+}
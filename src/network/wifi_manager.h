@@ -4,12 +4,19 @@
 #include <WiFi.h>
 #include <String>
 #include <functional>
+#include <atomic>
+#include "scan_cache.h"
 
 class WiFiManager {
 public:
-    struct NetworkInfo {
-        String ssid;
-        int32_t rssi;
+    typedef ScanNetwork NetworkInfo;
+
+    enum class ConnectionState : uint8_t {
+        IDLE,
+        CONNECTING,
+        CONNECTED,
+        WAITING_RETRY,
+        FAILED
     };
 
     static WiFiManager& getInstance() {
@@ -17,13 +24,23 @@ public:
         return instance;
     }
 
-    bool connect(const String& ssid, const String& password);
+    bool connect(const String& ssid, const String& password, uint8_t channel = 0, const uint8_t* bssid = nullptr);
+    bool autoConnect();
+    bool isAutoConnecting() const { return _autoConnectPending; }
     bool disconnect();
     bool startScan();
+    bool refreshScan();
+    void loop();
     bool isScanning() const { return _isScanning; }
-    bool isConnected() const { return WiFi.status() == WL_CONNECTED; }
+    bool isConnected() const { return _state == ConnectionState::CONNECTED; }
+    ConnectionState getState() const { return _state; }
+    String getTargetSSID() const { return _targetSSID; }
+    unsigned long getRetryInMs() const;
+    // FAILED because the access point refused the password.
+    bool failedOnCredentials() const;
+    unsigned long getLastConnectMs() const { return _lastConnectMs; }
     String getLocalIP() const { return WiFi.localIP().toString(); }
-    static const int MAX_NETWORKS = 8;
+    static const int MAX_NETWORKS = 24;
     const NetworkInfo* getNetworks() const { return _networks; }
     int getNetworksCount() const { return _networksCount; }
     int updateScanResults();
@@ -32,15 +49,95 @@ public:
         _onNetworkListUpdated = callback;
     }
 
+    void setOnConnectionStateChanged(std::function<void(ConnectionState)> callback) {
+        _onConnectionStateChanged = callback;
+    }
+
 private:
+    struct FastReconnectCache {
+        char ssid[33];
+        uint8_t bssid[6];
+        uint8_t channel;
+        uint32_t ip;
+        uint32_t gateway;
+        uint32_t subnet;
+        uint32_t dns;
+        uint32_t leaseEpoch;
+    };
+
+    struct PendingEvent {
+        uint8_t type;
+        uint8_t reason;
+        uint8_t channel;
+        uint8_t bssid[6];
+        uint32_t ip;
+        uint32_t subnet;
+        uint32_t gateway;
+    };
+
+    static const uint8_t EVENT_QUEUE_SIZE = 8;
+    static const unsigned long CONNECT_TIMEOUT_MS = 10000;
+    static const unsigned long BACKOFF_BASE_MS = 1000;
+    static const unsigned long BACKOFF_MAX_MS = 60000;
+    static const uint8_t MAX_ATTEMPTS = 6;
+    static const uint32_t LEASE_REUSE_S = 3600;
+    static const uint32_t PASSIVE_DWELL_MS = 120;
+    static const unsigned long SCAN_TIMEOUT_MS = 15000;
+
     WiFiManager() = default;
     WiFiManager(const WiFiManager&) = delete;
     WiFiManager& operator=(const WiFiManager&) = delete;
 
+    static void _onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info);
+    void _ensureStarted();
+    void _drainEvents();
+    void _handleEvent(const PendingEvent& event);
+    void _beginAttempt();
+    void _attemptFailed(uint8_t reason);
+    void _setState(ConnectionState state);
+    void _loadCache();
+    void _saveCache();
+    bool _startChannelScan();
+    void _publishNetworks();
+    void _finishAutoConnect();
+
     bool _isScanning = false;
+    std::atomic<bool> _scanDone{false};
+    unsigned long _scanStart = 0;
+    uint8_t _scanChannel = 0;
+    uint16_t _pendingChannels = 0;
+    bool _autoConnectPending = false;
+    ScanCache _scanCache;
     NetworkInfo _networks[MAX_NETWORKS];
     int _networksCount = 0;
     std::function<void()> _onNetworkListUpdated;
+    std::function<void(ConnectionState)> _onConnectionStateChanged;
+
+    bool _started = false;
+    ConnectionState _state = ConnectionState::IDLE;
+    String _targetSSID;
+    String _targetPassword;
+    uint8_t _attempts = 0;
+    uint8_t _lastFailureReason = 0;
+    bool _usedFastPath = false;
+    bool _fastPathFailed = false;
+    bool _usedCachedLease = false;
+    uint8_t _hintChannel = 0;
+    uint8_t _hintBssid[6] = {};
+    unsigned long _attemptStart = 0;
+    unsigned long _retryStart = 0;
+    unsigned long _retryDelay = 0;
+    unsigned long _connectStart = 0;
+    unsigned long _lastConnectMs = 0;
+
+    FastReconnectCache _cache = {};
+    bool _cacheLoaded = false;
+    uint8_t _connectedBssid[6] = {};
+    uint8_t _connectedChannel = 0;
+
+    PendingEvent _events[EVENT_QUEUE_SIZE];
+    std::atomic<uint8_t> _eventHead{0};
+    std::atomic<uint8_t> _eventTail{0};
 };
 
-#endif
\ No newline at end of file
+#endif
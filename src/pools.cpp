@@ -0,0 +1,191 @@
+#include "pools.h"
+#include <esp_heap_caps.h>
+#include <soc/soc_memory_layout.h>
+#include <freertos/FreeRTOS.h>
+#include <string.h>
+#include "services/heap_telemetry.h"
+#include "debug_config.h"
+
+namespace pools {
+    // Internal SRAM left for Wi-Fi, lwIP and task stacks before a bulk block may spill into it.
+    static const size_t INTERNAL_RESERVE_BYTES = 48 * 1024;
+
+    static const uint32_t CAPS_INTERNAL = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    static const uint32_t CAPS_PSRAM = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+
+    struct PoolPolicy {
+        const char* name;
+        uint32_t caps;
+        uint32_t fallbackCaps;          // 0: no fallback
+        size_t fallbackMaxBytes;        // larger requests fail instead of falling back
+    };
+
+    static constexpr PoolPolicy POLICIES[POOL_COUNT] = {
+        { "fast", CAPS_INTERNAL, CAPS_PSRAM, SIZE_MAX },
+        { "dma", MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL, 0, 0 },
+        { "bulk", CAPS_PSRAM, CAPS_INTERNAL, 16 * 1024 },
+    };
+
+    // Sits right below every returned pointer; offset leads back to the heap block.
+    struct BlockHeader {
+        uint32_t size;
+        uint16_t offset;
+        uint8_t pool;
+        uint8_t magic;
+    };
+
+    static const uint8_t BLOCK_MAGIC = 0xB7;
+
+    static portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+    static PoolStats stats[POOL_COUNT] = {};
+
+    static BlockHeader* headerOf(void* ptr) {
+        return (BlockHeader*)((uint8_t*)ptr - sizeof(BlockHeader));
+    }
+
+    static void* allocateFrom(uint32_t caps, size_t size, size_t alignment) {
+        size_t total = size + sizeof(BlockHeader) + alignment - 1;
+        uint8_t* raw = (uint8_t*)heap_caps_malloc(total, caps);
+        if (!raw) return nullptr;
+        uintptr_t user = ((uintptr_t)raw + sizeof(BlockHeader) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        BlockHeader* header = headerOf((void*)user);
+        header->size = size;
+        header->offset = (uint16_t)(user - (uintptr_t)raw);
+        heap_telemetry::noteAlloc(raw, total);
+        return (void*)user;
+    }
+
+    static bool internalCanSpare(size_t size) {
+        size_t available = heap_caps_get_free_size(CAPS_INTERNAL);
+        return available > size && available - size >= INTERNAL_RESERVE_BYTES;
+    }
+
+    void* allocate(Pool pool, size_t size, size_t alignment) {
+        if (pool >= POOL_COUNT || size == 0) return nullptr;
+        if (alignment < sizeof(uint32_t)) alignment = sizeof(uint32_t);
+        if ((alignment & (alignment - 1)) != 0 || alignment > 4096) return nullptr;
+
+        const PoolPolicy& policy = POLICIES[pool];
+        void* ptr = allocateFrom(policy.caps, size, alignment);
+        bool fellBack = false;
+        if (!ptr && policy.fallbackCaps != 0 && size <= policy.fallbackMaxBytes &&
+            (policy.fallbackCaps != CAPS_INTERNAL || internalCanSpare(size))) {
+            ptr = allocateFrom(policy.fallbackCaps, size, alignment);
+            fellBack = ptr != nullptr;
+        }
+
+        portENTER_CRITICAL(&statsLock);
+        PoolStats& pstats = stats[pool];
+        if (size > pstats.largestRequest) pstats.largestRequest = size;
+        if (!ptr) {
+            pstats.failures++;
+        } else {
+            pstats.allocs++;
+            if (fellBack) pstats.fallbacks++;
+            pstats.liveBlocks++;
+            pstats.liveBytes += size;
+            if (pstats.liveBytes > pstats.peakBytes) pstats.peakBytes = pstats.liveBytes;
+        }
+        portEXIT_CRITICAL(&statsLock);
+
+        if (!ptr) return nullptr;
+        BlockHeader* header = headerOf(ptr);
+        header->pool = pool;
+        header->magic = BLOCK_MAGIC;
+        return ptr;
+    }
+
+    void release(void* ptr) {
+        if (!ptr) return;
+        BlockHeader* header = headerOf(ptr);
+        if (header->magic != BLOCK_MAGIC || header->pool >= POOL_COUNT) {
+#ifdef DEBUG_POOLS
+            Serial.printf("[Pools] release of foreign pointer %p ignored\n", ptr);
+#endif
+            return;
+        }
+        Pool pool = (Pool)header->pool;
+        size_t size = header->size;
+        uint8_t* raw = (uint8_t*)ptr - header->offset;
+        header->magic = 0;
+
+        portENTER_CRITICAL(&statsLock);
+        PoolStats& pstats = stats[pool];
+        pstats.frees++;
+        if (pstats.liveBlocks > 0) pstats.liveBlocks--;
+        pstats.liveBytes = pstats.liveBytes > size ? pstats.liveBytes - size : 0;
+        portEXIT_CRITICAL(&statsLock);
+
+        heap_telemetry::noteFree(raw);
+        heap_caps_free(raw);
+    }
+
+    void* reallocate(void* ptr, size_t size) {
+        if (!ptr) return nullptr;
+        BlockHeader* header = headerOf(ptr);
+        if (header->magic != BLOCK_MAGIC) return nullptr;
+        if (size <= header->size) {
+            // Shrinking keeps the block; live bytes only count what callers asked for.
+            portENTER_CRITICAL(&statsLock);
+            stats[header->pool].liveBytes -= header->size - size;
+            portEXIT_CRITICAL(&statsLock);
+            header->size = size;
+            return ptr;
+        }
+        void* grown = allocate((Pool)header->pool, size);
+        if (!grown) return nullptr;
+        memcpy(grown, ptr, header->size);
+        release(ptr);
+        return grown;
+    }
+
+    bool inPsram(const void* ptr) {
+        return ptr != nullptr && esp_ptr_external_ram(ptr);
+    }
+
+    PoolStats getStats(Pool pool) {
+        portENTER_CRITICAL(&statsLock);
+        PoolStats result = stats[pool < POOL_COUNT ? pool : POOL_FAST];
+        portEXIT_CRITICAL(&statsLock);
+        return result;
+    }
+
+    const char* poolName(Pool pool) {
+        return pool < POOL_COUNT ? POLICIES[pool].name : "?";
+    }
+
+    class BulkJsonAllocator : public ArduinoJson::Allocator {
+    public:
+        void* allocate(size_t size) override {
+            return pools::allocate(POOL_BULK, size);
+        }
+
+        void deallocate(void* ptr) override {
+            pools::release(ptr);
+        }
+
+        void* reallocate(void* ptr, size_t size) override {
+            return ptr ? pools::reallocate(ptr, size) : pools::allocate(POOL_BULK, size);
+        }
+    };
+
+    ArduinoJson::Allocator* jsonAllocator() {
+        static BulkJsonAllocator allocator;
+        return &allocator;
+    }
+
+    void writeJson(JsonObject out) {
+        for (int i = 0; i < POOL_COUNT; ++i) {
+            PoolStats pstats = getStats((Pool)i);
+            JsonObject entry = out[POLICIES[i].name].to<JsonObject>();
+            entry["allocs"] = pstats.allocs;
+            entry["frees"] = pstats.frees;
+            entry["failures"] = pstats.failures;
+            entry["fallbacks"] = pstats.fallbacks;
+            entry["liveBlocks"] = pstats.liveBlocks;
+            entry["liveBytes"] = pstats.liveBytes;
+            entry["peakBytes"] = pstats.peakBytes;
+            entry["largestRequest"] = pstats.largestRequest;
+        }
+    }
+}
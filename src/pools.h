@@ -0,0 +1,54 @@
+#ifndef POOLS_H
+#define POOLS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Placement policy for heap buffers. Each pool names where a block should
+// live and where it may fall back to; see POLICIES in pools.cpp.
+namespace pools {
+
+    enum Pool : uint8_t {
+        POOL_FAST,      // internal SRAM: small, latency-critical tables touched every frame
+        POOL_DMA,       // internal DMA-capable SRAM, never falls back
+        POOL_BULK,      // PSRAM: image data, page caches, gateway I/O buffers
+        POOL_COUNT
+    };
+
+    struct PoolStats {
+        uint32_t allocs;
+        uint32_t frees;
+        uint32_t failures;
+        uint32_t fallbacks;     // served from the fallback region instead of the preferred one
+        uint32_t liveBlocks;
+        uint32_t liveBytes;
+        uint32_t peakBytes;
+        uint32_t largestRequest;
+    };
+
+    // alignment must be a power of two. Returns nullptr when neither the
+    // preferred region nor the allowed fallback can serve the request.
+    void* allocate(Pool pool, size_t size, size_t alignment = sizeof(void*));
+    // Grows by moving into a new default-aligned block of the same pool and shrinks in
+    // place; on failure the old block is left untouched.
+    void* reallocate(void* ptr, size_t size);
+    void release(void* ptr);
+
+    template <typename T>
+    T* allocateArray(Pool pool, size_t count) {
+        return (T*)allocate(pool, count * sizeof(T), alignof(T) > sizeof(void*) ? alignof(T) : sizeof(void*));
+    }
+
+    bool inPsram(const void* ptr);
+    PoolStats getStats(Pool pool);
+    const char* poolName(Pool pool);
+
+    // ArduinoJson allocator backed by POOL_BULK, for large gateway documents.
+    ArduinoJson::Allocator* jsonAllocator();
+
+    void writeJson(JsonObject out);
+}
+
+#endif // POOLS_H
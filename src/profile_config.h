@@ -0,0 +1,13 @@
+#ifndef PROFILE_CONFIG_H
+#define PROFILE_CONFIG_H
+
+
+// Hot-path profiler (services/profiler.h). Comment out, or build with
+// -DPROFILE_DISABLED, to compile every PROFILE_* macro away.
+#define PROFILE_ENABLED
+
+#ifdef PROFILE_DISABLED
+    #undef PROFILE_ENABLED
+#endif
+
+#endif // PROFILE_CONFIG_H
@@ -0,0 +1,160 @@
+#include "screen_registry.h"
+#include "settings.h"
+#include "screens/apps_screen.h"
+#include "screens/games_screen.h"
+#include "apps/text_lang_test/app_screen.h"
+#include "apps/test2/app_screen.h"
+#include "apps/geometry_test/app_screen.h"
+#include "apps/swipe_test/app_screen.h"
+#include "apps/reader/app_screen.h"
+#include "apps/calculator/app_screen.h"
+#include "apps/heap_monitor/app_screen.h"
+#include "games/minesweeper/game.h"
+#include "games/sudoku/game.h"
+#include "games/test/game.h"
+
+static const unsigned int FULL_REFRESH_INTERVAL = 8;
+
+static constexpr FooterButton standardFooterButtons[] = {
+    {"Home", homeAction},
+    {"Off", showOffScreen},
+    {"Rfrsh", refreshUI},
+    {"Files", filesAction}
+};
+
+static constexpr FooterButton viewerFooterButtons[] = {
+    {"Home", homeAction},
+    {"Off", showOffScreen},
+    {"Freeze", freezeAction},
+    {"Files", filesAction}
+};
+
+
+static void drawTxtViewer() {
+    screens::drawTxtViewerScreen(currentPath);
+}
+
+static void drawImgViewer() {
+    screens::drawImgViewerScreen(currentPath);
+}
+
+static void touchWifi(int, int x, int y) {
+    screens::handleWiFiScreenTouch(x, y);
+}
+
+static void touchApps(int row, int, int) {
+    if (row >= 3) {
+        screens::handleAppsSelection(row);
+    }
+}
+
+static void touchGames(int row, int x, int y) {
+    if (row >= 3) {
+        handleGamesScreenTouch(row, x, y);
+    }
+}
+
+static void pressSwipeTest(int, int x, int y) {
+    apps_swipe_test::handleTouch(x, y, true);
+}
+
+static void releaseSwipeTest(int, int x, int y) {
+    apps_swipe_test::handleTouch(x, y, false);
+}
+
+
+#define STANDARD_FOOTER standardFooterButtons, 4
+#define VIEWER_FOOTER viewerFooterButtons, 4
+#define NO_FOOTER nullptr, 0
+#define NO_GESTURES nullptr, 0
+
+using gestures::gestureBit;
+static constexpr uint8_t ALL_GESTURES = (1 << gestures::GESTURE_TYPE_COUNT) - 1;
+static constexpr uint8_t READER_GESTURES = gestureBit(gestures::GESTURE_SWIPE) | gestureBit(gestures::GESTURE_LONG_PRESS);
+static constexpr uint8_t IMAGE_GESTURES = gestureBit(gestures::GESTURE_PINCH) | gestureBit(gestures::GESTURE_PAN) |
+                                          gestureBit(gestures::GESTURE_SWIPE) | gestureBit(gestures::GESTURE_DOUBLE_TAP);
+
+static constexpr ScreenDescriptor SCREENS[SCREEN_COUNT] = {
+    { MAIN_SCREEN,             screens::drawMainScreen,         screens::handleMainScreenTouch, nullptr, nullptr,
+      STANDARD_FOOTER, SCREEN_CHROME | SCREEN_HOLD_INPUT, REFRESH_FROM_SETTINGS, NO_GESTURES },
+    { FILES_SCREEN,            screens::drawFilesScreen,        screens::handleTouch,           nullptr, nullptr,
+      STANDARD_FOOTER, SCREEN_CHROME | SCREEN_HOLD_INPUT | SCREEN_TAP_ON_RELEASE, REFRESH_FROM_SETTINGS,
+      screens::handleFilesGesture, gestureBit(gestures::GESTURE_SWIPE) },
+    { OFF_SCREEN,              screens::drawOffScreen,          nullptr,                        nullptr, nullptr,
+      NO_FOOTER,       SCREEN_CHROME,                     REFRESH_QUALITY, NO_GESTURES },
+    { TXT_VIEWER_SCREEN,       drawTxtViewer,                   nullptr,                        nullptr, nullptr,
+      VIEWER_FOOTER,   SCREEN_CHROME,                     REFRESH_FROM_SETTINGS, NO_GESTURES },
+    { IMG_VIEWER_SCREEN,       drawImgViewer,                   nullptr,                        nullptr, nullptr,
+      VIEWER_FOOTER,   SCREEN_CHROME,                     REFRESH_QUALITY, screens::handleImgViewerGesture, IMAGE_GESTURES },
+    { CLEAR_SCREEN,            screens::drawClearScreen,        nullptr,                        nullptr, nullptr,
+      NO_FOOTER,       SCREEN_CHROME,                     REFRESH_QUALITY, NO_GESTURES },
+    { WIFI_SCREEN,             screens::drawWifiScreen,         touchWifi,                      nullptr, nullptr,
+      STANDARD_FOOTER, SCREEN_CHROME | SCREEN_HOLD_INPUT | SCREEN_TAP_ON_RELEASE, REFRESH_FROM_SETTINGS,
+      screens::handleWiFiGesture, gestureBit(gestures::GESTURE_LONG_PRESS) },
+    { APPS_SCREEN,             screens::drawAppsScreen,         touchApps,                      nullptr, nullptr,
+      STANDARD_FOOTER, SCREEN_CHROME | SCREEN_HOLD_INPUT, REFRESH_FROM_SETTINGS, NO_GESTURES },
+    { GAMES_SCREEN,            drawGamesScreen,                 touchGames,                     nullptr, nullptr,
+      STANDARD_FOOTER, SCREEN_CHROME,                     REFRESH_FROM_SETTINGS, NO_GESTURES },
+    { TEXT_LANG_TEST_SCREEN,   apps_text_lang_test::drawAppScreen, nullptr,                     nullptr, nullptr,
+      STANDARD_FOOTER, SCREEN_CHROME,                     REFRESH_FROM_SETTINGS, NO_GESTURES },
+    { TEST2_APP_SCREEN,        apps_test2::drawAppScreen,       nullptr,                        nullptr, nullptr,
+      STANDARD_FOOTER, SCREEN_CHROME,                     REFRESH_FROM_SETTINGS, NO_GESTURES },
+    { GEOMETRY_TEST_SCREEN,    apps_geometry_test::drawAppScreen, nullptr,                      nullptr, apps_geometry_test::updateAnimation,
+      STANDARD_FOOTER, SCREEN_CHROME,                     REFRESH_FAST, NO_GESTURES },
+    { SWIPE_TEST_SCREEN,       apps_swipe_test::drawAppScreen,  pressSwipeTest,                 releaseSwipeTest, apps_swipe_test::updateAnimation,
+      STANDARD_FOOTER, SCREEN_CHROME,                     REFRESH_FAST, apps_swipe_test::handleGesture, ALL_GESTURES },
+    { READER_APP_SCREEN,       apps_reader::drawAppScreen,      apps_reader::handleTouch,       nullptr, nullptr,
+      STANDARD_FOOTER, SCREEN_CHROME | SCREEN_TAP_ON_RELEASE, REFRESH_FROM_SETTINGS, apps_reader::handleGesture, READER_GESTURES },
+    { CALCULATOR_APP_SCREEN,   apps_calculator::drawAppScreen,  apps_calculator::handleTouch,   nullptr, nullptr,
+      STANDARD_FOOTER, SCREEN_CHROME,                     REFRESH_FROM_SETTINGS, NO_GESTURES },
+    { MINESWEEPER_GAME_SCREEN, games_minesweeper::drawGameScreen, games_minesweeper::handleTouch, nullptr, nullptr,
+      NO_FOOTER,       0,                                 REFRESH_FROM_SETTINGS, NO_GESTURES },
+    { SUDOKU_GAME_SCREEN,      games_sudoku::drawGameScreen,    games_sudoku::handleTouch,      nullptr, nullptr,
+      NO_FOOTER,       0,                                 REFRESH_FROM_SETTINGS, NO_GESTURES },
+    { TEST_GAME_SCREEN,        games_test::drawGameScreen,      games_test::handleTouch,        nullptr, nullptr,
+      NO_FOOTER,       0,                                 REFRESH_FROM_SETTINGS, NO_GESTURES },
+    { SD_GATEWAY_SCREEN,       screens::drawSdGatewayScreen,    nullptr,                        nullptr, nullptr,
+      STANDARD_FOOTER, SCREEN_CHROME,                     REFRESH_FROM_SETTINGS, NO_GESTURES },
+    { HEAP_MONITOR_SCREEN,     apps_heap_monitor::drawAppScreen, nullptr,                       nullptr, nullptr,
+      STANDARD_FOOTER, SCREEN_CHROME,                     REFRESH_FROM_SETTINGS, NO_GESTURES }
+};
+
+#undef STANDARD_FOOTER
+#undef VIEWER_FOOTER
+#undef NO_FOOTER
+#undef NO_GESTURES
+
+constexpr bool screenRegistryOrdered(int index = 0) {
+    return index >= SCREEN_COUNT ||
+        (SCREENS[index].type == index && SCREENS[index].draw != nullptr && screenRegistryOrdered(index + 1));
+}
+
+static_assert(screenRegistryOrdered(), "Screen registry must list every ScreenType in enum order with a draw function");
+
+
+const ScreenDescriptor& getScreenDescriptor(ScreenType screen) {
+    return SCREENS[screen < SCREEN_COUNT ? screen : MAIN_SCREEN];
+}
+
+void applyScreenFooter(ScreenType screen) {
+    const ScreenDescriptor& descriptor = getScreenDescriptor(screen);
+    if (descriptor.footerButtons) {
+        footer.setButtons(descriptor.footerButtons, descriptor.footerButtonCount);
+    }
+}
+
+epd_mode_t nextScreenEpdMode(ScreenType screen) {
+    static unsigned int partialFrames = 0;
+    uint8_t policy = getScreenDescriptor(screen).refreshPolicy;
+    if (policy == REFRESH_FROM_SETTINGS) {
+        policy = (uint8_t)Settings::getInstance().getInt(SETTING_REFRESH_POLICY);
+    }
+    switch (policy) {
+        case REFRESH_FAST:
+            return epd_mode_t::epd_fast;
+        case REFRESH_PARTIAL_THEN_FULL:
+            return (partialFrames++ % FULL_REFRESH_INTERVAL == 0) ? epd_mode_t::epd_quality : epd_mode_t::epd_fast;
+        default:
+            return epd_mode_t::epd_quality;
+    }
+}
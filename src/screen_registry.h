@@ -0,0 +1,50 @@
+#ifndef SCREEN_REGISTRY_H
+#define SCREEN_REGISTRY_H
+
+#include "ui.h"
+#include "settings_schema.h"
+#include "services/gestures.h"
+
+typedef void (*ScreenDrawFn)();
+typedef void (*ScreenTouchFn)(int row, int x, int y);
+typedef void (*ScreenTickFn)();
+typedef void (*ScreenGestureFn)(const gestures::Gesture& gesture);
+
+enum ScreenFlag : uint8_t {
+    SCREEN_HEADER = 1 << 0,
+    SCREEN_FOOTER = 1 << 1,
+    // Further touches wait until the frame started by this one is shown.
+    SCREEN_HOLD_INPUT = 1 << 2,
+    // Targets are pressed on a recognised tap rather than on touch-down, so a
+    // swipe that starts on a row does not select it.
+    SCREEN_TAP_ON_RELEASE = 1 << 3
+};
+
+const uint8_t SCREEN_CHROME = SCREEN_HEADER | SCREEN_FOOTER;
+
+// Follows the display.refreshPolicy setting.
+const uint8_t REFRESH_FROM_SETTINGS = 0xFF;
+
+struct ScreenDescriptor {
+    ScreenType type;
+    ScreenDrawFn draw;
+    ScreenTouchFn handleTouch;
+    ScreenTouchFn handleRelease;
+    ScreenTickFn tick;
+    const FooterButton* footerButtons;
+    uint8_t footerButtonCount;
+    uint8_t flags;
+    uint8_t refreshPolicy;
+    ScreenGestureFn handleGesture;
+    uint8_t gestureMask;
+};
+
+const ScreenDescriptor& getScreenDescriptor(ScreenType screen);
+
+// Footer buttons declared by the screen; leaves the footer alone if none.
+void applyScreenFooter(ScreenType screen);
+
+// EPD mode for the next frame of the screen, honouring its refresh policy.
+epd_mode_t nextScreenEpdMode(ScreenType screen);
+
+#endif // SCREEN_REGISTRY_H
@@ -9,11 +9,12 @@
 #include "../apps/swipe_test/app_screen.h"
 #include "../apps/reader/app_screen.h"
 #include "../apps/calculator/app_screen.h"
+#include "../apps/heap_monitor/app_screen.h"
 
 namespace screens {
 
-    const String installedApps[] = {"text_lang_test", "test2", "geometry_test", "swipe_test", "reader", "calculator"};
-    const int installedAppsCount = 6;
+    static constexpr const char* installedApps[] = {"text_lang_test", "test2", "geometry_test", "swipe_test", "reader", "calculator", "heap_monitor"};
+    const int installedAppsCount = 7;
 
     void drawAppsScreen() {
         ::updateHeader();
@@ -38,7 +39,7 @@ namespace screens {
     void handleAppsSelection(int selectedRow) {
 
          if (selectedRow - 3 >= 0 && selectedRow - 3 < installedAppsCount) {
-            String selectedApp = installedApps[selectedRow - 3];
+            TextSpan selectedApp = installedApps[selectedRow - 3];
             
 
             if (selectedApp == "text_lang_test") {
@@ -63,6 +64,9 @@ namespace screens {
             } else if (selectedApp == "calculator") {
                 ::currentScreen = CALCULATOR_APP_SCREEN;
                 ::renderCurrentScreen();
+            } else if (selectedApp == "heap_monitor") {
+                ::currentScreen = HEAP_MONITOR_SCREEN;
+                ::renderCurrentScreen();
             } else {
                 ::displayMessage("Unknown application selected.");
                 ::renderCurrentScreen();
@@ -1,31 +1,37 @@
 #include "files_screen.h"
 #include "../ui.h"
 #include "../sdcard.h"
+#include "../gateway/events.h"
+#include "../services/power_telemetry.h"
+#include "../services/profiler.h"
+#include "../services/heap_telemetry.h"
+#include "../hit_index.h"
+#include "../pools.h"
+#include "../debug_config.h"
 #include <algorithm>
 
 static int currentPage = 0;
 static const int itemsPerPage = 9;
 static int totalPages = 1;
+static const float FLING_PAGE_VELOCITY = 1500.0f;
+static const int FLING_MAX_PAGES = 5;
+// Room for every collected name at 256 bytes on average; FAT long names may be longer.
+static const size_t LISTING_STORAGE_BYTES = 2 * MAX_DISPLAYED_FILES * 256;
 
 namespace screens {
 
-    template <typename T>
-    T customClamp(T value, T minVal, T maxVal) {
-        return (value < minVal) ? minVal : (value > maxVal) ? maxVal : value;
-    }
-
-
-    String getLastFolder(const String& path) {
-        if (path == "/") return "/";
-        String cleanPath = path;
-        if (cleanPath.endsWith("/")) {
-            cleanPath = cleanPath.substring(0, cleanPath.length() - 1);
+    static void appendLastFolder(ArenaString& out, const String& path) {
+        if (path == "/") {
+            out.append('/');
+            return;
         }
-        int lastSlash = cleanPath.lastIndexOf('/');
-        if (lastSlash >= 0) {
-            return cleanPath.substring(lastSlash + 1);
+        int end = path.length();
+        if (path.endsWith("/")) {
+            end--;
         }
-        return cleanPath;
+        int lastSlash = path.lastIndexOf('/', end - 1);
+        int start = lastSlash >= 0 ? lastSlash + 1 : 0;
+        out.append(path.c_str() + start, end - start);
     }
 
 
@@ -33,28 +39,52 @@ namespace screens {
         currentPage = 0;
     }
 
-    void drawFilesScreen() {
+    static String listedPath = "";
+    static bool listingValid = false;
+    static bool listenerRegistered = false;
 
+    void invalidateFilesCache() {
+        listingValid = false;
+    }
 
-        displayedFilesCount = 0;
-        for (int i = 0; i < MAX_DISPLAYED_FILES; i++) {
-            displayedFiles[i] = "";
+    static void onFileChanged(const String& path) {
+        String dir = path.substring(0, path.lastIndexOf('/') + 1);
+        if (dir == listedPath || listedPath.startsWith(path + "/")) {
+            listingValid = false;
         }
-        bufferRow("Files Manager", 2, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
-        String lastFolder = getLastFolder(currentPath);
-        bufferRow("Path: " + lastFolder, 3, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
-
+    }
 
-        if (currentPath != "/") {
-            bufferRow("...", 4, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
-        } else {
-            bufferRow("", 4, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+    // Full names of the listed entries, in PSRAM so long (e.g. Cyrillic) names stay
+    // whole and can be opened again; only the drawn label is cut.
+    static Arena* listingStorage() {
+        static Arena* storage = nullptr;
+        if (!storage) {
+            void* block = pools::allocate(pools::POOL_BULK, LISTING_STORAGE_BYTES);
+            if (!block) return nullptr;
+            static Arena arena(block, LISTING_STORAGE_BYTES);
+            storage = &arena;
         }
+        return storage;
+    }
 
-        for (int row = 5; row <= 13; ++row) {
-            bufferRow("", row, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+    static bool spanLess(TextSpan a, TextSpan b) {
+        return a.compare(b) < 0;
+    }
+
+    static bool loadListing() {
+        POWER_SCOPE(POWER_SD);
+        PROFILE_SCOPE("sd.loadListing");
+        HEAP_TAG(HEAP_FILES);
+        displayedFilesCount = 0;
+        for (int i = 0; i < MAX_DISPLAYED_FILES; i++) {
+            displayedFiles[i] = TextSpan();
         }
 
+        Arena* storage = listingStorage();
+        if (!storage) {
+            return false;
+        }
+        storage->reset();
 
         String pathToOpen = currentPath;
         if (pathToOpen.length() > 1 && pathToOpen.endsWith("/")) {
@@ -63,70 +93,47 @@ namespace screens {
         File root = SD.open(pathToOpen);
 
         if (!root) {
-            bufferRow("No files found", 5, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
-            return;
+            return false;
         }
 
-        static String folders[MAX_DISPLAYED_FILES];
-        static String files[MAX_DISPLAYED_FILES];
+        static TextSpan folders[MAX_DISPLAYED_FILES];
+        static TextSpan files[MAX_DISPLAYED_FILES];
         int foldersCount = 0;
         int filesCount = 0;
-        const size_t maxFilesPerBatch = 100; // Process more files per batch for better performance
-        size_t processedFiles = 0;
 
         while (true) {
             File file = root.openNextFile();
             if (!file) break;
 
-
-            if (processedFiles >= maxFilesPerBatch) {
-                displayMessage("Loading more files...");
-                M5.Display.display();
-                processedFiles = 0;
-            }
-
-            String filename = file.name();
-            if (filename.startsWith(".") || filename == "settings.json") {
+            TextSpan filename = file.name();
+            if (filename.startsWith(".") || filename.startsWith("settings.json")) {
                 file.close();
                 continue;
             }
 
-            if (file.isDirectory()) {
-                if (foldersCount < MAX_DISPLAYED_FILES) {
-                    folders[foldersCount++] = filename + "/";
-                }
-            } else {
-                if (filesCount < MAX_DISPLAYED_FILES) {
-                    files[filesCount++] = filename;
+            bool isFolder = file.isDirectory();
+            int& count = isFolder ? foldersCount : filesCount;
+            if (count < MAX_DISPLAYED_FILES) {
+                size_t length = filename.length() + (isFolder ? 1 : 0);
+                char* name = (char*)storage->allocate(length + 1, 1);
+                if (name) {
+                    memcpy(name, filename.data(), filename.length());
+                    if (isFolder) name[length - 1] = '/';
+                    name[length] = '\0';
+                    (isFolder ? folders : files)[count++] = TextSpan(name, length);
+                } else {
+#ifdef DEBUG_FILES
+                    Serial.printf("[Files] listing storage full, %s left out\n", file.name());
+#endif
                 }
             }
             file.close();
-            processedFiles++;
         }
         root.close();
 
 
-        for (int i = 0; i < foldersCount - 1; i++) {
-            for (int j = 0; j < foldersCount - i - 1; j++) {
-                if (folders[j] > folders[j + 1]) {
-                    String temp = folders[j];
-                    folders[j] = folders[j + 1];
-                    folders[j + 1] = temp;
-                }
-            }
-        }
-
-        for (int i = 0; i < filesCount - 1; i++) {
-            for (int j = 0; j < filesCount - i - 1; j++) {
-                if (files[j] > files[j + 1]) {
-                    String temp = files[j];
-                    files[j] = files[j + 1];
-                    files[j + 1] = temp;
-                }
-            }
-        }
-
-        displayedFilesCount = 0;
+        std::sort(folders, folders + foldersCount, spanLess);
+        std::sort(files, files + filesCount, spanLess);
 
         for (int i = 0; i < foldersCount && displayedFilesCount < MAX_DISPLAYED_FILES; i++) {
             displayedFiles[displayedFilesCount++] = folders[i];
@@ -136,6 +143,53 @@ namespace screens {
             displayedFiles[displayedFilesCount++] = files[i];
         }
 
+        listedPath = currentPath;
+        listingValid = true;
+        return true;
+    }
+
+    // Long names are cut on screen only; selecting the row uses the full name.
+    static TextSpan entryLabel(TextSpan name) {
+        if (name.length() <= (size_t)FILE_LABEL_BYTES) return name;
+        bool isFolder = name.endsWith("/");
+        TextSpan cut = name.prefix(FILE_LABEL_BYTES - 4);
+        ArenaString label(arenas::frame(), FILE_LABEL_BYTES + 1);
+        label.append(cut.data(), cut.length()).append("...");
+        if (isFolder) label.append('/');
+        return TextSpan(label.c_str(), label.length());
+    }
+
+    void drawFilesScreen() {
+        PROFILE_SCOPE("drawFilesScreen");
+        if (!listenerRegistered) {
+            gateway_events::addFileChangeListener(onFileChanged);
+            listenerRegistered = true;
+        }
+
+        bufferRow("Files Manager", 2, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+        ArenaString pathText(arenas::frame());
+        pathText.append("Path: ");
+        appendLastFolder(pathText, currentPath);
+        bufferRow(pathText.c_str(), 3, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+
+
+        if (currentPath != "/") {
+            bufferRow("...", 4, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
+        } else {
+            bufferRow("", 4, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+        }
+
+        for (int row = 5; row <= 13; ++row) {
+            bufferRow("", row, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+        }
+
+
+        if ((!listingValid || listedPath != currentPath) && !loadListing()) {
+            listingValid = false;
+            bufferRow("No files found", 5, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+            return;
+        }
+
 
         totalPages = (displayedFilesCount + itemsPerPage - 1) / itemsPerPage;
 
@@ -151,31 +205,55 @@ namespace screens {
         int startIdx = currentPage * itemsPerPage;
         int endIdx = std::min(startIdx + itemsPerPage, displayedFilesCount);
         for (int i = startIdx; i < endIdx; ++i) {
-            bool isFolder = displayedFiles[i].endsWith("/");
-            bufferRow(displayedFiles[i], 5 + (i - startIdx), TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
+            bufferRow(entryLabel(displayedFiles[i]), 5 + (i - startIdx), TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
         }
 
 
         if (totalPages > 1) {
-            String paginationButtons[] = {"<<<--", "<--", String(currentPage + 1), "-->", "-->>>"};  
+            ArenaString pageNumber(arenas::frame(), 8);
+            pageNumber.append(currentPage + 1);
+            const char* paginationButtons[] = {"<<<--", "<--", pageNumber.c_str(), "-->", "-->>>"};
+            const uint16_t paginationActions[] = {hit_index::HIT_PAGE_FIRST, hit_index::HIT_PAGE_PREV, hit_index::HIT_NONE,
+                                                  hit_index::HIT_PAGE_NEXT, hit_index::HIT_PAGE_LAST};
             int numButtons = 5;
             int sectionWidth = EPD_WIDTH / numButtons;
             RowPosition pos = getRowPosition(14);
-            int underlineY = pos.y + 30;
 
             for(int i = 0; i < numButtons; ++i){
-                String btn = paginationButtons[i];
+                const char* btn = paginationButtons[i];
                 int btnX = pos.x + i * sectionWidth + 10;
                 int btnY = pos.y + (pos.height - 20) / 2;
                 M5.Display.setCursor(btnX, btnY);
                 M5.Display.print(btn);
-                int textWidth = M5.Display.textWidth(btn.c_str());
+                int textWidth = M5.Display.textWidth(btn);
                 int centeredUnderlineY = pos.y + pos.height - 10;
                 M5.Display.drawLine(btnX, centeredUnderlineY, btnX + textWidth, centeredUnderlineY, TFT_BLACK);
+                if (paginationActions[i] != hit_index::HIT_NONE) {
+                    hit_index::add(pos.x + i * sectionWidth, pos.y, sectionWidth, pos.height, paginationActions[i]);
+                }
             }
         }
     }
 
+    int getCurrentPage() {
+        return currentPage;
+    }
+
+    void resumeFilesPage(int page) {
+        if (!listenerRegistered) {
+            gateway_events::addFileChangeListener(onFileChanged);
+            listenerRegistered = true;
+        }
+        if ((!listingValid || listedPath != currentPath) && !loadListing()) {
+            currentPage = 0;
+            return;
+        }
+        totalPages = (displayedFilesCount + itemsPerPage - 1) / itemsPerPage;
+        currentPage = page;
+        if (currentPage >= totalPages) currentPage = totalPages - 1;
+        if (currentPage < 0) currentPage = 0;
+    }
+
     void handlePagination(String button) {
         if (button == "<<<--") {
             if (currentPage != 0) {
@@ -238,54 +316,54 @@ namespace screens {
     }
 
     void handleTouch(int touchRow, int touchX, int touchY) {
-        if (currentScreen == FILES_SCREEN) {
-            if (touchRow >= 5 && touchRow <= 13) {
-                int index = currentPage * itemsPerPage + (touchRow - 5);
-                if (index < displayedFilesCount) {
-                    String selected = displayedFiles[index];
-                    selectFile(selected);
+        if (currentScreen != FILES_SCREEN) return;
+        const hit_index::HitTarget* hit = hit_index::lookup(touchX, touchY);
+        if (!hit) return;
+
+        switch (hit->action) {
+            case hit_index::HIT_ROW:
+                if (hit->param >= 5 && hit->param <= 13) {
+                    int index = currentPage * itemsPerPage + (hit->param - 5);
+                    if (index < displayedFilesCount) {
+                        String selected = displayedFiles[index].data();
+                        selectFile(selected);
+                    }
+                } else if (hit->param == 4) {
+                    selectFile("...");
                 }
-            } else if (touchRow == 4) {
-                selectFile("...");
-            } else if (touchRow == 14) {
-                int width = EPD_WIDTH;
-
-                int sectionWidth = width / 5;
-
-                int firstBtnCenterX = sectionWidth / 2;
-                int firstBtnStartX = customClamp(firstBtnCenterX - (int)(sectionWidth * 0.75), 0, width);
-                int firstBtnEndX = customClamp(firstBtnCenterX + (int)(sectionWidth * 0.75), 0, width);
-
-                int secondBtnCenterX = 3 * sectionWidth / 2;
-                int secondBtnStartX = customClamp(secondBtnCenterX - (int)(sectionWidth * 0.75), 0, width);
-                int secondBtnEndX = customClamp(secondBtnCenterX + (int)(sectionWidth * 0.75), 0, width);
-
-                int thirdBtnCenterX = 5 * sectionWidth / 2;
-                int thirdBtnStartX = customClamp(thirdBtnCenterX - (int)(sectionWidth * 0.75), 0, width);
-                int thirdBtnEndX = customClamp(thirdBtnCenterX + (int)(sectionWidth * 0.75), 0, width);
-
-                int fourthBtnCenterX = 7 * sectionWidth / 2;
-                int fourthBtnStartX = customClamp(fourthBtnCenterX - (int)(sectionWidth * 0.75), 0, width);
-                int fourthBtnEndX = customClamp(fourthBtnCenterX + (int)(sectionWidth * 0.75), 0, width);
-
-                int fifthBtnCenterX = 9 * sectionWidth / 2;
-                int fifthBtnStartX = customClamp(fifthBtnCenterX - (int)(sectionWidth * 0.75), 0, width);
-                int fifthBtnEndX = customClamp(fifthBtnCenterX + (int)(sectionWidth * 0.75), 0, width);
-
+                break;
+            case hit_index::HIT_PAGE_FIRST:
+                handlePagination("<<<--");
+                break;
+            case hit_index::HIT_PAGE_PREV:
+                handlePagination("<--");
+                break;
+            case hit_index::HIT_PAGE_NEXT:
+                handlePagination("-->");
+                break;
+            case hit_index::HIT_PAGE_LAST:
+                handlePagination("-->>>");
+                break;
+            default:
+                break;
+        }
+    }
 
-                if (touchX >= firstBtnStartX && touchX <= firstBtnEndX) {
-                    handlePagination("<<<--");
-                }
-                else if (touchX >= secondBtnStartX && touchX <= secondBtnEndX) {
-                    handlePagination("<--");
-                }
-                else if (touchX >= fourthBtnStartX && touchX <= fourthBtnEndX) {
-                    handlePagination("-->");
-                }
-                else if (touchX >= fifthBtnStartX && touchX <= fifthBtnEndX) {
-                    handlePagination("-->>>");
-                }
-            }
+    // Vertical fling pages through the listing; faster flings skip further.
+    void handleFilesGesture(const gestures::Gesture& gesture) {
+        if (gesture.type != gestures::GESTURE_SWIPE || totalPages <= 1) return;
+        int step = 1 + (int)(gesture.velocity / FLING_PAGE_VELOCITY);
+        if (step > FLING_MAX_PAGES) step = FLING_MAX_PAGES;
+        int target = currentPage;
+        if (gesture.direction == gestures::SWIPE_UP || gesture.direction == gestures::SWIPE_LEFT) {
+            target += step;
+        } else {
+            target -= step;
         }
+        if (target >= totalPages) target = totalPages - 1;
+        if (target < 0) target = 0;
+        if (target == currentPage) return;
+        currentPage = target;
+        renderCurrentScreen();
     }
-}
\ No newline at end of file
+}
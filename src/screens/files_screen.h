@@ -2,11 +2,16 @@
 #define FILES_SCREEN_H
 
 #include <M5Unified.h>
+#include "../services/gestures.h"
 
 namespace screens {
     void drawFilesScreen();
     void handleTouch(int touchRow, int touchX, int touchY);
+    void handleFilesGesture(const gestures::Gesture& gesture);
     void resetPagination();
+    void invalidateFilesCache();
+    int getCurrentPage();
+    void resumeFilesPage(int page);
 }
 
 #endif
\ No newline at end of file
@@ -4,7 +4,7 @@
 #include "../games/sudoku/game.h"
 #include "../games/test/game.h"
 
-const String installedGames[] = {"Minesweeper", "Sudoku", "Test"};
+static constexpr const char* installedGames[] = {"Minesweeper", "Sudoku", "Test"};
 const int installedGamesCount = 3;
 
 void drawGamesScreen() {
@@ -26,7 +26,7 @@ void drawGamesScreen() {
 
 void handleGamesScreenTouch(int touchedRow, int x, int y) {
     if (touchedRow - 3 >= 0 && touchedRow - 3 < installedGamesCount) {
-        String selectedGame = installedGames[touchedRow - 3];
+        TextSpan selectedGame = installedGames[touchedRow - 3];
         
         if (selectedGame == "Minesweeper") {
             games_minesweeper::initGame();
@@ -1,7 +1,11 @@
 #include "img_viewer_screen.h"
 #include "../ui.h"
 #include "../sdcard.h"
+#include "../pools.h"
 #include "../buttons/rotate.h"
+#include "../services/power_telemetry.h"
+#include "../services/profiler.h"
+#include "../services/heap_telemetry.h"
 
 enum ImageFormat {
     FORMAT_UNKNOWN,
@@ -32,7 +36,29 @@ namespace screens {
     static constexpr int frameRight = 540;
     static constexpr int frameBottom = 700;
 
+    static const float MAX_ZOOM = 4.0f;
+    static float viewZoom = 1.0f;
+    static int viewPanX = 0;
+    static int viewPanY = 0;
+
+    static void resetView() {
+        viewZoom = 1.0f;
+        viewPanX = 0;
+        viewPanY = 0;
+    }
+
+    // Keeps the pan inside the overflow of an image scaled to scaledWidth x scaledHeight.
+    static void clampPan(int scaledWidth, int scaledHeight) {
+        int limitX = max(0, (scaledWidth - (frameRight - frameLeft)) / 2);
+        int limitY = max(0, (scaledHeight - (frameBottom - frameTop)) / 2);
+        viewPanX = constrain(viewPanX, -limitX, limitX);
+        viewPanY = constrain(viewPanY, -limitY, limitY);
+    }
+
     void drawImgViewerScreen(const String& filename) {
+        if (filename != currentImgOpened) {
+            resetView();
+        }
         currentImgOpened = filename;
 
 
@@ -45,7 +71,7 @@ namespace screens {
         displayImgFile(filename);
 
 
-        FooterButton viewerFooterButtons[] = {
+        static constexpr FooterButton viewerFooterButtons[] = {
             {"Home", homeAction},
             {"180°", rotateImg180Action},
             {"Freeze", freezeAction},
@@ -69,14 +95,17 @@ namespace screens {
     }
 
 
-    void scaleBmpImage(const uint8_t* srcData, int srcWidth, int srcHeight, uint16_t* destBuffer, int destWidth, int destHeight) {
+    // Samples the destWidth x destHeight window at (offsetX, offsetY) of the image scaled to scaledWidth x scaledHeight.
+    void scaleBmpImage(const uint8_t* srcData, int srcWidth, int srcHeight, uint16_t* destBuffer, int destWidth, int destHeight,
+                       int scaledWidth, int scaledHeight, int offsetX, int offsetY) {
+        PROFILE_SCOPE("scaleBmpImage");
 
         int rowSize = ((24 * srcWidth + 31) / 32) * 4;
 
         for(int y = 0; y < destHeight; y++) {
             for(int x = 0; x < destWidth; x++) {
-                int srcX = x * srcWidth / destWidth;
-                int srcY = srcHeight - 1 - (y * srcHeight / destHeight);
+                int srcX = (int)((int64_t)(x + offsetX) * srcWidth / scaledWidth);
+                int srcY = srcHeight - 1 - (int)((int64_t)(y + offsetY) * srcHeight / scaledHeight);
 
 
                 srcX = constrain(srcX, 0, srcWidth - 1);
@@ -93,6 +122,8 @@ namespace screens {
     }
 
     void displayImgFile(const String& filename) {
+        POWER_SCOPE(POWER_SD);
+        HEAP_TAG(HEAP_IMAGE);
         Serial.println("[DEBUG] displayImgFile called with: " + filename);
         
         ImageFormat format = getImageFormat(filename);
@@ -140,7 +171,7 @@ namespace screens {
             case FORMAT_BMP:
 
                 {
-                    uint8_t *fileData = (uint8_t *)malloc(fileSize);
+                    uint8_t *fileData = (uint8_t *)pools::allocate(pools::POOL_BULK, fileSize);
                     if (!fileData) {
                         ::setUniversalFont();
                         M5.Display.setTextColor(TFT_BLACK, TFT_WHITE);
@@ -149,12 +180,17 @@ namespace screens {
                         return;
                     }
                     
-                    size_t bytesRead = file.read(fileData, fileSize);
+                    size_t bytesRead;
+                    {
+                        PROFILE_SCOPE("sd.readImage");
+                        bytesRead = file.read(fileData, fileSize);
+                    }
+                    PROFILE_COUNT("sd.readBytes", bytesRead);
                     if (bytesRead != fileSize) {
                         ::setUniversalFont();
                         M5.Display.setTextColor(TFT_BLACK, TFT_WHITE);
                         M5.Display.drawString("Error reading file", frameLeft + 20, frameTop + 20);
-                        free(fileData);
+                        pools::release(fileData);
                         file.close();
                         return;
                     }
@@ -164,41 +200,45 @@ namespace screens {
                     
                     if (dimensionSuccess) {
 
-                        float scale = min((float)frameWidth / imgWidth, (float)frameHeight / imgHeight);
-                        int scaledWidth = floor(imgWidth * scale);
-                        int scaledHeight = floor(imgHeight * scale);
+                        float scale = min((float)frameWidth / imgWidth, (float)frameHeight / imgHeight) * viewZoom;
+                        int scaledWidth = max(1, (int)floor(imgWidth * scale));
+                        int scaledHeight = max(1, (int)floor(imgHeight * scale));
+                        clampPan(scaledWidth, scaledHeight);
                         
 
-                        scaledWidth = min(scaledWidth, frameWidth);
-                        scaledHeight = min(scaledHeight, frameHeight);
+                        int visibleWidth = min(scaledWidth, frameWidth);
+                        int visibleHeight = min(scaledHeight, frameHeight);
+                        int offsetX = (scaledWidth - visibleWidth) / 2 - viewPanX;
+                        int offsetY = (scaledHeight - visibleHeight) / 2 - viewPanY;
                         
 
-                        posX = frameLeft + (frameWidth - scaledWidth) / 2;
-                        posY = frameTop + (frameHeight - scaledHeight) / 2;
+                        posX = frameLeft + (frameWidth - visibleWidth) / 2;
+                        posY = frameTop + (frameHeight - visibleHeight) / 2;
                         
 
                         const uint8_t* pixelData = fileData + 54;
                         
 
-                        size_t bufferSize = scaledWidth * scaledHeight * sizeof(uint16_t);
-                        uint16_t* scaledBuffer = (uint16_t*)malloc(bufferSize);
+                        size_t bufferSize = visibleWidth * visibleHeight * sizeof(uint16_t);
+                        uint16_t* scaledBuffer = (uint16_t*)pools::allocate(pools::POOL_BULK, bufferSize);
                         if (!scaledBuffer) {
                             ::setUniversalFont();
                             M5.Display.setTextColor(TFT_BLACK, TFT_WHITE);
                             M5.Display.drawString("Out of memory for scaling", frameLeft + 20, frameTop + 20);
-                            free(fileData);
+                            pools::release(fileData);
                             file.close();
                             return;
                         }
                         
-                        scaleBmpImage(pixelData, imgWidth, imgHeight, scaledBuffer, scaledWidth, scaledHeight);
+                        scaleBmpImage(pixelData, imgWidth, imgHeight, scaledBuffer, visibleWidth, visibleHeight,
+                                      scaledWidth, scaledHeight, offsetX, offsetY);
 
-                        M5.Display.pushImage(posX, posY, scaledWidth, scaledHeight, scaledBuffer);
-                        free(scaledBuffer);
+                        M5.Display.pushImage(posX, posY, visibleWidth, visibleHeight, scaledBuffer);
+                        pools::release(scaledBuffer);
                         success = true;
                     }
                     
-                    free(fileData);
+                    pools::release(fileData);
                 }
                 break;
                 
@@ -223,6 +263,34 @@ namespace screens {
 
 
 
+    // Pinch zooms about the frame centre, pan and swipe move a zoomed image, double tap resets.
+    void handleImgViewerGesture(const gestures::Gesture& gesture) {
+        switch (gesture.type) {
+            case gestures::GESTURE_PINCH:
+                viewZoom = constrain(viewZoom * gesture.scale, 1.0f, MAX_ZOOM);
+                viewPanX = (int)(viewPanX * gesture.scale);
+                viewPanY = (int)(viewPanY * gesture.scale);
+                if (viewZoom == 1.0f) {
+                    viewPanX = 0;
+                    viewPanY = 0;
+                }
+                break;
+            case gestures::GESTURE_PAN:
+            case gestures::GESTURE_SWIPE:
+                if (viewZoom == 1.0f) return;
+                viewPanX += gesture.dx;
+                viewPanY += gesture.dy;
+                break;
+            case gestures::GESTURE_DOUBLE_TAP:
+                if (viewZoom == 1.0f) return;
+                resetView();
+                break;
+            default:
+                return;
+        }
+        renderCurrentScreen();
+    }
+
     void clearImgViewerScreen() {
 
         M5.Display.fillScreen(TFT_WHITE);
@@ -234,6 +302,8 @@ namespace screens {
     }
     
     void displayFullScreenImgFile(const String& filename) {
+        POWER_SCOPE(POWER_SD);
+        HEAP_TAG(HEAP_IMAGE);
         ImageFormat format = getImageFormat(filename);
         
         if (format == FORMAT_UNKNOWN) {
@@ -274,7 +344,7 @@ namespace screens {
             case FORMAT_BMP:
 
                 {
-                    uint8_t *fileData = (uint8_t *)malloc(fileSize);
+                    uint8_t *fileData = (uint8_t *)pools::allocate(pools::POOL_BULK, fileSize);
                     if (!fileData) {
                         ::setUniversalFont();
                         M5.Display.setTextColor(TFT_BLACK, TFT_WHITE);
@@ -283,12 +353,17 @@ namespace screens {
                         return;
                     }
                     
-                    size_t bytesRead = file.read(fileData, fileSize);
+                    size_t bytesRead;
+                    {
+                        PROFILE_SCOPE("sd.readImage");
+                        bytesRead = file.read(fileData, fileSize);
+                    }
+                    PROFILE_COUNT("sd.readBytes", bytesRead);
                     if (bytesRead != fileSize) {
                         ::setUniversalFont();
                         M5.Display.setTextColor(TFT_BLACK, TFT_WHITE);
                         M5.Display.drawString("Error reading file", 20, 20);
-                        free(fileData);
+                        pools::release(fileData);
                         file.close();
                         return;
                     }
@@ -315,24 +390,25 @@ namespace screens {
                         
 
                         size_t bufferSize = scaledWidth * scaledHeight * sizeof(uint16_t);
-                        uint16_t* scaledBuffer = (uint16_t*)malloc(bufferSize);
+                        uint16_t* scaledBuffer = (uint16_t*)pools::allocate(pools::POOL_BULK, bufferSize);
                         if (!scaledBuffer) {
                             ::setUniversalFont();
                             M5.Display.setTextColor(TFT_BLACK, TFT_WHITE);
                             M5.Display.drawString("Out of memory for scaling", 20, 20);
-                            free(fileData);
+                            pools::release(fileData);
                             file.close();
                             return;
                         }
                         
-                        scaleBmpImage(pixelData, imgWidth, imgHeight, scaledBuffer, scaledWidth, scaledHeight);
+                        scaleBmpImage(pixelData, imgWidth, imgHeight, scaledBuffer, scaledWidth, scaledHeight,
+                                      scaledWidth, scaledHeight, 0, 0);
 
                         M5.Display.pushImage(posX, posY, scaledWidth, scaledHeight, scaledBuffer);
-                        free(scaledBuffer);
+                        pools::release(scaledBuffer);
                         success = true;
                     }
                     
-                    free(fileData);
+                    pools::release(fileData);
                 }
                 break;
                 
@@ -354,7 +430,7 @@ namespace screens {
 
     void setupImgViewerButtons() {
 
-        FooterButton viewerFooterButtons[] = {
+        static constexpr FooterButton viewerFooterButtons[] = {
             {"Home", homeAction},
             {"180°", rotateImg180Action},
             {"Freeze", freezeAction},
@@ -365,7 +441,7 @@ namespace screens {
 
     void setupImgViewerRotateButtons() {
 
-        FooterButton rotateButtons[] = {
+        static constexpr FooterButton rotateButtons[] = {
             {"Home", homeAction},
             {"180°", rotateImg180Action},
             {"Freeze", freezeAction},
@@ -2,11 +2,13 @@
 #define IMG_VIEWER_SCREEN_H
 
 #include <M5Unified.h>
+#include "../services/gestures.h"
 
 namespace screens {
     void drawImgViewerScreen(const String& filename);
     void displayImgFile(const String& filename);
     void displayFullScreenImgFile(const String& filename);
+    void handleImgViewerGesture(const gestures::Gesture& gesture);
     String getCurrentImgFile();
     void setupImgViewerButtons();
     void setupImgViewerRotateButtons();
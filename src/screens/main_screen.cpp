@@ -8,20 +8,31 @@
 namespace screens {
     void drawMainScreen() {
         ::bufferRow("hi5stack", 2, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
-        ::bufferRow("Voltage: " + String(getBatteryVoltage(), 2) + "V", 3, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
-        ::bufferRow("SD Card: " + String(isSDCardMounted() ? "Mounted" : "Not Mounted"), 4, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+        ArenaString voltageText(arenas::frame());
+        voltageText.append("Voltage: ").append(getBatteryVoltage(), 2).append('V');
+        float remainingHours = getBatteryRemainingHours();
+        if (remainingHours >= 0.0f) {
+            voltageText.append(" (~").append((int)(remainingHours + 0.5f)).append("h left)");
+        }
+        ::bufferRow(voltageText.c_str(), 3, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+        ::bufferRow(isSDCardMounted() ? "SD Card: Mounted" : "SD Card: Not Mounted", 4, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
 
 
         if (WiFi.status() == WL_CONNECTED) {
-            String ip = WiFi.localIP().toString();
-            ::bufferRow("Wi-Fi: " + ip, 5, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
+            IPAddress ip = WiFi.localIP();
+            ArenaString wifiText(arenas::frame());
+            wifiText.append("Wi-Fi: ");
+            for (int i = 0; i < 4; ++i) {
+                if (i) wifiText.append('.');
+                wifiText.append((int)ip[i]);
+            }
+            ::bufferRow(wifiText.c_str(), 5, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
         } else {
             ::bufferRow("Wi-Fi: Not connected", 5, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
         }
 
 
-        String sdgwState = sd_gateway::isActive() ? "On port :8080" : "Off";
-        ::bufferRow("SD Gateway: " + sdgwState, 6, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
+        ::bufferRow(sd_gateway::isActive() ? "SD Gateway: On port :8080" : "SD Gateway: Off", 6, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
 
 
         ::bufferRow("Apps", 7, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
@@ -32,4 +43,28 @@ namespace screens {
             ::bufferRow("", row, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
         }
     }
+
+    void handleMainScreenTouch(int touchedRow, int x, int y) {
+        if (touchedRow == 5) {
+            displayMessage("Wi-Fi pressed");
+            resetWiFiScreen();
+            currentScreen = WIFI_SCREEN;
+            renderCurrentScreen();
+        } else if (touchedRow == 6) {
+            if (WiFi.status() != WL_CONNECTED) {
+                displayMessage("Wi-Fi not connected");
+            } else {
+                sd_gateway::toggleOrShow();
+            }
+            renderCurrentScreen();
+        } else if (touchedRow == 7) {
+            displayMessage("Apps pressed");
+            currentScreen = APPS_SCREEN;
+            renderCurrentScreen();
+        } else if (touchedRow == 8) {
+            displayMessage("Games pressed");
+            currentScreen = GAMES_SCREEN;
+            renderCurrentScreen();
+        }
+    }
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 
 namespace screens {
     void drawMainScreen();
+    void handleMainScreenTouch(int touchedRow, int x, int y);
 }
 
 #endif
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "off_screen.h"
 #include "../ui.h"
+#include "../settings.h"
+#include "../services/reading_state.h"
 #include <esp_sleep.h>
 
 namespace screens {
@@ -19,6 +21,8 @@ namespace screens {
         WiFi.disconnect();
 
 
+        Settings::getInstance().flush();
+        ReadingStateStore::getInstance().flush();
         SD.end();
 
 
@@ -2,6 +2,8 @@
 #include "../ui.h"
 #include "../sdcard.h"
 #include "../buttons/rotate.h"
+#include "../services/power_telemetry.h"
+#include "../services/profiler.h"
 
 namespace screens {
     static String currentFileOpened = "";
@@ -16,12 +18,14 @@ namespace screens {
             ::bufferRow("", row);
         }
 
-        ::bufferRow("Text Viewer: " + filename, 2);
+        ArenaString title(arenas::frame());
+        title.append("Text Viewer: ").append(filename);
+        ::bufferRow(title.c_str(), 2);
 
         displayTxtFile(filename);
 
 
-        FooterButton viewerFooterButtons[] = {
+        static constexpr FooterButton viewerFooterButtons[] = {
             {"Home", homeAction},
             {"180°", rotateTxt180Action},
             {"Freeze", freezeAction},
@@ -36,52 +40,65 @@ namespace screens {
         M5.Display.display();
     }
 
-    void displayTxtFile(const String& filename) {
+    // Wrapped rows of the open file, kept in the screen arena so redraws of the
+    // same file neither touch the SD card nor allocate.
+    static const int FIRST_TEXT_ROW = 3;
+    static const int LAST_TEXT_ROW = 13;
+    static const char* wrappedRows[LAST_TEXT_ROW - FIRST_TEXT_ROW + 1];
+    static int wrappedRowCount = 0;
+    static const char* wrappedFile = nullptr;
+    static uint32_t wrappedGeneration = 0;
+
+    static bool wrapFile(const String& filename) {
+        Arena& arena = arenas::screen();
+        if (wrappedFile && wrappedGeneration == arena.generation() && filename == wrappedFile) {
+            return true;
+        }
+
+        POWER_SCOPE(POWER_SD);
+        PROFILE_SCOPE("sd.readText");
+        wrappedFile = nullptr;
+        wrappedRowCount = 0;
         File file = SD.open(filename);
         if (!file) {
-            ::bufferRow("Failed to open file", 3);
-            return;
+            return false;
         }
 
-        int row = 3;
-        const int maxRowsAvailable = 13;
-        
-        while (file.available() && row <= maxRowsAvailable) {
+        const int maxRows = LAST_TEXT_ROW - FIRST_TEXT_ROW + 1;
+        int maxWidth = getRowPosition(FIRST_TEXT_ROW).width - 20;
+        while (file.available() && wrappedRowCount < maxRows) {
             String line = file.readStringUntil('\n');
             line.trim();
             if (line.length() > 0) {
-
-                RowPosition pos = getRowPosition(row);
-                int maxWidth = pos.width - 20;
-                
-
-                const int MAX_WRAPPED_LINES = 10;
-                String wrappedLines[MAX_WRAPPED_LINES];
-                int wrappedLineCount = 0;
-                ::wordWrap(line, maxWidth, wrappedLines, wrappedLineCount, MAX_WRAPPED_LINES);
-                
-
-                for (int i = 0; i < wrappedLineCount; i++) {
-                    const String& wrappedLine = wrappedLines[i];
-                    if (row <= maxRowsAvailable) {
-                        ::bufferRow(wrappedLine, row);
-                        row++;
-                    } else {
-                        break;
-                    }
-                }
+                wrappedRowCount += ::wordWrap(line.c_str(), maxWidth, arena, wrappedRows + wrappedRowCount,
+                                              maxRows - wrappedRowCount);
             }
         }
-
         file.close();
+
+        wrappedFile = arena.copy(filename.c_str());
+        wrappedGeneration = arena.generation();
+        return true;
     }
 
-    void displayFullScreenFile(const String& filename) {
+    static void bufferWrappedRows() {
+        for (int i = 0; i < wrappedRowCount; i++) {
+            ::bufferRow(wrappedRows[i], FIRST_TEXT_ROW + i);
+        }
+    }
 
+    void displayTxtFile(const String& filename) {
+        if (!wrapFile(filename)) {
+            ::bufferRow("Failed to open file", 3);
+            return;
+        }
+        bufferWrappedRows();
+    }
+
+    void displayFullScreenFile(const String& filename) {
         ::setUniversalFont();
         
-        File file = SD.open(filename);
-        if (!file) {
+        if (!wrapFile(filename)) {
             ::bufferRow("Failed to open file", 3);
             return;
         }
@@ -92,38 +109,7 @@ namespace screens {
         }
 
         ::bufferRow("Full Screen Text", 2);
-
-        int row = 3;
-        const int maxRowsAvailable = 13;
-        
-        while (file.available() && row <= maxRowsAvailable) {
-            String line = file.readStringUntil('\n');
-            line.trim();
-            if (line.length() > 0) {
-
-                RowPosition pos = getRowPosition(row);
-                int maxWidth = pos.width - 20;
-                
-
-                const int MAX_WRAPPED_LINES = 10;
-                String wrappedLines[MAX_WRAPPED_LINES];
-                int wrappedLineCount = 0;
-                ::wordWrap(line, maxWidth, wrappedLines, wrappedLineCount, MAX_WRAPPED_LINES);
-                
-
-                for (int i = 0; i < wrappedLineCount; i++) {
-                    const String& wrappedLine = wrappedLines[i];
-                    if (row <= maxRowsAvailable) {
-                        ::bufferRow(wrappedLine, row);
-                        row++;
-                    } else {
-                        break;
-                    }
-                }
-            }
-        }
-
-        file.close();
+        bufferWrappedRows();
 
 
         ::drawRowsBuffered();
@@ -140,7 +126,7 @@ namespace screens {
 
     void setupTxtViewerRotateButtons() {
 
-        FooterButton rotateButtons[] = {
+        static constexpr FooterButton rotateButtons[] = {
             {"Home", homeAction},
             {"180°", rotateTxt180Action},
             {"Freeze", freezeAction},
@@ -4,6 +4,8 @@
 #include "../footer.h"
 #include "../keyboards/eng_keyboard.h"
 #include "../settings.h"
+#include "../network/credential_store.h"
+#include <algorithm>
 
 namespace screens {
 
@@ -12,12 +14,69 @@ namespace screens {
     static String selectedSSID = "";
     static String passwordInput = "";
     static int networksListStartRow = 4;
+    static int networksPage = 0;
+    static const int PAGINATION_ROW = 14;
+    static String connectingSSID = "";
+    static String connectingPassword = "";
+    // The attempt uses a stored password rather than one typed just now.
+    static bool connectingSaved = false;
+
+    static void forgetNetwork(const String& ssid) {
+        CredentialStore::getInstance().remove(ssid);
+        Settings& settings = Settings::getInstance();
+        if (settings.getLastConnectedSSID() == ssid) {
+            settings.setLastConnectedSSID("");
+            settings.setLastConnectedPassword("");
+        }
+    }
+
+    static void onConnectionStateChanged(WiFiManager::ConnectionState state) {
+        WiFiManager& wifiManager = WiFiManager::getInstance();
+        if (state == WiFiManager::ConnectionState::CONNECTED) {
+            if (!connectingSSID.isEmpty() && wifiManager.getTargetSSID() == connectingSSID) {
+                Settings& settings = Settings::getInstance();
+                settings.setLastConnectedSSID(connectingSSID);
+                settings.setLastConnectedPassword(connectingPassword);
+            }
+            connectingSSID = "";
+            connectingPassword = "";
+            if (currentScreen == WIFI_SCREEN) {
+                currentState = WiFiScreenState::LIST;
+                currentScreen = MAIN_SCREEN;
+                screens::drawClearScreen();
+            }
+            displayMessage("Connected to " + wifiManager.getTargetSSID());
+        } else if (state == WiFiManager::ConnectionState::FAILED) {
+            String ssid = connectingSSID;
+            bool staleSaved = connectingSaved && wifiManager.failedOnCredentials() && wifiManager.getTargetSSID() == ssid;
+            connectingSSID = "";
+            connectingPassword = "";
+            connectingSaved = false;
+            if (staleSaved) {
+                // The stored password no longer works: drop it and ask for the new one.
+                forgetNetwork(ssid);
+                selectedSSID = ssid;
+                passwordInput = "";
+                if (currentScreen == WIFI_SCREEN) {
+                    currentState = WiFiScreenState::PASSWORD;
+                }
+                displayMessage("Wrong password for " + ssid);
+                return;
+            }
+            if (currentScreen == WIFI_SCREEN) {
+                currentState = WiFiScreenState::LIST;
+            }
+            displayMessage("Connection failed");
+        } else if (state == WiFiManager::ConnectionState::WAITING_RETRY && wifiManager.getRetryInMs() > 0) {
+            displayMessage("Retrying " + wifiManager.getTargetSSID() + " in " + String(wifiManager.getRetryInMs() / 1000) + "s");
+        }
+    }
 
     void resetWiFiScreen() {
         currentState = WiFiScreenState::LIST;
         selectedSSID = "";
         passwordInput = "";
-        
+        networksPage = 0;
 
         WiFiManager::getInstance().setOnNetworkListUpdated([]() {
 #ifdef DEBUG_WIFI_TOUCH
@@ -31,39 +90,57 @@ namespace screens {
             }
         });
         
-        WiFiManager::getInstance().startScan();
+        WiFiManager::getInstance().setOnConnectionStateChanged(onConnectionStateChanged);
+        WiFiManager::getInstance().refreshScan();
+    }
+
+    static int networksPerPage() {
+        return PAGINATION_ROW - networksListStartRow;
+    }
+
+    static int networksPageCount(int networksCount) {
+        int perPage = networksPerPage();
+        return networksCount <= perPage ? 1 : (networksCount + perPage - 1) / perPage;
     }
 
     void drawWifiScreen() {
         WiFiManager& wifiManager = WiFiManager::getInstance();
-        wifiManager.updateScanResults();
 
         M5.Display.fillScreen(TFT_WHITE);
 
         if (currentState == WiFiScreenState::PASSWORD) {
-            bufferRow("Enter password for: " + selectedSSID, 2, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
-            bufferRow("Password: " + passwordInput, 3, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+            ArenaString prompt(arenas::frame());
+            prompt.append("Enter password for: ").append(selectedSSID);
+            bufferRow(prompt.c_str(), 2, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
+            ArenaString password(arenas::frame());
+            password.append("Password: ").append(passwordInput);
+            bufferRow(password.c_str(), 3, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
             keyboards::drawEngKeyboard();
         } else {
             bufferRow("Wi-Fi Networks", 2, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
 
-            String statusText = "Status: ";
+            ArenaString statusText(arenas::frame());
+            statusText.append("Status: ");
             if (wifiManager.isConnected()) {
-                statusText += "Connected (";
-                statusText += WiFi.SSID();
-                statusText += ")";
+                statusText.append("Connected (").append(WiFi.SSID()).append(')');
+            } else if (wifiManager.getState() == WiFiManager::ConnectionState::CONNECTING) {
+                statusText.append("Connecting to ").append(wifiManager.getTargetSSID());
+            } else if (wifiManager.getState() == WiFiManager::ConnectionState::WAITING_RETRY) {
+                statusText.append("Retrying ").append(wifiManager.getTargetSSID());
             } else if (wifiManager.isScanning()) {
-                statusText += "Scanning...";
+                statusText.append("Scanning...");
             } else {
-                statusText += "Disconnected";
+                statusText.append("Disconnected");
             }
-            bufferRow(statusText, 3, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+            bufferRow(statusText.c_str(), 3, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
 
-            Settings settings;
+            Settings& settings = Settings::getInstance();
             String lastSSID = settings.getLastConnectedSSID();
             networksListStartRow = 4;
             if (!lastSSID.isEmpty()) {
-                bufferRow("Connect Last: " + lastSSID, 4, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
+                ArenaString connectLast(arenas::frame());
+                connectLast.append("Connect Last: ").append(lastSSID);
+                bufferRow(connectLast.c_str(), 4, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
                 networksListStartRow = 5;
             }
 
@@ -73,9 +150,22 @@ namespace screens {
             if (networksCount == 0 && !wifiManager.isScanning()) {
                 bufferRow("No WiFi found, press Rfrsh", networksListStartRow, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
             } else {
-                for (int i = 0; i < networksCount; ++i) {
-                    String signalStrength = String(networks[i].rssi) + " dBm";
-                    bufferRow(networks[i].ssid + " - " + signalStrength, networksListStartRow + i, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+                int totalPages = networksPageCount(networksCount);
+                if (networksPage >= totalPages) networksPage = totalPages - 1;
+                int startIdx = networksPage * networksPerPage();
+                int endIdx = std::min(startIdx + networksPerPage(), networksCount);
+                for (int i = startIdx; i < endIdx; ++i) {
+                    ArenaString row(arenas::frame());
+                    row.append(networks[i].ssid.c_str(), networks[i].ssid.length()).append(" - ").append((int)networks[i].rssi).append(" dBm");
+                    if (CredentialStore::getInstance().find(networks[i].ssid)) {
+                        row.append(" [saved]");
+                    }
+                    bufferRow(row.c_str(), networksListStartRow + (i - startIdx), TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+                }
+                if (totalPages > 1) {
+                    ArenaString pagination(arenas::frame());
+                    pagination.append("<--   ").append(networksPage + 1).append('/').append(totalPages).append("   -->");
+                    bufferRow(pagination.c_str(), PAGINATION_ROW, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, true);
                 }
             }
         }
@@ -94,18 +184,16 @@ namespace screens {
             keyboards::toggleKeyboardState();
         } else if (key == ">") {
             if (!selectedSSID.isEmpty() && !passwordInput.isEmpty()) {
-                displayMessage("Connecting...");
-                if (WiFiManager::getInstance().connect(selectedSSID, passwordInput)) {
-                    displayMessage("Connected to " + selectedSSID);
-                    Settings settings;
-                    settings.setLastConnectedSSID(selectedSSID);
-                    settings.setLastConnectedPassword(passwordInput);
-                    currentScreen = MAIN_SCREEN;
-                    screens::drawClearScreen();
-                } else {
+                connectingSSID = selectedSSID;
+                connectingPassword = passwordInput;
+                connectingSaved = false;
+                currentState = WiFiScreenState::LIST;
+                if (!WiFiManager::getInstance().connect(selectedSSID, passwordInput)) {
                     displayMessage("Connection failed");
-                    currentState = WiFiScreenState::LIST;
+                } else if (WiFiManager::getInstance().getState() == WiFiManager::ConnectionState::CONNECTING) {
+                    displayMessage("Connecting...");
                 }
+                return;
             }
         } else {
             passwordInput += key;
@@ -113,6 +201,18 @@ namespace screens {
         renderCurrentScreen();
     }
 
+    // Index into the scan results of the network row at y, or -1.
+    static int networkIndexAt(int y) {
+        int networksStartRow = Settings::getInstance().getLastConnectedSSID().isEmpty() ? 4 : 5;
+        int networksStartY = networksStartRow * 60;
+        if (y < networksStartY || y >= PAGINATION_ROW * 60) return -1;
+        int networkIndex = networksPage * networksPerPage() + (y - networksStartY) / 60;
+    #ifdef DEBUG_WIFI_TOUCH
+        Serial.printf("WiFiScreenTouch: y=%d, networksStartY=%d, networksStartRow=%d, ROW_HEIGHT=60, index=%d, networksCount=%d\n", y, networksStartY, networksStartRow, networkIndex, WiFiManager::getInstance().getNetworksCount());
+    #endif
+        return networkIndex < WiFiManager::getInstance().getNetworksCount() ? networkIndex : -1;
+    }
+
     void handleWiFiScreenTouch(int x, int y) {
         if (y > EPD_HEIGHT - 60) {
             return;
@@ -127,7 +227,7 @@ namespace screens {
         }
 
 
-        Settings settings;
+        Settings& settings = Settings::getInstance();
         String lastSSID = settings.getLastConnectedSSID();
         
 
@@ -136,14 +236,15 @@ namespace screens {
         if (!lastSSID.isEmpty() && y >= 240 && y < 300) {
             String lastPassword = settings.getLastConnectedPassword();
             if (!lastSSID.isEmpty() && !lastPassword.isEmpty()) {
-                displayMessage("Connecting to last...");
-                if (WiFiManager::getInstance().connect(lastSSID, lastPassword)) {
-                    displayMessage("Connected to " + lastSSID);
-                    currentScreen = MAIN_SCREEN;
-                    screens::drawClearScreen();
-                } else {
+                connectingSSID = lastSSID;
+                connectingPassword = lastPassword;
+                connectingSaved = true;
+                if (!WiFiManager::getInstance().connect(lastSSID, lastPassword)) {
                     displayMessage("Connection failed");
+                } else if (WiFiManager::getInstance().getState() == WiFiManager::ConnectionState::CONNECTING) {
+                    displayMessage("Connecting to last...");
                 }
+                return;
             } else {
                 displayMessage("Last network info missing");
             }
@@ -155,27 +256,50 @@ namespace screens {
         int networksCount = WiFiManager::getInstance().getNetworksCount();
         
 
-        int networksStartRow = lastSSID.isEmpty() ? 4 : 5;
-        int networksStartY = networksStartRow * 60;
-        
+        int totalPages = networksPageCount(networksCount);
 
-        if (y >= networksStartY && networksCount > 0) {
+        if (totalPages > 1 && y >= PAGINATION_ROW * 60) {
+            if (x < EPD_WIDTH / 3 && networksPage > 0) {
+                networksPage--;
+                renderCurrentScreen();
+            } else if (x >= EPD_WIDTH * 2 / 3 && networksPage < totalPages - 1) {
+                networksPage++;
+                renderCurrentScreen();
+            }
+            return;
+        }
 
-            int networkIndex = (y - networksStartY) / 60;
-            
+        int networkIndex = networkIndexAt(y);
+        if (networkIndex >= 0) {
     #ifdef DEBUG_WIFI_TOUCH
-            Serial.printf("WiFiScreenTouch: y=%d, networksStartY=%d, networksStartRow=%d, ROW_HEIGHT=60, index=%d, networksCount=%d\n", y, networksStartY, networksStartRow, networkIndex, networksCount);
-            if (networkIndex >= 0 && networkIndex < networksCount) {
-                Serial.printf("Selected network: %s\n", networks[networkIndex].ssid.c_str());
-            }
+            Serial.printf("Selected network: %s\n", networks[networkIndex].ssid.c_str());
     #endif
-
-            if (networkIndex >= 0 && networkIndex < networksCount) {
-                selectedSSID = networks[networkIndex].ssid;
-                passwordInput = "";
-                currentState = WiFiScreenState::PASSWORD;
-                renderCurrentScreen();
+            const WiFiProfile* profile = CredentialStore::getInstance().find(networks[networkIndex].ssid);
+            if (profile) {
+                connectingSSID = profile->ssid;
+                connectingPassword = profile->password;
+                connectingSaved = true;
+                const auto& network = networks[networkIndex];
+                if (WiFiManager::getInstance().connect(profile->ssid, profile->password, network.channel, network.bssid) &&
+                    WiFiManager::getInstance().getState() == WiFiManager::ConnectionState::CONNECTING) {
+                    displayMessage(String("Connecting to ") + network.ssid.c_str() + "...");
+                }
+                return;
             }
+            selectedSSID = networks[networkIndex].ssid.c_str();
+            passwordInput = "";
+            currentState = WiFiScreenState::PASSWORD;
+            renderCurrentScreen();
         }
     }
+
+    void handleWiFiGesture(const gestures::Gesture& gesture) {
+        if (gesture.type != gestures::GESTURE_LONG_PRESS || currentState != WiFiScreenState::LIST) return;
+        int networkIndex = networkIndexAt(gesture.y);
+        if (networkIndex < 0) return;
+        String ssid = WiFiManager::getInstance().getNetworks()[networkIndex].ssid.c_str();
+        if (!CredentialStore::getInstance().find(ssid)) return;
+        forgetNetwork(ssid);
+        displayMessage("Forgot " + ssid);
+    }
 }
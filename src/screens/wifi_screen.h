@@ -5,11 +5,13 @@
 #include <functional>
 #include <vector>
 #include "../network/wifi_manager.h"
+#include "../services/gestures.h"
 
 namespace screens {
 
     void drawWifiScreen();
     void handleWiFiScreenTouch(int x, int y);
+    void handleWiFiGesture(const gestures::Gesture& gesture);
     void resetWiFiScreen();
 
 }
@@ -5,6 +5,16 @@
 #include "sd_gateway.h"
 #include "debug_config.h"
 #include "ui.h"
+#include "settings.h"
+#include "gateway/file_api.h"
+#include "gateway/zip_stream.h"
+#include "gateway/chunked_upload.h"
+#include "gateway/sync_manifest.h"
+#include "gateway/events.h"
+#include "gateway/telemetry_api.h"
+#include "gateway/gateway_util.h"
+#include "services/profiler.h"
+#include "services/heap_telemetry.h"
 
 namespace sd_gateway {
     static bool active = false;
@@ -15,6 +25,7 @@ namespace sd_gateway {
     uint16_t getPort() { return serverPort; }
 
     void handleRoot() {
+        PROFILE_SCOPE("gateway.handleRoot");
         String html = "<html><head><title>SD Gateway</title></head><body>";
         html += "<h2>SD Gateway</h2>";
         html += "<form method='POST' action='/upload' enctype='multipart/form-data'>";
@@ -40,26 +51,42 @@ namespace sd_gateway {
         html += "</ul>";
         html += "<input type='submit' value='Delete selected'>";
         html += "</form>";
+        html += "<p id='status'></p>";
+        html += "<script>";
+        html += "var ws=new WebSocket('ws://'+location.hostname+':" + String(serverPort + 1) + "/');";
+        html += "ws.onmessage=function(e){var m=JSON.parse(e.data);";
+        html += "if(m.type=='fs'){clearTimeout(window.rt);window.rt=setTimeout(function(){location.reload();},500);}";
+        html += "else if(m.type=='upload'){document.getElementById('status').innerText='Uploading '+m.path+': '+m.received+' bytes';}";
+        html += "else if(m.type=='metrics'){document.getElementById('status').innerText='Battery '+m.battery+'%, heap '+m.heapFree+' B, render '+m.renderMs+' ms';}};";
+        html += "</script>";
         html += "</body></html>";
         server->send(200, "text/html", html);
     }
 
     void handleUpload() {
+        PROFILE_SCOPE("gateway.handleUpload");
         HTTPUpload& upload = server->upload();
         static File uploadFile;
+        static String uploadPath;
         if (upload.status == UPLOAD_FILE_START) {
-            String filename = "/" + upload.filename;
-            uploadFile = SD.open(filename, FILE_WRITE);
+            uploadPath = "/" + upload.filename;
+            uploadFile = SD.open(uploadPath, FILE_WRITE);
         } else if (upload.status == UPLOAD_FILE_WRITE) {
             if (uploadFile) uploadFile.write(upload.buf, upload.currentSize);
+            gateway_events::notifyUploadProgress(uploadPath, upload.totalSize, 0);
         } else if (upload.status == UPLOAD_FILE_END) {
-            if (uploadFile) uploadFile.close();
+            if (uploadFile) {
+                uploadFile.close();
+                gateway_events::notifyUploadProgress(uploadPath, upload.totalSize, upload.totalSize);
+                gateway_events::notifyFileChanged(uploadPath, "created");
+            }
             server->sendHeader("Location", "/");
             server->send(303);
         }
     }
 
     void handleDelete() {
+        PROFILE_SCOPE("gateway.handleDelete");
         if (!server->hasArg("file")) {
             server->send(400, "text/plain", "Missing file param");
             return;
@@ -72,6 +99,7 @@ namespace sd_gateway {
         #endif
         if (SD.exists(filename)) {
             SD.remove(filename);
+            gateway_events::notifyFileChanged(filename, "deleted");
             server->sendHeader("Location", "/");
             server->send(303);
         } else {
@@ -80,6 +108,7 @@ namespace sd_gateway {
     }
 
     void handleDeleteMulti() {
+        PROFILE_SCOPE("gateway.handleDeleteMulti");
         if (!server->hasArg("file")) {
             server->sendHeader("Location", "/");
             server->send(303);
@@ -96,6 +125,7 @@ namespace sd_gateway {
                 #endif
                 if (SD.exists(filename)) {
                     SD.remove(filename);
+                    gateway_events::notifyFileChanged(filename, "deleted");
                 }
             }
         }
@@ -104,6 +134,7 @@ namespace sd_gateway {
     }
 
     void handleEditGet() {
+        PROFILE_SCOPE("gateway.handleEditGet");
         if (!server->hasArg("file")) {
             server->send(400, "text/plain", "Missing file param");
             return;
@@ -145,6 +176,7 @@ namespace sd_gateway {
     }
 
     void handleEditPost() {
+        PROFILE_SCOPE("gateway.handleEditPost");
         if (!server->hasArg("file") || !server->hasArg("content")) {
             server->send(400, "text/plain", "Missing file or content param");
             return;
@@ -159,11 +191,13 @@ namespace sd_gateway {
         }
         file.print(content);
         file.close();
+        gateway_events::notifyFileChanged(filename, "modified");
         server->sendHeader("Location", "/");
         server->send(303);
     }
 
     void handleList() {
+        PROFILE_SCOPE("gateway.handleList");
         String json = "[";
         File root = SD.open("/");
         bool first = true;
@@ -186,6 +220,11 @@ namespace sd_gateway {
             displayMessage("SD init error");
             return;
         }
+        if (!gateway_util::acquireIoBuffers()) {
+            displayMessage("Gateway: out of memory");
+            return;
+        }
+        serverPort = (uint16_t)Settings::getInstance().getInt(SETTING_GATEWAY_PORT);
         server = new WebServer(serverPort);
         server->on("/", HTTP_GET, handleRoot);
         server->on("/upload", HTTP_POST, [](){ server->send(200); }, handleUpload);
@@ -194,16 +233,27 @@ namespace sd_gateway {
         server->on("/edit", HTTP_GET, handleEditGet);
         server->on("/edit", HTTP_POST, handleEditPost);
         server->on("/list", HTTP_GET, handleList);
+        gateway_file_api::registerRoutes(server);
+        gateway_zip::registerRoutes(server);
+        gateway_upload::registerRoutes(server);
+        gateway_sync::registerRoutes(server);
+        gateway_telemetry::registerRoutes(server);
         server->begin();
+        gateway_events::begin(serverPort + 1);
+        configTime(0, 0, "pool.ntp.org");
         active = true;
     }
 
     void stopServer() {
+        gateway_file_api::closeCursors();
+        gateway_upload::closeSessions();
+        gateway_events::stop();
         if (server) {
             server->close();
             delete server;
             server = nullptr;
         }
+        gateway_util::releaseIoBuffers();
         active = false;
     }
 
@@ -223,7 +273,9 @@ namespace sd_gateway {
 
     void loop() {
         if (active && server) {
+            HEAP_TAG(HEAP_GATEWAY);
             server->handleClient();
+            gateway_events::loop();
         }
     }
 }
\ No newline at end of file
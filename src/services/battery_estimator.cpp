@@ -0,0 +1,287 @@
+#include "battery_estimator.h"
+#include <M5Unified.h>
+#include "power_telemetry.h"
+#include "serial_console.h"
+#include "../settings.h"
+#include "../debug_config.h"
+
+namespace battery_estimator {
+    static const unsigned long SAMPLE_INTERVAL_MS = 10000;
+    static const unsigned long HISTORY_INTERVAL_MS = 60000;
+    static const unsigned long LOAD_SETTLE_MS = 2000;
+    static const int RAW_READS = 3;
+    static const float FILTER_ALPHA = 0.1f;
+    static const float CURRENT_ALPHA = 0.05f;
+    static const float TRANSIENT_MV = 60.0f;
+    static const int TRANSIENT_CONFIRM = 3;
+
+    // A learning pass starts above the top knot and ends on crossing the
+    // 3.5 V knot, which keeps its configured percentage as the anchor.
+    static const float LEARN_START_MV = 4050.0f;
+    static const int LEARN_END_KNOT = 1;
+    static const float LEARN_MIN_MAH = 50.0f;
+
+    static const uint8_t DEFAULT_CURVE[CURVE_POINTS] = { 0, 10, 30, 55, 75, 90, 100 };
+
+    // Modelled draw per power state in mA. Wi-Fi is added on top of the
+    // others. Learned capacity is in the same units, so only the ratios matter.
+    static const float STATE_CURRENT_MA[power_telemetry::POWER_STATE_COUNT] = {
+        150.0f, // EPD
+        80.0f,  // SD
+        90.0f,  // Wi-Fi
+        45.0f,  // CPU
+        3.0f    // sleep
+    };
+
+    struct LearnSession {
+        bool active;
+        int nextKnot;
+        float consumedMah;
+        float knotMah[CURVE_POINTS];
+    };
+
+    static uint8_t curve[CURVE_POINTS];
+    static Estimate estimate = { 0, 0, false, 0.0f, -1.0f, 0 };
+    static LearnSession session = {};
+
+    static float filteredMv = 0.0f;
+    static bool filterSeeded = false;
+    static int transientCount = 0;
+
+    static uint64_t lastStateUs[power_telemetry::POWER_STATE_COUNT] = {};
+    static uint64_t lastLoadUs = 0;
+    static unsigned long lastLoadChange = 0;
+    static unsigned long lastSample = 0;
+    static unsigned long lastHistory = 0;
+    static bool started = false;
+
+    static uint16_t knotMillivolts(int knot) {
+        return CURVE_MIN_MV + knot * CURVE_STEP_MV;
+    }
+
+    static bool parseCurve(const String& text, uint8_t* out) {
+        int start = 0;
+        for (int i = 0; i < CURVE_POINTS; ++i) {
+            int comma = text.indexOf(',', start);
+            if ((comma < 0) != (i == CURVE_POINTS - 1)) return false;
+            long value = text.substring(start, comma < 0 ? text.length() : comma).toInt();
+            if (value < 0 || value > 100 || (i > 0 && value < out[i - 1])) return false;
+            out[i] = (uint8_t)value;
+            start = comma + 1;
+        }
+        return true;
+    }
+
+    static String formatCurve(const uint8_t* values) {
+        String text;
+        for (int i = 0; i < CURVE_POINTS; ++i) {
+            if (i > 0) text += ",";
+            text += String(values[i]);
+        }
+        return text;
+    }
+
+    static void loadCurve() {
+        if (!parseCurve(Settings::getInstance().getString(SETTING_BATTERY_CURVE), curve)) {
+            memcpy(curve, DEFAULT_CURVE, sizeof(curve));
+        }
+        estimate.capacityMah = (uint16_t)Settings::getInstance().getInt(SETTING_BATTERY_CAPACITY);
+    }
+
+    int percentFromMillivolts(float millivolts) {
+        if (millivolts <= CURVE_MIN_MV) return curve[0];
+        float position = (millivolts - CURVE_MIN_MV) / CURVE_STEP_MV;
+        int knot = (int)position;
+        if (knot >= CURVE_POINTS - 1) return curve[CURVE_POINTS - 1];
+        float fraction = position - knot;
+        return (int)(curve[knot] + (curve[knot + 1] - curve[knot]) * fraction + 0.5f);
+    }
+
+    void getCurve(uint8_t* out) {
+        memcpy(out, curve, sizeof(curve));
+    }
+
+    static float readMillivolts() {
+        int reads[RAW_READS];
+        for (int i = 0; i < RAW_READS; ++i) {
+            reads[i] = M5.Power.getBatteryVoltage();
+        }
+        for (int i = 1; i < RAW_READS; ++i) {
+            for (int j = i; j > 0 && reads[j] < reads[j - 1]; --j) {
+                int swap = reads[j];
+                reads[j] = reads[j - 1];
+                reads[j - 1] = swap;
+            }
+        }
+        return (float)reads[RAW_READS / 2];
+    }
+
+    // Returns false when the reading looks like a load transient.
+    static bool filterSample(float millivolts) {
+        if (!filterSeeded) {
+            filteredMv = millivolts;
+            filterSeeded = true;
+            return true;
+        }
+        if (fabsf(millivolts - filteredMv) > TRANSIENT_MV) {
+            if (++transientCount < TRANSIENT_CONFIRM) return false;
+            filteredMv = millivolts;
+        } else {
+            filteredMv += FILTER_ALPHA * (millivolts - filteredMv);
+        }
+        transientCount = 0;
+        return true;
+    }
+
+    static float consumedSinceLastSample() {
+        float mah = 0.0f;
+        for (int state = 0; state < power_telemetry::POWER_STATE_COUNT; ++state) {
+            uint64_t now = power_telemetry::getTimeUs((power_telemetry::PowerState)state);
+            uint64_t delta = now > lastStateUs[state] ? now - lastStateUs[state] : 0;
+            lastStateUs[state] = now;
+            mah += STATE_CURRENT_MA[state] * (float)delta / 3.6e9f;
+        }
+        return mah;
+    }
+
+    static void finishLearning() {
+        session.active = false;
+        float topMah = session.knotMah[CURVE_POINTS - 1];
+        float spanMah = session.knotMah[LEARN_END_KNOT] - topMah;
+        if (spanMah < LEARN_MIN_MAH) return;
+
+        uint8_t learned[CURVE_POINTS];
+        memcpy(learned, curve, sizeof(learned));
+        float top = curve[CURVE_POINTS - 1];
+        float end = curve[LEARN_END_KNOT];
+        for (int knot = LEARN_END_KNOT + 1; knot < CURVE_POINTS - 1; ++knot) {
+            float measured = top - (top - end) * (session.knotMah[knot] - topMah) / spanMah;
+            learned[knot] = (uint8_t)((curve[knot] + measured) / 2.0f + 0.5f);
+            if (learned[knot] < learned[knot - 1]) learned[knot] = learned[knot - 1];
+        }
+        for (int knot = CURVE_POINTS - 2; knot > LEARN_END_KNOT; --knot) {
+            if (learned[knot] > learned[knot + 1]) learned[knot] = learned[knot + 1];
+        }
+        memcpy(curve, learned, sizeof(curve));
+
+        float capacity = spanMah * 100.0f / (top - end > 1.0f ? top - end : 1.0f);
+        int blended = (int)((estimate.capacityMah + capacity) / 2.0f);
+        Settings& settings = Settings::getInstance();
+        settings.setString(SETTING_BATTERY_CURVE, formatCurve(curve));
+        if (settings.isValid(SETTING_BATTERY_CAPACITY, blended)) {
+            settings.setInt(SETTING_BATTERY_CAPACITY, blended);
+            estimate.capacityMah = (uint16_t)blended;
+        }
+#ifdef DEBUG_POWER
+        Serial.println("[Battery] Learned curve " + formatCurve(curve) + ", capacity " + String(estimate.capacityMah) + " mAh");
+#endif
+    }
+
+    static void updateLearning() {
+        if (estimate.charging) {
+            session.active = false;
+            return;
+        }
+        if (!session.active) {
+            if (filteredMv < LEARN_START_MV) return;
+            session = {};
+            session.active = true;
+            session.nextKnot = CURVE_POINTS - 1;
+        }
+        while (session.nextKnot >= LEARN_END_KNOT && filteredMv <= knotMillivolts(session.nextKnot)) {
+            session.knotMah[session.nextKnot] = session.consumedMah;
+            session.nextKnot--;
+        }
+        if (session.nextKnot < LEARN_END_KNOT) {
+            finishLearning();
+        }
+    }
+
+    static void updateEstimate(float consumedMah, unsigned long elapsedMs) {
+        estimate.millivolts = (uint16_t)filteredMv;
+        estimate.percent = (uint8_t)percentFromMillivolts(filteredMv);
+        if (elapsedMs > 0) {
+            float currentMa = consumedMah * 3.6e6f / elapsedMs;
+            estimate.currentMa = estimate.currentMa > 0.0f
+                ? estimate.currentMa + CURRENT_ALPHA * (currentMa - estimate.currentMa)
+                : currentMa;
+        }
+        estimate.remainingHours = (!estimate.charging && estimate.currentMa > 0.0f)
+            ? estimate.percent / 100.0f * estimate.capacityMah / estimate.currentMa
+            : -1.0f;
+    }
+
+    static void sample(bool force) {
+        unsigned long now = millis();
+        unsigned long elapsed = now - lastSample;
+        if (!force) {
+            if (elapsed < SAMPLE_INTERVAL_MS) return;
+            if (M5.Display.displayBusy() || now - lastLoadChange < LOAD_SETTLE_MS) return;
+        }
+        lastSample = now;
+
+        estimate.charging = M5.Power.isCharging() == m5::Power_Class::is_charging;
+        float consumedMah = consumedSinceLastSample();
+        if (session.active) session.consumedMah += consumedMah;
+        float millivolts = readMillivolts();
+        bool accepted = millivolts > 0.0f && filterSample(millivolts);
+        if (accepted) updateLearning();
+        updateEstimate(consumedMah, force ? 0 : elapsed);
+        if (!accepted) return;
+
+        if (force || now - lastHistory >= HISTORY_INTERVAL_MS) {
+            lastHistory = now;
+            power_telemetry::recordBattery(estimate.millivolts, estimate.percent);
+        }
+    }
+
+    static void printCommand(const String&) {
+        JsonDocument doc;
+        writeJson(doc.to<JsonObject>());
+        serializeJson(doc, Serial);
+        Serial.println();
+    }
+
+    void begin() {
+        if (started) return;
+        started = true;
+        loadCurve();
+        sample(true);
+        serial_console::registerCommand("battery", printCommand, "battery estimate and learned curve (JSON)");
+    }
+
+    void loop() {
+        if (!started) return;
+        uint64_t loadUs = power_telemetry::getTimeUs(power_telemetry::POWER_EPD) +
+                          power_telemetry::getTimeUs(power_telemetry::POWER_SD);
+        if (loadUs != lastLoadUs) {
+            lastLoadUs = loadUs;
+            lastLoadChange = millis();
+        }
+        sample(false);
+    }
+
+    const Estimate& get() {
+        return estimate;
+    }
+
+    void writeJson(JsonObject out) {
+        out["millivolts"] = estimate.millivolts;
+        out["percent"] = estimate.percent;
+        out["charging"] = estimate.charging;
+        out["currentMa"] = estimate.currentMa;
+        if (estimate.remainingHours >= 0.0f) {
+            out["remainingHours"] = estimate.remainingHours;
+        } else {
+            out["remainingHours"] = nullptr;
+        }
+        out["capacityMah"] = estimate.capacityMah;
+        JsonArray points = out["curve"].to<JsonArray>();
+        for (int i = 0; i < CURVE_POINTS; ++i) {
+            JsonArray point = points.add<JsonArray>();
+            point.add(knotMillivolts(i));
+            point.add(curve[i]);
+        }
+        out["learning"] = session.active;
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef BATTERY_ESTIMATOR_H
+#define BATTERY_ESTIMATOR_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+namespace battery_estimator {
+
+    // Discharge curve knots: percent at CURVE_MIN_MV + i * CURVE_STEP_MV.
+    static const int CURVE_POINTS = 7;
+    static const uint16_t CURVE_MIN_MV = 3400;
+    static const uint16_t CURVE_STEP_MV = 100;
+
+    struct Estimate {
+        uint16_t millivolts;
+        uint8_t percent;
+        bool charging;
+        float currentMa;
+        float remainingHours;
+        uint16_t capacityMah;
+    };
+
+    void begin();
+    void loop();
+
+    // Cached estimate; never touches the PMIC.
+    const Estimate& get();
+
+    int percentFromMillivolts(float millivolts);
+    void getCurve(uint8_t* out);
+
+    void writeJson(JsonObject out);
+}
+
+#endif // BATTERY_ESTIMATOR_H
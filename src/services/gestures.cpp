@@ -0,0 +1,283 @@
+#include "gestures.h"
+#include <esp_timer.h>
+#include "../settings.h"
+#include "../debug_config.h"
+
+namespace gestures {
+    struct Track {
+        bool down;
+        uint8_t id;
+        int16_t startX;
+        int16_t startY;
+        int16_t x;
+        int16_t y;
+        uint32_t lastUs;
+    };
+
+    static GestureConfig config = {
+        20,     // tapSlopPx
+        350,    // tapMaxMs
+        300,    // doubleTapMs
+        600,    // longPressMs
+        50,     // swipeMinPx
+        1000,   // swipeMaxMs
+        150,    // swipeMinVelocity
+        30      // pinchMinPx
+    };
+
+    static Track tracks[touch_input::MAX_CONTACTS] = {};
+    static bool sequenceActive = false;
+    static bool multiTouch = false;
+    static bool pinchDone = false;
+    static bool movedBeyondSlop = false;
+    static bool longPressFired = false;
+    static bool claimed = false;
+    static uint32_t sequenceStartUs = 0;
+    static float pinchStartDistance = 0;
+
+    static bool lastTapValid = false;
+    static int16_t lastTapX = 0;
+    static int16_t lastTapY = 0;
+    static uint32_t lastTapUs = 0;
+    static uint32_t lastTapStartUs = 0;
+
+    static Gesture queue[QUEUE_CAPACITY];
+    static int queueHead = 0;
+    static int queueCount = 0;
+
+    static void loadConfig() {
+        Settings& settings = Settings::getInstance();
+        config.longPressMs = (uint16_t)settings.getInt(SETTING_GESTURE_LONG_PRESS);
+        config.doubleTapMs = (uint16_t)settings.getInt(SETTING_GESTURE_DOUBLE_TAP);
+        config.swipeMinPx = (uint16_t)settings.getInt(SETTING_GESTURE_SWIPE_MIN);
+    }
+
+    void begin() {
+        loadConfig();
+        touch_input::setListener(feed);
+    }
+
+    static Gesture makeGesture(GestureType type, int16_t x, int16_t y) {
+        Gesture gesture = {};
+        gesture.type = type;
+        gesture.direction = SWIPE_NONE;
+        gesture.x = x;
+        gesture.y = y;
+        gesture.scale = 1.0f;
+        gesture.startUs = sequenceStartUs;
+        return gesture;
+    }
+
+    static void emit(const Gesture& gesture) {
+        if (claimed) return;
+        if (queueCount == QUEUE_CAPACITY) {
+            queueHead = (queueHead + 1) % QUEUE_CAPACITY;
+            queueCount--;
+        }
+        queue[(queueHead + queueCount) % QUEUE_CAPACITY] = gesture;
+        queueCount++;
+#ifdef DEBUG_TOUCH
+        Serial.printf("[Gesture] %s at (%d,%d) d=(%d,%d) v=%.0f s=%.2f\n", gestureName(gesture.type),
+                      gesture.x, gesture.y, gesture.dx, gesture.dy, gesture.velocity, gesture.scale);
+#endif
+    }
+
+    static Track* findTrack(uint8_t id) {
+        for (int i = 0; i < touch_input::MAX_CONTACTS; ++i) {
+            if (tracks[i].down && tracks[i].id == id) return &tracks[i];
+        }
+        return nullptr;
+    }
+
+    static int downCount() {
+        int count = 0;
+        for (int i = 0; i < touch_input::MAX_CONTACTS; ++i) {
+            if (tracks[i].down) count++;
+        }
+        return count;
+    }
+
+    static float distance(int dx, int dy) {
+        return sqrtf((float)(dx * dx + dy * dy));
+    }
+
+    static float trackSpan() {
+        return distance(tracks[1].x - tracks[0].x, tracks[1].y - tracks[0].y);
+    }
+
+    static void finishPinch() {
+        if (pinchDone || pinchStartDistance <= 0) return;
+        pinchDone = true;
+        float span = trackSpan();
+        if (fabsf(span - pinchStartDistance) < config.pinchMinPx) return;
+        Gesture gesture = makeGesture(GESTURE_PINCH, (tracks[0].x + tracks[1].x) / 2, (tracks[0].y + tracks[1].y) / 2);
+        gesture.scale = span / pinchStartDistance;
+        emit(gesture);
+    }
+
+    static void finishStroke(const Track& track, uint32_t endUs) {
+        if (longPressFired || claimed) {
+            lastTapValid = false;
+            return;
+        }
+        int dx = track.x - track.startX;
+        int dy = track.y - track.startY;
+        float travel = distance(dx, dy);
+        uint32_t durationMs = (endUs - sequenceStartUs) / 1000;
+
+        Gesture gesture = makeGesture(GESTURE_TAP, track.startX, track.startY);
+        gesture.dx = (int16_t)dx;
+        gesture.dy = (int16_t)dy;
+        gesture.durationMs = (uint16_t)min(durationMs, (uint32_t)UINT16_MAX);
+        gesture.velocity = travel * 1000.0f / (float)max(durationMs, (uint32_t)1);
+
+        if (!movedBeyondSlop) {
+            if (durationMs > config.tapMaxMs) return;
+            emit(gesture);
+            bool repeat = lastTapValid && sequenceStartUs - lastTapUs <= (uint32_t)config.doubleTapMs * 1000 &&
+                          abs(track.startX - lastTapX) <= 2 * config.tapSlopPx &&
+                          abs(track.startY - lastTapY) <= 2 * config.tapSlopPx;
+            if (repeat) {
+                gesture.type = GESTURE_DOUBLE_TAP;
+                emit(gesture);
+                lastTapValid = false;
+            } else {
+                lastTapValid = true;
+                lastTapX = track.startX;
+                lastTapY = track.startY;
+                lastTapUs = endUs;
+                lastTapStartUs = sequenceStartUs;
+            }
+            return;
+        }
+
+        lastTapValid = false;
+        if (travel >= config.swipeMinPx && durationMs <= config.swipeMaxMs &&
+            gesture.velocity >= config.swipeMinVelocity) {
+            gesture.type = GESTURE_SWIPE;
+            if (abs(dx) > abs(dy)) {
+                gesture.direction = dx > 0 ? SWIPE_RIGHT : SWIPE_LEFT;
+            } else {
+                gesture.direction = dy > 0 ? SWIPE_DOWN : SWIPE_UP;
+            }
+        } else {
+            gesture.type = GESTURE_PAN;
+        }
+        emit(gesture);
+    }
+
+    void feed(const touch_input::TouchEvent& event) {
+        switch (event.type) {
+            case touch_input::TOUCH_DOWN: {
+                Track* track = nullptr;
+                for (int i = 0; i < touch_input::MAX_CONTACTS && !track; ++i) {
+                    if (!tracks[i].down) track = &tracks[i];
+                }
+                if (!track) return;
+                *track = { true, event.id, event.x, event.y, event.x, event.y, event.timeUs };
+                if (!sequenceActive) {
+                    loadConfig();
+                    sequenceActive = true;
+                    multiTouch = false;
+                    pinchDone = false;
+                    movedBeyondSlop = false;
+                    longPressFired = false;
+                    claimed = false;
+                    sequenceStartUs = event.timeUs;
+                } else if (downCount() == 2) {
+                    multiTouch = true;
+                    pinchStartDistance = trackSpan();
+                }
+                break;
+            }
+            case touch_input::TOUCH_MOVE: {
+                Track* track = findTrack(event.id);
+                if (!track) return;
+                track->x = event.x;
+                track->y = event.y;
+                track->lastUs = event.timeUs;
+                if (distance(track->x - track->startX, track->y - track->startY) > config.tapSlopPx) {
+                    movedBeyondSlop = true;
+                }
+                break;
+            }
+            case touch_input::TOUCH_UP: {
+                Track* track = findTrack(event.id);
+                if (!track) return;
+                track->x = event.x;
+                track->y = event.y;
+                if (multiTouch) {
+                    if (downCount() == 2) finishPinch();
+                } else {
+                    finishStroke(*track, event.timeUs);
+                }
+                track->down = false;
+                if (downCount() == 0) {
+                    sequenceActive = false;
+                }
+                break;
+            }
+        }
+    }
+
+    void update() {
+        if (!sequenceActive || multiTouch || movedBeyondSlop || longPressFired || claimed) return;
+        uint32_t now = (uint32_t)esp_timer_get_time();
+        if (now - sequenceStartUs < (uint32_t)config.longPressMs * 1000) return;
+        for (int i = 0; i < touch_input::MAX_CONTACTS; ++i) {
+            if (!tracks[i].down) continue;
+            Gesture gesture = makeGesture(GESTURE_LONG_PRESS, tracks[i].startX, tracks[i].startY);
+            gesture.durationMs = (uint16_t)((now - sequenceStartUs) / 1000);
+            emit(gesture);
+            longPressFired = true;
+            lastTapValid = false;
+            return;
+        }
+    }
+
+    bool next(Gesture& out) {
+        if (queueCount == 0) return false;
+        out = queue[queueHead];
+        queueHead = (queueHead + 1) % QUEUE_CAPACITY;
+        queueCount--;
+        return true;
+    }
+
+    bool peek(Gesture& out) {
+        if (queueCount == 0) return false;
+        out = queue[queueHead];
+        return true;
+    }
+
+    int pending() {
+        return queueCount;
+    }
+
+    void claim(uint32_t downUs) {
+        if (sequenceActive && sequenceStartUs == downUs) {
+            claimed = true;
+        }
+        int kept = 0;
+        for (int i = 0; i < queueCount; ++i) {
+            const Gesture& gesture = queue[(queueHead + i) % QUEUE_CAPACITY];
+            if (gesture.startUs == downUs) continue;
+            queue[(queueHead + kept) % QUEUE_CAPACITY] = gesture;
+            kept++;
+        }
+        queueCount = kept;
+        if (lastTapValid && lastTapStartUs == downUs) {
+            lastTapValid = false;
+        }
+    }
+
+    const GestureConfig& getConfig() {
+        return config;
+    }
+
+    const char* gestureName(GestureType type) {
+        static const char* const NAMES[GESTURE_TYPE_COUNT] = {
+            "Tap", "Double tap", "Long press", "Swipe", "Pan", "Pinch"
+        };
+        return type < GESTURE_TYPE_COUNT ? NAMES[type] : "?";
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef GESTURES_H
+#define GESTURES_H
+
+#include <Arduino.h>
+#include "touch_input.h"
+
+// Recognises tap, double-tap, long-press, swipe, pan and pinch from the raw
+// touch_input stream. Screens subscribe through their ScreenDescriptor.
+namespace gestures {
+
+    enum GestureType : uint8_t {
+        GESTURE_TAP,
+        GESTURE_DOUBLE_TAP,
+        GESTURE_LONG_PRESS,
+        GESTURE_SWIPE,
+        GESTURE_PAN,
+        GESTURE_PINCH,
+        GESTURE_TYPE_COUNT
+    };
+
+    enum SwipeDirection : uint8_t {
+        SWIPE_NONE,
+        SWIPE_LEFT,
+        SWIPE_RIGHT,
+        SWIPE_UP,
+        SWIPE_DOWN
+    };
+
+    struct Gesture {
+        GestureType type;
+        SwipeDirection direction;
+        int16_t x;          // start point; pinch centre
+        int16_t y;
+        int16_t dx;         // displacement at release
+        int16_t dy;
+        uint16_t durationMs;
+        float velocity;     // px/s over the whole stroke
+        float scale;        // pinch: final / initial finger distance
+        uint32_t startUs;   // timestamp of the primary TOUCH_DOWN
+    };
+
+    struct GestureConfig {
+        uint16_t tapSlopPx;
+        uint16_t tapMaxMs;
+        uint16_t doubleTapMs;
+        uint16_t longPressMs;
+        uint16_t swipeMinPx;
+        uint16_t swipeMaxMs;
+        uint16_t swipeMinVelocity;
+        uint16_t pinchMinPx;
+    };
+
+    static const int QUEUE_CAPACITY = 8;
+
+    constexpr uint8_t gestureBit(GestureType type) {
+        return (uint8_t)(1 << type);
+    }
+
+    void begin();
+
+    // Fires time-based gestures (long press); call every loop.
+    void update();
+
+    void feed(const touch_input::TouchEvent& event);
+
+    bool next(Gesture& out);
+    bool peek(Gesture& out);
+    int pending();
+
+    // The touch that started at `downUs` was consumed as a press; drop its gestures.
+    void claim(uint32_t downUs);
+
+    // Long-press, double-tap and swipe distance follow the gesture.* settings.
+    const GestureConfig& getConfig();
+
+    const char* gestureName(GestureType type);
+}
+
+#endif // GESTURES_H
@@ -0,0 +1,104 @@
+#include "heap_sites.h"
+
+#ifdef HEAP_TELEMETRY_SITES
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <new>
+
+namespace heap_sites {
+    // Open addressing on the return address; the table never allocates, so
+    // recording from inside operator new cannot recurse. Single-threaded hosts only.
+    static Site sites[MAX_SITES] = {};
+    static uint32_t droppedAllocs = 0;
+
+    static size_t slotOf(const void* address) {
+        uintptr_t value = (uintptr_t)address;
+        return (size_t)((value >> 2) ^ (value >> 12)) % MAX_SITES;
+    }
+
+    void record(const void* address, size_t bytes) {
+        size_t slot = slotOf(address);
+        for (int probe = 0; probe < MAX_SITES; ++probe) {
+            Site& site = sites[(slot + probe) % MAX_SITES];
+            if (site.address == address || site.address == nullptr) {
+                site.address = address;
+                site.allocs++;
+                site.bytes += bytes;
+                return;
+            }
+        }
+        droppedAllocs++;
+    }
+
+    void reset() {
+        memset(sites, 0, sizeof(sites));
+        droppedAllocs = 0;
+    }
+
+    int snapshot(Site* out, int maxCount) {
+        int count = 0;
+        for (int i = 0; i < MAX_SITES; ++i) {
+            if (sites[i].address == nullptr) continue;
+            // Insertion into the busiest-first prefix; the table is small.
+            int position = count;
+            while (position > 0 && out[position - 1].allocs < sites[i].allocs) position--;
+            if (position >= maxCount) continue;
+            for (int j = count < maxCount ? count : maxCount - 1; j > position; --j) {
+                out[j] = out[j - 1];
+            }
+            out[position] = sites[i];
+            if (count < maxCount) count++;
+        }
+        return count;
+    }
+
+    uint32_t dropped() {
+        return droppedAllocs;
+    }
+
+    void printReport(Print& out, int maxCount) {
+        Site top[MAX_SITES];
+        int count = snapshot(top, maxCount < MAX_SITES ? maxCount : MAX_SITES);
+        for (int i = 0; i < count; ++i) {
+            Dl_info info;
+            if (dladdr(top[i].address, &info) && info.dli_fname) {
+                const char* name = strrchr(info.dli_fname, '/');
+                out.printf("%8lu %10llu  %s+0x%lx\n", (unsigned long)top[i].allocs, (unsigned long long)top[i].bytes,
+                           name ? name + 1 : info.dli_fname,
+                           (unsigned long)((uintptr_t)top[i].address - (uintptr_t)info.dli_fbase));
+            } else {
+                out.printf("%8lu %10llu  %p\n", (unsigned long)top[i].allocs, (unsigned long long)top[i].bytes, top[i].address);
+            }
+        }
+        if (droppedAllocs > 0) {
+            out.printf("%lu allocations from untracked sites\n", (unsigned long)droppedAllocs);
+        }
+    }
+}
+
+// Replacing the global operators covers new, new[] and the containers and
+// strings built on them, including allocations made inside libstdc++. They
+// must not be inlined, or the return address would be the caller's caller.
+static void* allocateAt(size_t size, const void* caller) {
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    heap_sites::record(caller, size);
+    return ptr;
+}
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    return allocateAt(size, __builtin_return_address(0));
+}
+
+__attribute__((noinline)) void* operator new[](size_t size) {
+    return allocateAt(size, __builtin_return_address(0));
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+__attribute__((noinline)) void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+#endif // HEAP_TELEMETRY_SITES
@@ -0,0 +1,33 @@
+#ifndef HEAP_SITES_H
+#define HEAP_SITES_H
+
+#include <Arduino.h>
+
+// Allocation call sites, recorded in host builds only (HEAP_TELEMETRY_SITES,
+// set by the native env): operator new is replaced and every allocation is
+// counted against its return address. Addresses are reported relative to the
+// module they belong to, so `addr2line -e <binary> <offset>` names the line.
+// The device build compiles none of this and relies on the heap_telemetry tags.
+namespace heap_sites {
+
+    struct Site {
+        const void* address;
+        uint32_t allocs;
+        uint64_t bytes;
+    };
+
+    static const int MAX_SITES = 256;
+
+    void record(const void* address, size_t bytes);
+    void reset();
+
+    // Copies the busiest sites (by allocation count) into `out`; returns how many.
+    int snapshot(Site* out, int maxCount);
+
+    // Allocations that found no free table slot.
+    uint32_t dropped();
+
+    void printReport(Print& out, int maxCount = 20);
+}
+
+#endif // HEAP_SITES_H
@@ -0,0 +1,244 @@
+#include "heap_telemetry.h"
+#include <esp_heap_caps.h>
+#include <soc/soc_memory_layout.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "serial_console.h"
+#include "../arena.h"
+#include "../pools.h"
+
+namespace heap_telemetry {
+    static const char* const TAG_NAMES[HEAP_TAG_COUNT] = {
+        "other tasks", "loop", "ui", "reader", "image", "files", "games", "gateway", "network", "settings"
+    };
+    static const char* const REGION_NAMES[REGION_COUNT] = { "internal", "psram" };
+    static const uint32_t REGION_CAPS[REGION_COUNT] = { MALLOC_CAP_INTERNAL, MALLOC_CAP_SPIRAM };
+
+    static portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+    static TagStats tags[HEAP_TAG_COUNT] = {};
+    static RegionStats regions[REGION_COUNT] = {};
+    static FrameStats frame = {};
+    static uint32_t frameAllocs = 0;
+    static uint32_t frameBytes = 0;
+    static int frameDepth = 0;
+
+    static TaskHandle_t loopTask = nullptr;
+    static volatile HeapTag loopTag = HEAP_LOOP;
+    static bool started = false;
+
+    static void printCommand(const String&) {
+        printReport(Serial);
+    }
+
+    void begin() {
+        if (started) return;
+        started = true;
+        loopTask = xTaskGetCurrentTaskHandle();
+        serial_console::registerCommand("heap", printCommand, "heap regions, pools, per-subsystem allocations and per-frame churn (JSON)");
+    }
+
+    HeapTag setTag(HeapTag tag) {
+        HeapTag previous = loopTag;
+        loopTag = tag;
+        return previous;
+    }
+
+    HeapTag currentTag() {
+        return loopTag;
+    }
+
+    static bool onLoopTask() {
+        return loopTask != nullptr && xTaskGetCurrentTaskHandle() == loopTask;
+    }
+
+    void beginFrame() {
+        if (frameDepth++ == 0) {
+            frameAllocs = 0;
+            frameBytes = 0;
+        }
+    }
+
+    void endFrame() {
+        if (frameDepth == 0 || --frameDepth > 0) return;
+        frame.frames++;
+        frame.lastAllocs = frameAllocs;
+        frame.lastBytes = frameBytes;
+        if (frameAllocs > frame.maxAllocs) frame.maxAllocs = frameAllocs;
+        if (frameAllocs == 0) frame.allocationFreeFrames++;
+    }
+
+    static HeapRegion regionOf(const void* ptr) {
+        return esp_ptr_external_ram(ptr) ? REGION_PSRAM : REGION_INTERNAL;
+    }
+
+    void noteAlloc(void* ptr, size_t requested) {
+        bool loop = onLoopTask();
+        HeapTag tag = loop ? loopTag : HEAP_OTHER_TASKS;
+        size_t size = ptr ? heap_caps_get_allocated_size(ptr) : 0;
+        HeapRegion region = regionOf(ptr);
+
+        portENTER_CRITICAL(&statsLock);
+        if (!ptr) {
+            tags[tag].failures++;
+        } else {
+            tags[tag].allocs++;
+            tags[tag].bytes += size;
+            RegionStats& stats = regions[region];
+            stats.allocs++;
+            stats.liveBlocks++;
+            stats.liveBytes += size;
+            if (stats.liveBytes > stats.peakBytes) stats.peakBytes = stats.liveBytes;
+            if (loop && frameDepth > 0) {
+                frameAllocs++;
+                frameBytes += requested;
+            }
+        }
+        portEXIT_CRITICAL(&statsLock);
+    }
+
+    static void releaseBlock(size_t size, HeapRegion region) {
+        portENTER_CRITICAL(&statsLock);
+        RegionStats& stats = regions[region];
+        stats.frees++;
+        // Blocks allocated before the wrappers saw them would drive these negative.
+        if (stats.liveBlocks > 0) stats.liveBlocks--;
+        stats.liveBytes = stats.liveBytes > size ? stats.liveBytes - size : 0;
+        portEXIT_CRITICAL(&statsLock);
+    }
+
+    void noteFree(void* ptr) {
+        releaseBlock(heap_caps_get_allocated_size(ptr), regionOf(ptr));
+    }
+
+    // realloc only releases the old block when it succeeds, so its size and
+    // region are captured before the call and accounted afterwards.
+    static void noteResize(size_t oldSize, HeapRegion oldRegion) {
+        releaseBlock(oldSize, oldRegion);
+    }
+
+    TagStats getTagStats(HeapTag tag) {
+        portENTER_CRITICAL(&statsLock);
+        TagStats stats = tags[tag < HEAP_TAG_COUNT ? tag : HEAP_LOOP];
+        portEXIT_CRITICAL(&statsLock);
+        return stats;
+    }
+
+    RegionStats getRegionStats(HeapRegion region) {
+        portENTER_CRITICAL(&statsLock);
+        RegionStats stats = regions[region];
+        portEXIT_CRITICAL(&statsLock);
+        uint32_t caps = REGION_CAPS[region] | MALLOC_CAP_8BIT;
+        stats.freeBytes = heap_caps_get_free_size(caps);
+        stats.minFreeBytes = heap_caps_get_minimum_free_size(caps);
+        stats.largestFreeBlock = heap_caps_get_largest_free_block(caps);
+        return stats;
+    }
+
+    FrameStats getFrameStats() {
+        return frame;
+    }
+
+    const char* tagName(HeapTag tag) {
+        return tag < HEAP_TAG_COUNT ? TAG_NAMES[tag] : "?";
+    }
+
+    static void writeArena(JsonObject out, const Arena& arena) {
+        out["capacity"] = arena.capacity();
+        out["used"] = arena.used();
+        out["peak"] = arena.peak();
+        out["overflows"] = arena.overflows();
+    }
+
+    void writeJson(JsonObject out) {
+        JsonObject regionsOut = out["regions"].to<JsonObject>();
+        for (int i = 0; i < REGION_COUNT; ++i) {
+            RegionStats stats = getRegionStats((HeapRegion)i);
+            JsonObject entry = regionsOut[REGION_NAMES[i]].to<JsonObject>();
+            entry["allocs"] = stats.allocs;
+            entry["frees"] = stats.frees;
+            entry["liveBlocks"] = stats.liveBlocks;
+            entry["liveBytes"] = stats.liveBytes;
+            entry["peakBytes"] = stats.peakBytes;
+            entry["freeBytes"] = stats.freeBytes;
+            entry["minFreeBytes"] = stats.minFreeBytes;
+            entry["largestFreeBlock"] = stats.largestFreeBlock;
+        }
+
+        JsonObject tagsOut = out["tags"].to<JsonObject>();
+        for (int i = 0; i < HEAP_TAG_COUNT; ++i) {
+            TagStats stats = getTagStats((HeapTag)i);
+            if (stats.allocs == 0 && stats.failures == 0) continue;
+            JsonObject entry = tagsOut[TAG_NAMES[i]].to<JsonObject>();
+            entry["allocs"] = stats.allocs;
+            entry["bytes"] = stats.bytes;
+            entry["failures"] = stats.failures;
+        }
+
+        JsonObject arenasOut = out["arenas"].to<JsonObject>();
+        writeArena(arenasOut["frame"].to<JsonObject>(), arenas::frame());
+        writeArena(arenasOut["screen"].to<JsonObject>(), arenas::screen());
+
+        pools::writeJson(out["pools"].to<JsonObject>());
+
+        FrameStats frameStats = getFrameStats();
+        JsonObject frameOut = out["frame"].to<JsonObject>();
+        frameOut["frames"] = frameStats.frames;
+        frameOut["lastAllocs"] = frameStats.lastAllocs;
+        frameOut["lastBytes"] = frameStats.lastBytes;
+        frameOut["maxAllocs"] = frameStats.maxAllocs;
+        frameOut["allocationFreeFrames"] = frameStats.allocationFreeFrames;
+    }
+
+    void printReport(Print& out) {
+        JsonDocument doc;
+        writeJson(doc.to<JsonObject>());
+        serializeJson(doc, out);
+        out.println();
+    }
+}
+
+// Linked in through -Wl,--wrap=malloc,... in platformio.ini; operator new and
+// Arduino String both end up here.
+extern "C" {
+    void* __real_malloc(size_t size);
+    void* __real_calloc(size_t count, size_t size);
+    void* __real_realloc(void* ptr, size_t size);
+    void __real_free(void* ptr);
+
+    void* __wrap_malloc(size_t size) {
+        void* ptr = __real_malloc(size);
+        heap_telemetry::noteAlloc(ptr, size);
+        return ptr;
+    }
+
+    void* __wrap_calloc(size_t count, size_t size) {
+        void* ptr = __real_calloc(count, size);
+        heap_telemetry::noteAlloc(ptr, count * size);
+        return ptr;
+    }
+
+    void* __wrap_realloc(void* ptr, size_t size) {
+        if (ptr == nullptr) {
+            return __wrap_malloc(size);
+        }
+        if (size == 0) {
+            heap_telemetry::noteFree(ptr);
+            return __real_realloc(ptr, 0);
+        }
+        size_t oldSize = heap_caps_get_allocated_size(ptr);
+        heap_telemetry::HeapRegion oldRegion = heap_telemetry::regionOf(ptr);
+        void* result = __real_realloc(ptr, size);
+        if (result) {
+            heap_telemetry::noteResize(oldSize, oldRegion);
+        }
+        heap_telemetry::noteAlloc(result, size);
+        return result;
+    }
+
+    void __wrap_free(void* ptr) {
+        if (ptr) {
+            heap_telemetry::noteFree(ptr);
+        }
+        __real_free(ptr);
+    }
+}
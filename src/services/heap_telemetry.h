@@ -0,0 +1,89 @@
+#ifndef HEAP_TELEMETRY_H
+#define HEAP_TELEMETRY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Allocation telemetry fed by the linker-wrapped malloc/calloc/realloc/free
+// (see build_flags). Live blocks and bytes are kept per memory region; loop-task
+// allocations are also attributed to the subsystem tag in scope. Host builds
+// record call sites instead; see heap_sites.h.
+namespace heap_telemetry {
+
+    enum HeapTag : uint8_t {
+        HEAP_OTHER_TASKS,   // Wi-Fi, lwIP, timers: anything off the loop task
+        HEAP_LOOP,          // loop task outside any tagged scope
+        HEAP_UI,
+        HEAP_READER,
+        HEAP_IMAGE,
+        HEAP_FILES,
+        HEAP_GAMES,
+        HEAP_GATEWAY,
+        HEAP_NETWORK,
+        HEAP_SETTINGS,
+        HEAP_TAG_COUNT
+    };
+
+    enum HeapRegion : uint8_t {
+        REGION_INTERNAL,
+        REGION_PSRAM,
+        REGION_COUNT
+    };
+
+    struct TagStats {
+        uint32_t allocs;
+        uint32_t failures;
+        uint64_t bytes;
+    };
+
+    struct RegionStats {
+        uint32_t allocs;
+        uint32_t frees;
+        uint32_t liveBlocks;
+        uint32_t liveBytes;
+        uint32_t peakBytes;
+        uint32_t freeBytes;
+        uint32_t minFreeBytes;
+        uint32_t largestFreeBlock;
+    };
+
+    // Loop-task allocations made inside renderCurrentScreen().
+    struct FrameStats {
+        uint32_t frames;
+        uint32_t lastAllocs;
+        uint32_t lastBytes;
+        uint32_t maxAllocs;
+        uint32_t allocationFreeFrames;
+    };
+
+    void begin();
+
+    HeapTag setTag(HeapTag tag);
+    HeapTag currentTag();
+
+    void beginFrame();
+    void endFrame();
+
+    void noteAlloc(void* ptr, size_t requested);
+    void noteFree(void* ptr);
+
+    TagStats getTagStats(HeapTag tag);
+    RegionStats getRegionStats(HeapRegion region);
+    FrameStats getFrameStats();
+    const char* tagName(HeapTag tag);
+
+    void writeJson(JsonObject out);
+    void printReport(Print& out);
+
+    class TagScope {
+    public:
+        explicit TagScope(HeapTag tag) : _previous(setTag(tag)) {}
+        ~TagScope() { setTag(_previous); }
+    private:
+        HeapTag _previous;
+    };
+}
+
+#define HEAP_TAG(tag) heap_telemetry::TagScope heapTagScope(heap_telemetry::tag)
+
+#endif // HEAP_TELEMETRY_H
@@ -0,0 +1,171 @@
+#include "idle_scheduler.h"
+#include <M5Unified.h>
+#include <WiFi.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#include "touch_input.h"
+#include "../debug_config.h"
+
+namespace idle_scheduler {
+    static const gpio_num_t TOUCH_INT_PIN = GPIO_NUM_48;
+    static const unsigned long TOUCH_GRACE_MS = 300;
+    static const unsigned long RADIO_IDLE_DELAY_MS = 10;
+    // Upper bound on touch latency while the radio keeps the chip in automatic light sleep.
+    static const unsigned long RADIO_SLEEP_SLICE_MS = 50;
+    static const unsigned long MIN_SLEEP_MS = 20;
+    static const unsigned long REPORT_INTERVAL_MS = 60000;
+
+    static IdleStats stats = {};
+    static bool started = false;
+    static unsigned long awakeUntil = 0;
+    static int64_t lastMark = 0;
+    static IdleStats windowStart = {};
+    static unsigned long lastReport = 0;
+    static bool radioSleepTried = false;
+    static esp_pm_lock_handle_t awakeLock = nullptr;
+
+    void begin() {
+        if (started) return;
+        started = true;
+        esp_sleep_enable_gpio_wakeup();
+        lastMark = esp_timer_get_time();
+        lastReport = millis();
+        keepAwake(TOUCH_GRACE_MS);
+    }
+
+    void keepAwake(unsigned long ms) {
+        unsigned long until = millis() + ms;
+        if ((long)(until - awakeUntil) > 0) {
+            awakeUntil = until;
+        }
+    }
+
+    static void accountAwake() {
+        int64_t now = esp_timer_get_time();
+        stats.awakeUs += (uint64_t)(now - lastMark);
+        lastMark = now;
+    }
+
+    static void report() {
+#ifdef DEBUG_POWER
+        if (millis() - lastReport < REPORT_INTERVAL_MS) return;
+        lastReport = millis();
+        uint64_t awake = stats.awakeUs - windowStart.awakeUs;
+        uint64_t asleep = stats.asleepUs - windowStart.asleepUs;
+        uint64_t radioIdle = stats.radioIdleUs - windowStart.radioIdleUs;
+        uint64_t total = awake + asleep + radioIdle;
+        Serial.printf("[Power] asleep %.1f%%, radio idle %.1f%% (last %lus), %lu sleeps, %lu touch / %lu timer wakeups\n",
+                      total ? 100.0 * (double)asleep / (double)total : 0.0,
+                      total ? 100.0 * (double)radioIdle / (double)total : 0.0,
+                      (unsigned long)(total / 1000000ULL),
+                      (unsigned long)(stats.sleeps - windowStart.sleeps),
+                      (unsigned long)(stats.touchWakeups - windowStart.touchWakeups),
+                      (unsigned long)(stats.timerWakeups - windowStart.timerWakeups));
+        windowStart = stats;
+#endif
+    }
+
+    // esp_light_sleep_start() would drop the association, so with the radio up the chip
+    // sleeps through power management instead: modem sleep between DTIM beacons and
+    // automatic light sleep in the idle task. awakeLock keeps automatic light sleep out
+    // of everything but radioIdle(), where nothing is drawing or talking to the card.
+    static void setupRadioSleep() {
+        if (radioSleepTried) return;
+        radioSleepTried = true;
+        WiFi.setSleep(WIFI_PS_MIN_MODEM);
+        if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "idle", &awakeLock) != ESP_OK) {
+            awakeLock = nullptr;
+            return;
+        }
+        esp_pm_lock_acquire(awakeLock);
+        esp_pm_config_esp32s3_t config = {};
+        config.max_freq_mhz = getCpuFrequencyMhz();
+        config.min_freq_mhz = config.max_freq_mhz;
+        config.light_sleep_enable = true;
+        esp_err_t err = esp_pm_configure(&config);
+        if (err != ESP_OK) {
+            esp_pm_lock_release(awakeLock);
+            esp_pm_lock_delete(awakeLock);
+            awakeLock = nullptr;
+        }
+#ifdef DEBUG_POWER
+        Serial.printf("[Power] automatic light sleep with Wi-Fi: %s\n", awakeLock ? "on" : esp_err_to_name(err));
+#endif
+    }
+
+    static void radioIdle(unsigned long maxSleepMs) {
+        setupRadioSleep();
+        if (!awakeLock) {
+            delay(RADIO_IDLE_DELAY_MS);
+            return;
+        }
+        unsigned long slice = maxSleepMs < RADIO_SLEEP_SLICE_MS ? maxSleepMs : RADIO_SLEEP_SLICE_MS;
+        gpio_wakeup_enable(TOUCH_INT_PIN, GPIO_INTR_LOW_LEVEL);
+        int64_t idleStart = esp_timer_get_time();
+        esp_pm_lock_release(awakeLock);
+        delay(slice);
+        esp_pm_lock_acquire(awakeLock);
+        int64_t idleEnd = esp_timer_get_time();
+        gpio_wakeup_disable(TOUCH_INT_PIN);
+
+        // Not counted as asleep: how much of the slice the idle task spent in light
+        // sleep between beacons and timer ticks is not reported by the PM driver.
+        stats.radioIdleUs += (uint64_t)(idleEnd - idleStart);
+        lastMark = idleEnd;
+        bool touchWakeup = gpio_get_level(TOUCH_INT_PIN) == 0;
+        touch_input::rearm(touchWakeup);
+        if (touchWakeup) {
+            keepAwake(TOUCH_GRACE_MS);
+        }
+    }
+
+    void idle(bool busy, bool radioActive, unsigned long maxSleepMs) {
+        if (!started) return;
+        accountAwake();
+        report();
+
+        if (busy || (long)(awakeUntil - millis()) > 0 || maxSleepMs < MIN_SLEEP_MS) return;
+        if (M5.Display.displayBusy()) return;
+
+        if (gpio_get_level(TOUCH_INT_PIN) == 0) {
+            keepAwake(TOUCH_GRACE_MS);
+            return;
+        }
+        if (radioActive) {
+            radioIdle(maxSleepMs);
+            return;
+        }
+
+        Serial.flush();
+        esp_sleep_enable_timer_wakeup((uint64_t)maxSleepMs * 1000ULL);
+        // Level wakeup replaces the INT edge interrupt, so it is only armed across the sleep.
+        gpio_wakeup_enable(TOUCH_INT_PIN, GPIO_INTR_LOW_LEVEL);
+        int64_t sleepStart = esp_timer_get_time();
+        esp_light_sleep_start();
+        int64_t sleepEnd = esp_timer_get_time();
+        gpio_wakeup_disable(TOUCH_INT_PIN);
+
+        stats.asleepUs += (uint64_t)(sleepEnd - sleepStart);
+        stats.sleeps++;
+        lastMark = sleepEnd;
+        bool touchWakeup = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO;
+        touch_input::rearm(touchWakeup);
+        if (touchWakeup) {
+            stats.touchWakeups++;
+            keepAwake(TOUCH_GRACE_MS);
+        } else {
+            stats.timerWakeups++;
+        }
+    }
+
+    const IdleStats& getStats() {
+        return stats;
+    }
+
+    float sleepFraction() {
+        uint64_t total = stats.awakeUs + stats.asleepUs + stats.radioIdleUs;
+        return total ? (float)((double)stats.asleepUs / (double)total) : 0.0f;
+    }
+}
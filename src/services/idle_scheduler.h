@@ -0,0 +1,32 @@
+#ifndef IDLE_SCHEDULER_H
+#define IDLE_SCHEDULER_H
+
+#include <Arduino.h>
+
+namespace idle_scheduler {
+
+    struct IdleStats {
+        uint64_t awakeUs;
+        uint64_t asleepUs;      // measured: esp_light_sleep_start() returned after this long
+        uint64_t radioIdleUs;   // Wi-Fi up: yielded to automatic light sleep, actual sleep not measured
+        uint32_t sleeps;
+        uint32_t touchWakeups;
+        uint32_t timerWakeups;
+    };
+
+    void begin();
+
+    // Keeps the CPU running for at least `ms` after input.
+    void keepAwake(unsigned long ms);
+
+    // Called once at the end of loop(). When nothing is busy the chip enters light
+    // sleep until the touch INT line goes low or `maxSleepMs` elapses. With the radio
+    // active it keeps the association and uses automatic light sleep in short slices.
+    void idle(bool busy, bool radioActive, unsigned long maxSleepMs);
+
+    const IdleStats& getStats();
+    // Share of measured light sleep; radio idle time counts as neither asleep nor awake.
+    float sleepFraction();
+}
+
+#endif // IDLE_SCHEDULER_H
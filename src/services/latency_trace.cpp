@@ -0,0 +1,130 @@
+#include "latency_trace.h"
+#include <M5Unified.h>
+#include <esp_timer.h>
+#include <atomic>
+#include "serial_console.h"
+
+namespace latency_trace {
+    static const char* const STAGE_NAMES[TRACE_STAGE_COUNT] = {
+        "captured", "dispatched", "draw issued", "framebuffer", "epd start", "epd done"
+    };
+    // Phase that ends at each stage, used as the span name between stages.
+    static const char* const PHASE_NAMES[TRACE_STAGE_COUNT] = {
+        "", "queue", "handler", "draw", "present wait", "epd refresh"
+    };
+
+    static TraceRecord ring[RING_CAPACITY];
+    // Writers reserve a slot with one fetch_add; no lock is taken anywhere.
+    static std::atomic<uint32_t> ringHead(0);
+    static std::atomic<uint32_t> clearedAt(0);
+
+    static uint16_t nextTouchId = 1;
+    static uint16_t openTouch = 0;
+    static bool refreshPending = false;
+    static bool started = false;
+
+    static void printCommand(const String& args) {
+        if (args == "clear") {
+            clear();
+            Serial.println("trace cleared");
+            return;
+        }
+        printReport(Serial);
+    }
+
+    void begin() {
+        if (started) return;
+        started = true;
+        serial_console::registerCommand("trace", printCommand, "touch-to-display latency trace (Chrome JSON); 'trace clear'");
+    }
+
+    static void record(uint16_t touchId, TraceStage stage, int screen, uint32_t timeUs) {
+        uint32_t index = ringHead.fetch_add(1, std::memory_order_relaxed);
+        TraceRecord& slot = ring[index % RING_CAPACITY];
+        slot.timeUs = timeUs;
+        slot.touchId = touchId;
+        slot.stage = stage;
+        slot.screen = (uint8_t)screen;
+    }
+
+    uint16_t beginTouch(uint32_t capturedUs, int screen) {
+        uint16_t id = nextTouchId++;
+        if (nextTouchId == 0) nextTouchId = 1;
+        openTouch = id;
+        refreshPending = false;
+        record(id, TRACE_CAPTURED, screen, capturedUs);
+        return id;
+    }
+
+    void mark(TraceStage stage, int screen) {
+        if (!openTouch) return;
+        record(openTouch, stage, screen, (uint32_t)esp_timer_get_time());
+        if (stage == TRACE_EPD_START) {
+            refreshPending = true;
+        }
+    }
+
+    void loop() {
+        if (!openTouch || !refreshPending || M5.Display.displayBusy()) return;
+        record(openTouch, TRACE_EPD_DONE, 0xFF, (uint32_t)esp_timer_get_time());
+        openTouch = 0;
+        refreshPending = false;
+    }
+
+    int snapshot(TraceRecord* out, int maxCount) {
+        uint32_t head = ringHead.load(std::memory_order_acquire);
+        uint32_t first = clearedAt.load(std::memory_order_relaxed);
+        if (head - first > (uint32_t)RING_CAPACITY) first = head - RING_CAPACITY;
+        int count = (int)(head - first);
+        if (count > maxCount) {
+            first += count - maxCount;
+            count = maxCount;
+        }
+        for (int i = 0; i < count; ++i) {
+            out[i] = ring[(first + i) % RING_CAPACITY];
+        }
+        return count;
+    }
+
+    void clear() {
+        clearedAt.store(ringHead.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    static void addEvent(JsonArray events, const char* name, const char* phase, uint32_t ts, uint16_t touchId) {
+        JsonObject event = events.add<JsonObject>();
+        event["name"] = name;
+        event["ph"] = phase;
+        event["ts"] = ts;
+        event["pid"] = 1;
+        event["tid"] = touchId;
+    }
+
+    void writeJson(JsonObject out) {
+        static TraceRecord records[RING_CAPACITY];
+        int count = snapshot(records, RING_CAPACITY);
+
+        out["displayTimeUnit"] = "ms";
+        JsonArray events = out["traceEvents"].to<JsonArray>();
+        for (int i = 0; i < count; ++i) {
+            const TraceRecord& current = records[i];
+            addEvent(events, STAGE_NAMES[current.stage], "i", current.timeUs, current.touchId);
+            if (current.stage == TRACE_CAPTURED) continue;
+            for (int j = i - 1; j >= 0; --j) {
+                const TraceRecord& previous = records[j];
+                if (previous.touchId != current.touchId) continue;
+                addEvent(events, PHASE_NAMES[current.stage], "X", previous.timeUs, current.touchId);
+                JsonObject span = events[events.size() - 1];
+                span["dur"] = current.timeUs - previous.timeUs;
+                if (current.screen != 0xFF) span["args"]["screen"] = current.screen;
+                break;
+            }
+        }
+    }
+
+    void printReport(Print& out) {
+        JsonDocument doc;
+        writeJson(doc.to<JsonObject>());
+        serializeJson(doc, out);
+        out.println();
+    }
+}
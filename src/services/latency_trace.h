@@ -0,0 +1,48 @@
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Input-to-display latency: each touch gets an id and timestamps at every
+// stage until the EPD refresh it caused has settled. Exported as Chrome trace JSON.
+namespace latency_trace {
+
+    enum TraceStage : uint8_t {
+        TRACE_CAPTURED,     // touch sampled (INT timestamp)
+        TRACE_DISPATCHED,   // handed to the screen handler
+        TRACE_DRAW_ISSUED,  // renderCurrentScreen() started
+        TRACE_FRAMEBUFFER,  // renderCurrentScreen() finished
+        TRACE_EPD_START,    // display() called from updateUI()
+        TRACE_EPD_DONE,     // panel no longer busy
+        TRACE_STAGE_COUNT
+    };
+
+    struct TraceRecord {
+        uint32_t timeUs;
+        uint16_t touchId;
+        uint8_t stage;
+        uint8_t screen;
+    };
+
+    static const int RING_CAPACITY = 256;
+
+    void begin();
+
+    // Closes the open touch once the refresh it started has finished.
+    void loop();
+
+    // Opens a new traced touch captured at `capturedUs`; returns its id.
+    uint16_t beginTouch(uint32_t capturedUs, int screen);
+
+    // Stamps `stage` on the open touch, if any.
+    void mark(TraceStage stage, int screen);
+
+    int snapshot(TraceRecord* out, int maxCount);
+    void clear();
+
+    void writeJson(JsonObject out);
+    void printReport(Print& out);
+}
+
+#endif // LATENCY_TRACE_H
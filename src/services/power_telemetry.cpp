@@ -0,0 +1,175 @@
+#include "power_telemetry.h"
+#include <M5Unified.h>
+#include <esp_timer.h>
+#include "idle_scheduler.h"
+#include "serial_console.h"
+#include "../network/wifi_manager.h"
+
+namespace power_telemetry {
+    static const size_t ACTION_NAME_LENGTH = 12;
+
+    struct ScreenCounters {
+        uint32_t renders;
+        uint32_t touches;
+        uint64_t dwellUs;
+    };
+
+    struct ActionCounter {
+        char name[ACTION_NAME_LENGTH];
+        uint32_t count;
+    };
+
+    static uint64_t stateUs[POWER_STATE_COUNT] = {};
+    static uint8_t scopeDepth[POWER_STATE_COUNT] = {};
+    static ScreenCounters screens[MAX_SCREENS] = {};
+    static ActionCounter actions[MAX_ACTIONS] = {};
+    static int actionCount = 0;
+    static int currentScreen = -1;
+
+    static BatterySample batteryRing[BATTERY_HISTORY];
+    static int batteryHead = 0;
+    static int batteryCount = 0;
+
+    static int64_t lastLoopUs = 0;
+    static bool started = false;
+
+    static void printCommand(const String&) {
+        printReport(Serial);
+    }
+
+    void begin() {
+        if (started) return;
+        started = true;
+        lastLoopUs = esp_timer_get_time();
+        serial_console::registerCommand("power", printCommand, "power and battery telemetry (JSON)");
+    }
+
+    static bool radioActive() {
+        WiFiManager& wifi = WiFiManager::getInstance();
+        WiFiManager::ConnectionState state = wifi.getState();
+        return wifi.isScanning() ||
+               (state != WiFiManager::ConnectionState::IDLE && state != WiFiManager::ConnectionState::FAILED);
+    }
+
+    void loop() {
+        if (!started) return;
+        int64_t now = esp_timer_get_time();
+        uint32_t delta = (uint32_t)(now - lastLoopUs);
+        lastLoopUs = now;
+
+        if (radioActive()) stateUs[POWER_WIFI] += delta;
+        if (scopeDepth[POWER_EPD] == 0 && M5.Display.displayBusy()) stateUs[POWER_EPD] += delta;
+        if (currentScreen >= 0) screens[currentScreen].dwellUs += delta;
+    }
+
+    void addTime(PowerState state, uint32_t us) {
+        if (state < POWER_STATE_COUNT) stateUs[state] += us;
+    }
+
+    uint64_t getTimeUs(PowerState state) {
+        const idle_scheduler::IdleStats& idle = idle_scheduler::getStats();
+        if (state == POWER_SLEEP) return idle.asleepUs;
+        if (state == POWER_CPU) {
+            uint64_t busy = stateUs[POWER_EPD] + stateUs[POWER_SD];
+            return idle.awakeUs > busy ? idle.awakeUs - busy : 0;
+        }
+        return state < POWER_STATE_COUNT ? stateUs[state] : 0;
+    }
+
+    void noteScreen(int screen) {
+        if (screen < 0 || screen >= MAX_SCREENS) return;
+        currentScreen = screen;
+        screens[screen].renders++;
+    }
+
+    void noteTouch(int screen) {
+        if (screen < 0 || screen >= MAX_SCREENS) return;
+        screens[screen].touches++;
+    }
+
+    void noteAction(const char* name) {
+        for (int i = 0; i < actionCount; ++i) {
+            if (strncmp(actions[i].name, name, ACTION_NAME_LENGTH - 1) == 0) {
+                actions[i].count++;
+                return;
+            }
+        }
+        if (actionCount >= MAX_ACTIONS) return;
+        strncpy(actions[actionCount].name, name, ACTION_NAME_LENGTH - 1);
+        actions[actionCount].name[ACTION_NAME_LENGTH - 1] = '\0';
+        actions[actionCount].count = 1;
+        actionCount++;
+    }
+
+    void recordBattery(uint16_t millivolts, uint8_t percent) {
+        BatterySample& sample = batteryRing[batteryHead];
+        sample.uptimeS = millis() / 1000;
+        sample.millivolts = millivolts;
+        sample.percent = percent;
+        batteryHead = (batteryHead + 1) % BATTERY_HISTORY;
+        if (batteryCount < BATTERY_HISTORY) batteryCount++;
+    }
+
+    int getBatteryHistory(BatterySample* out, int maxCount) {
+        int count = batteryCount < maxCount ? batteryCount : maxCount;
+        int start = (batteryHead - count + BATTERY_HISTORY) % BATTERY_HISTORY;
+        for (int i = 0; i < count; ++i) {
+            out[i] = batteryRing[(start + i) % BATTERY_HISTORY];
+        }
+        return count;
+    }
+
+    void writeJson(JsonObject out) {
+        out["uptimeS"] = millis() / 1000;
+        JsonObject states = out["statesMs"].to<JsonObject>();
+        states["epd"] = getTimeUs(POWER_EPD) / 1000;
+        states["sd"] = getTimeUs(POWER_SD) / 1000;
+        states["wifi"] = getTimeUs(POWER_WIFI) / 1000;
+        states["cpu"] = getTimeUs(POWER_CPU) / 1000;
+        states["sleep"] = getTimeUs(POWER_SLEEP) / 1000;
+        // Wi-Fi up with the CPU free to light-sleep; only POWER_WIFI is charged for it.
+        states["radioIdle"] = idle_scheduler::getStats().radioIdleUs / 1000;
+
+        JsonArray screenList = out["screens"].to<JsonArray>();
+        for (int i = 0; i < MAX_SCREENS; ++i) {
+            if (screens[i].renders == 0 && screens[i].touches == 0) continue;
+            JsonObject entry = screenList.add<JsonObject>();
+            entry["screen"] = i;
+            entry["renders"] = screens[i].renders;
+            entry["touches"] = screens[i].touches;
+            entry["dwellMs"] = screens[i].dwellUs / 1000;
+        }
+
+        JsonObject actionMap = out["actions"].to<JsonObject>();
+        for (int i = 0; i < actionCount; ++i) {
+            actionMap[actions[i].name] = actions[i].count;
+        }
+
+        JsonArray battery = out["battery"].to<JsonArray>();
+        int start = (batteryHead - batteryCount + BATTERY_HISTORY) % BATTERY_HISTORY;
+        for (int i = 0; i < batteryCount; ++i) {
+            const BatterySample& sample = batteryRing[(start + i) % BATTERY_HISTORY];
+            JsonArray point = battery.add<JsonArray>();
+            point.add(sample.uptimeS);
+            point.add(sample.millivolts);
+            point.add(sample.percent);
+        }
+    }
+
+    void printReport(Print& out) {
+        JsonDocument doc;
+        writeJson(doc.to<JsonObject>());
+        serializeJson(doc, out);
+        out.println();
+    }
+
+    Scope::Scope(PowerState state) : _state(state), _start(esp_timer_get_time()) {
+        scopeDepth[_state]++;
+    }
+
+    Scope::~Scope() {
+        if (--scopeDepth[_state] == 0) {
+            addTime(_state, (uint32_t)(esp_timer_get_time() - _start));
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef POWER_TELEMETRY_H
+#define POWER_TELEMETRY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+namespace power_telemetry {
+
+    enum PowerState : uint8_t {
+        POWER_EPD,
+        POWER_SD,
+        POWER_WIFI,
+        POWER_CPU,
+        POWER_SLEEP,
+        POWER_STATE_COUNT
+    };
+
+    struct BatterySample {
+        uint32_t uptimeS;
+        uint16_t millivolts;
+        uint8_t percent;
+    };
+
+    static const int BATTERY_HISTORY = 120;
+    static const int MAX_SCREENS = 24;
+    static const int MAX_ACTIONS = 16;
+
+    void begin();
+    void loop();
+
+    void addTime(PowerState state, uint32_t us);
+    uint64_t getTimeUs(PowerState state);
+
+    void noteScreen(int screen);
+    void noteTouch(int screen);
+    void noteAction(const char* name);
+
+    void recordBattery(uint16_t millivolts, uint8_t percent);
+    int getBatteryHistory(BatterySample* out, int maxCount);
+
+    void writeJson(JsonObject out);
+    void printReport(Print& out);
+
+    // Adds the scope's wall time to one power state; nested scopes of the
+    // same state only count once.
+    class Scope {
+    public:
+        explicit Scope(PowerState state);
+        ~Scope();
+    private:
+        PowerState _state;
+        int64_t _start;
+    };
+}
+
+#define POWER_SCOPE(state) power_telemetry::Scope powerScope(power_telemetry::state)
+
+#endif // POWER_TELEMETRY_H
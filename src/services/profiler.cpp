@@ -0,0 +1,80 @@
+#include "profiler.h"
+#include "serial_console.h"
+
+namespace profiler {
+    static Site* sites = nullptr;
+    static bool started = false;
+
+    static void printCommand(const String& args) {
+        if (args == "reset") {
+            reset();
+            Serial.println("profile reset");
+            return;
+        }
+        printReport(Serial);
+    }
+
+    void begin() {
+        if (started) return;
+        started = true;
+        serial_console::registerCommand("profile", printCommand, "per-site timers and log2 histograms (JSON); 'profile reset'");
+    }
+
+    static int bucketFor(uint32_t value) {
+        int bucket = value ? 32 - __builtin_clz(value) : 0;
+        return bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1;
+    }
+
+    void record(Site& site, uint32_t value) {
+        if (!site.registered) {
+            site.registered = true;
+            site.next = sites;
+            sites = &site;
+        }
+        site.calls++;
+        site.total += value;
+        if (value > site.peak) site.peak = value;
+        site.buckets[bucketFor(value)]++;
+    }
+
+    void reset() {
+        for (Site* site = sites; site; site = site->next) {
+            site->calls = 0;
+            site->total = 0;
+            site->peak = 0;
+            memset(site->buckets, 0, sizeof(site->buckets));
+        }
+    }
+
+    void writeJson(JsonObject out) {
+#ifdef PROFILE_ENABLED
+        out["enabled"] = true;
+#else
+        out["enabled"] = false;
+#endif
+        JsonArray list = out["sites"].to<JsonArray>();
+        for (Site* site = sites; site; site = site->next) {
+            JsonObject entry = list.add<JsonObject>();
+            entry["name"] = site->name;
+            entry["unit"] = site->kind == SITE_TIMER ? "us" : "count";
+            entry["calls"] = site->calls;
+            entry["total"] = site->total;
+            entry["mean"] = site->calls ? (uint32_t)(site->total / site->calls) : 0;
+            entry["max"] = site->peak;
+            // Trailing empty buckets are trimmed; index i covers [2^(i-1), 2^i).
+            int last = HISTOGRAM_BUCKETS - 1;
+            while (last >= 0 && site->buckets[last] == 0) last--;
+            JsonArray histogram = entry["log2"].to<JsonArray>();
+            for (int i = 0; i <= last; ++i) {
+                histogram.add(site->buckets[i]);
+            }
+        }
+    }
+
+    void printReport(Print& out) {
+        JsonDocument doc;
+        writeJson(doc.to<JsonObject>());
+        serializeJson(doc, out);
+        out.println();
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+#include "../profile_config.h"
+
+// Per-site timers and counters with log2 histograms in static storage.
+// With PROFILE_ENABLED unset the PROFILE_* macros expand to nothing.
+namespace profiler {
+
+    enum SiteKind : uint8_t {
+        SITE_TIMER,     // samples are microseconds
+        SITE_COUNTER    // samples are caller-defined amounts (bytes, items)
+    };
+
+    static const int HISTOGRAM_BUCKETS = 24;
+
+    struct Site {
+        const char* name;
+        SiteKind kind;
+        bool registered;
+        uint32_t calls;
+        uint64_t total;
+        uint32_t peak;
+        uint32_t buckets[HISTOGRAM_BUCKETS];
+        Site* next;
+
+        constexpr Site(const char* siteName, SiteKind siteKind)
+            : name(siteName), kind(siteKind), registered(false), calls(0), total(0), peak(0), buckets{}, next(nullptr) {}
+    };
+
+    void begin();
+
+    // Bucket i holds samples in [2^(i-1), 2^i); bucket 0 holds zero.
+    void record(Site& site, uint32_t value);
+    void reset();
+
+    void writeJson(JsonObject out);
+    void printReport(Print& out);
+
+    class Timer {
+    public:
+        explicit Timer(Site& site) : _site(site), _start(esp_timer_get_time()) {}
+        ~Timer() { record(_site, (uint32_t)(esp_timer_get_time() - _start)); }
+    private:
+        Site& _site;
+        int64_t _start;
+    };
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef PROFILE_ENABLED
+#define PROFILE_SCOPE(name) \
+    static profiler::Site PROFILE_CONCAT(profileSite, __LINE__)(name, profiler::SITE_TIMER); \
+    profiler::Timer PROFILE_CONCAT(profileTimer, __LINE__)(PROFILE_CONCAT(profileSite, __LINE__))
+#define PROFILE_COUNT(name, amount) \
+    do { \
+        static profiler::Site profileCounter(name, profiler::SITE_COUNTER); \
+        profiler::record(profileCounter, (uint32_t)(amount)); \
+    } while (0)
+#else
+#define PROFILE_SCOPE(name) do {} while (0)
+#define PROFILE_COUNT(name, amount) do {} while (0)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,316 @@
+#include "reading_state.h"
+#include <SD.h>
+#include <ArduinoJson.h>
+#include <time.h>
+#include <algorithm>
+#include "../crc32.h"
+#include "power_telemetry.h"
+
+namespace {
+    const char* LOG_PATH = "/books/.reader_state.log";
+    const char* TEMP_PATH = "/books/.reader_state.tmp";
+    const char* LEGACY_PATH = "/books/reader_state.json";
+    const char* LEGACY_BACKUP_PATH = "/books/reader_state.json.bak";
+    const unsigned long WRITE_DELAY_MS = 3000;
+    const unsigned long MAX_PAGE_DWELL_MS = 5UL * 60UL * 1000UL;
+    const uint32_t COMPACT_MIN_RECORDS = 64;
+    const size_t MAX_BOOKMARKS = 32;
+
+    String withChecksum(const String& body) {
+        char suffix[10];
+        snprintf(suffix, sizeof(suffix), "\t%08lx", (unsigned long)crc32((const uint8_t*)body.c_str(), body.length()));
+        return body + suffix;
+    }
+
+    int splitFields(const String& line, String* fields, int maxFields) {
+        int count = 0;
+        int start = 0;
+        while (count < maxFields) {
+            int tab = line.indexOf('\t', start);
+            if (tab < 0) {
+                fields[count++] = line.substring(start);
+                break;
+            }
+            fields[count++] = line.substring(start, tab);
+            start = tab + 1;
+        }
+        return count;
+    }
+
+    uint32_t toU32(const String& value) {
+        return (uint32_t)strtoul(value.c_str(), nullptr, 10);
+    }
+}
+
+size_t ReadingStateStore::StringHash::operator()(const String& value) const {
+    uint32_t hash = 2166136261u;
+    for (unsigned int i = 0; i < value.length(); ++i) {
+        hash ^= (uint8_t)value[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+ReadingStateStore::ReadingStateStore() : _loaded(false), _writeScheduled(false), _lastChange(0), _lastTurnMs(0), _logRecords(0) {
+}
+
+void ReadingStateStore::_recoverTempFile() {
+    if (!SD.exists(TEMP_PATH)) return;
+    if (SD.exists(LOG_PATH)) {
+        SD.remove(TEMP_PATH);
+    } else {
+        SD.rename(TEMP_PATH, LOG_PATH);
+    }
+}
+
+bool ReadingStateStore::begin() {
+    if (_loaded) return true;
+    _loaded = true;
+    _recoverTempFile();
+
+    File log = SD.open(LOG_PATH, FILE_READ);
+    if (log) {
+        uint32_t rejected = 0;
+        while (log.available()) {
+            String line = log.readStringUntil('\n');
+            int tab = line.lastIndexOf('\t');
+            if (tab <= 0) {
+                rejected++;
+                continue;
+            }
+            String body = line.substring(0, tab);
+            uint32_t expected = (uint32_t)strtoul(line.substring(tab + 1).c_str(), nullptr, 16);
+            if (crc32((const uint8_t*)body.c_str(), body.length()) != expected) {
+                rejected++;
+                continue;
+            }
+            _applyRecord(body);
+            _logRecords++;
+        }
+        log.close();
+        for (auto& entry : _books) {
+            entry.second.dirty = false;
+        }
+        Serial.printf("[Reader] State log: %u books from %u records (%u rejected)\n",
+                      (unsigned)_books.size(), (unsigned)_logRecords, (unsigned)rejected);
+        if (rejected > 0) compact();
+    } else if (SD.exists(LEGACY_PATH)) {
+        _importLegacyJson();
+    }
+    return true;
+}
+
+void ReadingStateStore::_importLegacyJson() {
+    File legacy = SD.open(LEGACY_PATH, FILE_READ);
+    if (!legacy) return;
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, legacy);
+    legacy.close();
+    if (error) {
+        Serial.println("[Reader] Failed to parse legacy state file");
+        return;
+    }
+
+    for (JsonPair pair : doc.as<JsonObject>()) {
+        BookState& state = touch(pair.key().c_str());
+        state.legacyPage = pair.value().as<int>();
+    }
+    if (compact()) {
+        SD.remove(LEGACY_BACKUP_PATH);
+        SD.rename(LEGACY_PATH, LEGACY_BACKUP_PATH);
+        Serial.printf("[Reader] Migrated %u books from reader_state.json\n", (unsigned)_books.size());
+    }
+}
+
+void ReadingStateStore::_applyRecord(const String& line) {
+    String fields[7];
+    int count = splitFields(line, fields, 7);
+    if (count < 2 || fields[1].isEmpty()) return;
+    const String& type = fields[0];
+    const String& book = fields[1];
+
+    if (type == "P" && count >= 6) {
+        BookState& state = touch(book);
+        state.offset = toU32(fields[2]);
+        state.lastOpened = toU32(fields[3]);
+        state.pagesTurned = toU32(fields[4]);
+        state.readingSeconds = toU32(fields[5]);
+        state.legacyPage = -1;
+    } else if (type == "L" && count >= 3) {
+        touch(book).legacyPage = (int32_t)toU32(fields[2]);
+    } else if ((type == "B+" || type == "B-") && count >= 3) {
+        BookState& state = touch(book);
+        uint32_t offset = toU32(fields[2]);
+        auto it = std::lower_bound(state.bookmarks.begin(), state.bookmarks.end(), offset);
+        bool present = it != state.bookmarks.end() && *it == offset;
+        if (type == "B+" && !present) state.bookmarks.insert(it, offset);
+        if (type == "B-" && present) state.bookmarks.erase(it);
+    } else if (type == "X") {
+        _books.erase(book);
+    }
+}
+
+const BookState* ReadingStateStore::find(const String& book) const {
+    auto it = _books.find(book);
+    return it == _books.end() ? nullptr : &it->second;
+}
+
+BookState& ReadingStateStore::touch(const String& book) {
+    auto it = _books.find(book);
+    if (it != _books.end()) return it->second;
+    BookState state = {0, 0, 0, 0, -1, std::vector<uint32_t>(), false};
+    return _books.emplace(book, state).first->second;
+}
+
+void ReadingStateStore::_scheduleWrite() {
+    _writeScheduled = true;
+    _lastChange = millis();
+}
+
+void ReadingStateStore::_queue(const String& record) {
+    _pendingLines.push_back(withChecksum(record));
+    _scheduleWrite();
+}
+
+void ReadingStateStore::setOffset(const String& book, uint32_t offset) {
+    BookState& state = touch(book);
+    if (state.offset == offset && state.legacyPage < 0) return;
+    state.offset = offset;
+    state.legacyPage = -1;
+    state.dirty = true;
+    _scheduleWrite();
+}
+
+void ReadingStateStore::markOpened(const String& book) {
+    BookState& state = touch(book);
+    time_t now = time(nullptr);
+    state.lastOpened = (uint32_t)now;
+    state.dirty = true;
+    _lastTurnMs = millis();
+    _scheduleWrite();
+}
+
+void ReadingStateStore::recordPageTurn(const String& book, uint32_t offset) {
+    BookState& state = touch(book);
+    unsigned long now = millis();
+    if (_lastTurnMs != 0 && now - _lastTurnMs < MAX_PAGE_DWELL_MS) {
+        state.readingSeconds += (now - _lastTurnMs + 500) / 1000;
+    }
+    _lastTurnMs = now;
+    state.pagesTurned++;
+    state.dirty = true;
+    setOffset(book, offset);
+}
+
+bool ReadingStateStore::toggleBookmark(const String& book, uint32_t offset) {
+    BookState& state = touch(book);
+    auto it = std::lower_bound(state.bookmarks.begin(), state.bookmarks.end(), offset);
+    bool present = it != state.bookmarks.end() && *it == offset;
+    if (present) {
+        state.bookmarks.erase(it);
+    } else {
+        if (state.bookmarks.size() >= MAX_BOOKMARKS) return false;
+        state.bookmarks.insert(it, offset);
+    }
+    _queue(String(present ? "B-" : "B+") + "\t" + book + "\t" + String((unsigned long)offset));
+    return !present;
+}
+
+bool ReadingStateStore::hasBookmark(const String& book, uint32_t offset) const {
+    const BookState* state = find(book);
+    return state && std::binary_search(state->bookmarks.begin(), state->bookmarks.end(), offset);
+}
+
+void ReadingStateStore::forget(const String& book) {
+    if (_books.erase(book) > 0) {
+        _queue("X\t" + book);
+    }
+}
+
+void ReadingStateStore::loop() {
+    if (_writeScheduled && millis() - _lastChange >= WRITE_DELAY_MS) {
+        flush();
+    }
+}
+
+bool ReadingStateStore::flush() {
+    POWER_SCOPE(POWER_SD);
+    _writeScheduled = false;
+    for (auto& entry : _books) {
+        BookState& state = entry.second;
+        if (!state.dirty) continue;
+        _pendingLines.push_back(withChecksum("P\t" + entry.first + "\t" +
+            String((unsigned long)state.offset) + "\t" + String((unsigned long)state.lastOpened) + "\t" +
+            String((unsigned long)state.pagesTurned) + "\t" + String((unsigned long)state.readingSeconds)));
+        state.dirty = false;
+    }
+    if (_pendingLines.empty()) return true;
+    if (!_appendPending()) {
+        _writeScheduled = true;
+        _lastChange = millis();
+        return false;
+    }
+
+    size_t live = _books.size();
+    for (auto& entry : _books) {
+        live += entry.second.bookmarks.size();
+    }
+    if (_logRecords > COMPACT_MIN_RECORDS && _logRecords > 4 * live) {
+        return compact();
+    }
+    return true;
+}
+
+bool ReadingStateStore::_appendPending() {
+    File log = SD.open(LOG_PATH, FILE_APPEND);
+    if (!log) {
+        Serial.println("[Reader] Failed to open state log");
+        return false;
+    }
+    for (size_t i = 0; i < _pendingLines.size(); ++i) {
+        log.print(_pendingLines[i]);
+        log.print('\n');
+    }
+    log.close();
+    _logRecords += _pendingLines.size();
+    _pendingLines.clear();
+    return true;
+}
+
+bool ReadingStateStore::compact() {
+    POWER_SCOPE(POWER_SD);
+    File out = SD.open(TEMP_PATH, FILE_WRITE);
+    if (!out) {
+        Serial.println("[Reader] Failed to open state snapshot");
+        return false;
+    }
+    uint32_t records = 0;
+    for (auto& entry : _books) {
+        const String& book = entry.first;
+        BookState& state = entry.second;
+        out.print(withChecksum("P\t" + book + "\t" +
+            String((unsigned long)state.offset) + "\t" + String((unsigned long)state.lastOpened) + "\t" +
+            String((unsigned long)state.pagesTurned) + "\t" + String((unsigned long)state.readingSeconds)));
+        out.print('\n');
+        records++;
+        if (state.legacyPage >= 0) {
+            out.print(withChecksum("L\t" + book + "\t" + String(state.legacyPage)));
+            out.print('\n');
+            records++;
+        }
+        for (size_t i = 0; i < state.bookmarks.size(); ++i) {
+            out.print(withChecksum("B+\t" + book + "\t" + String((unsigned long)state.bookmarks[i])));
+            out.print('\n');
+            records++;
+        }
+        state.dirty = false;
+    }
+    out.close();
+
+    if (SD.exists(LOG_PATH) && !SD.remove(LOG_PATH)) return false;
+    if (!SD.rename(TEMP_PATH, LOG_PATH)) return false;
+    _pendingLines.clear();
+    _logRecords = records;
+    Serial.printf("[Reader] State log compacted to %u records\n", (unsigned)records);
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef READING_STATE_H
+#define READING_STATE_H
+
+#include <Arduino.h>
+#include <unordered_map>
+#include <vector>
+
+struct BookState {
+    uint32_t offset;
+    uint32_t lastOpened;
+    uint32_t pagesTurned;
+    uint32_t readingSeconds;
+    int32_t legacyPage;
+    std::vector<uint32_t> bookmarks;
+    bool dirty;
+};
+
+class ReadingStateStore {
+public:
+    static ReadingStateStore& getInstance() {
+        static ReadingStateStore instance;
+        return instance;
+    }
+
+    bool begin();
+    void loop();
+    bool flush();
+    bool compact();
+    bool hasPendingWrites() const { return _writeScheduled; }
+
+    const BookState* find(const String& book) const;
+    BookState& touch(const String& book);
+    void setOffset(const String& book, uint32_t offset);
+    void markOpened(const String& book);
+    void recordPageTurn(const String& book, uint32_t offset);
+    bool toggleBookmark(const String& book, uint32_t offset);
+    bool hasBookmark(const String& book, uint32_t offset) const;
+    void forget(const String& book);
+    size_t bookCount() const { return _books.size(); }
+
+private:
+    struct StringHash {
+        size_t operator()(const String& value) const;
+    };
+
+    ReadingStateStore();
+    ReadingStateStore(const ReadingStateStore&) = delete;
+    ReadingStateStore& operator=(const ReadingStateStore&) = delete;
+
+    std::unordered_map<String, BookState, StringHash> _books;
+    std::vector<String> _pendingLines;
+    bool _loaded;
+    bool _writeScheduled;
+    unsigned long _lastChange;
+    unsigned long _lastTurnMs;
+    uint32_t _logRecords;
+
+    void _scheduleWrite();
+    void _queue(const String& record);
+    void _applyRecord(const String& line);
+    bool _appendPending();
+    void _importLegacyJson();
+    void _recoverTempFile();
+};
+
+#endif // READING_STATE_H
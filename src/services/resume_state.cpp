@@ -0,0 +1,189 @@
+#include "resume_state.h"
+#include <M5Unified.h>
+#include <SD.h>
+#include "../ui.h"
+#include "../crc32.h"
+#include "../settings.h"
+#include "reading_state.h"
+#include "../screens/files_screen.h"
+#include "../apps/reader/app_screen.h"
+#include "../games/minesweeper/game.h"
+#include "../games/sudoku/game.h"
+
+namespace resume_state {
+    static const uint32_t RECORD_MAGIC = 0x48355253; // "H5RS"
+    static const uint8_t RECORD_VERSION = 1;
+    static const char* RECORD_FILE = "/.resume_state";
+    static const char* RECORD_TEMP_FILE = "/.resume_state.tmp";
+
+    struct ResumeRecord {
+        uint32_t magic;
+        uint8_t version;
+        uint8_t screen;
+        uint8_t panel;
+        uint8_t reserved;
+        uint16_t filesPage;
+        uint16_t gameLength;
+        uint32_t readerOffset;
+        char path[128];
+        char book[96];
+        uint8_t game[160];
+        uint32_t crc;
+    };
+
+    RTC_NOINIT_ATTR static ResumeRecord rtcRecord;
+    static bool stalePanel = false;
+
+    static uint32_t recordCrc(const ResumeRecord& record) {
+        return crc32((const uint8_t*)&record, offsetof(ResumeRecord, crc));
+    }
+
+    static bool isValid(const ResumeRecord& record) {
+        return record.magic == RECORD_MAGIC && record.version == RECORD_VERSION && record.crc == recordCrc(record);
+    }
+
+    // Screens cheap enough to draw again at resume. The panel keeps showing the captured
+    // image; the draw only fills the framebuffer and the hit index the touch handlers look up.
+    static bool redrawnAtResume(ScreenType screen) {
+        switch (screen) {
+            case MAIN_SCREEN:
+            case FILES_SCREEN:
+            case APPS_SCREEN:
+            case GAMES_SCREEN:
+            case READER_APP_SCREEN:
+            case MINESWEEPER_GAME_SCREEN:
+            case SUDOKU_GAME_SCREEN:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static ScreenType resumableScreen(ScreenType screen) {
+        switch (screen) {
+            case MAIN_SCREEN:
+            case FILES_SCREEN:
+            case TXT_VIEWER_SCREEN:
+            case IMG_VIEWER_SCREEN:
+            case APPS_SCREEN:
+            case GAMES_SCREEN:
+            case READER_APP_SCREEN:
+            case CALCULATOR_APP_SCREEN:
+            case MINESWEEPER_GAME_SCREEN:
+            case SUDOKU_GAME_SCREEN:
+                return screen;
+            default:
+                return MAIN_SCREEN;
+        }
+    }
+
+    static bool writeRecordFile(const ResumeRecord& record) {
+        if (SD.exists(RECORD_TEMP_FILE)) SD.remove(RECORD_TEMP_FILE);
+        File file = SD.open(RECORD_TEMP_FILE, FILE_WRITE);
+        if (!file) return false;
+        bool ok = file.write((const uint8_t*)&record, sizeof(record)) == sizeof(record);
+        file.close();
+        if (!ok) {
+            SD.remove(RECORD_TEMP_FILE);
+            return false;
+        }
+        if (SD.exists(RECORD_FILE)) SD.remove(RECORD_FILE);
+        return SD.rename(RECORD_TEMP_FILE, RECORD_FILE);
+    }
+
+    static bool readRecordFile(ResumeRecord& record) {
+        if (SD.exists(RECORD_TEMP_FILE)) SD.remove(RECORD_TEMP_FILE);
+        File file = SD.open(RECORD_FILE, FILE_READ);
+        if (!file) return false;
+        bool ok = file.size() == sizeof(record) && file.read((uint8_t*)&record, sizeof(record)) == sizeof(record);
+        file.close();
+        return ok && isValid(record);
+    }
+
+    void capture(PanelState panel) {
+        ResumeRecord record;
+        memset(&record, 0, sizeof(record));
+        record.magic = RECORD_MAGIC;
+        record.version = RECORD_VERSION;
+        record.screen = (uint8_t)resumableScreen(currentScreen);
+        record.panel = record.screen == (uint8_t)currentScreen ? panel : PANEL_OTHER;
+        strncpy(record.path, currentPath.c_str(), sizeof(record.path) - 1);
+
+        if (currentScreen == FILES_SCREEN) {
+            record.filesPage = (uint16_t)screens::getCurrentPage();
+        } else if (currentScreen == READER_APP_SCREEN && apps_reader::isFileOpen()) {
+            strncpy(record.book, apps_reader::getCurrentFile().c_str(), sizeof(record.book) - 1);
+            record.readerOffset = apps_reader::getCurrentOffset();
+        } else if (currentScreen == MINESWEEPER_GAME_SCREEN) {
+            record.gameLength = (uint16_t)games_minesweeper::saveState(record.game, sizeof(record.game));
+        } else if (currentScreen == SUDOKU_GAME_SCREEN) {
+            record.gameLength = (uint16_t)games_sudoku::saveState(record.game, sizeof(record.game));
+        }
+        record.crc = recordCrc(record);
+
+        rtcRecord = record;
+        if (!writeRecordFile(record)) {
+            Serial.println("[Resume] Failed to write resume record");
+        }
+    }
+
+    bool restore() {
+        unsigned long start = millis();
+        ResumeRecord record;
+        bool fromRtc = isValid(rtcRecord);
+        if (fromRtc) {
+            record = rtcRecord;
+        } else if (!readRecordFile(record)) {
+            return false;
+        }
+        rtcRecord.magic = 0;
+        SD.remove(RECORD_FILE);
+
+        record.path[sizeof(record.path) - 1] = '\0';
+        record.book[sizeof(record.book) - 1] = '\0';
+        ScreenType screen = resumableScreen((ScreenType)record.screen);
+        bool restored = true;
+
+        currentPath = record.path[0] ? String(record.path) : String("/");
+        if (screen == FILES_SCREEN) {
+            screens::resumeFilesPage(record.filesPage);
+        } else if (screen == READER_APP_SCREEN) {
+            restored = apps_reader::resumeBook(String(record.book), record.readerOffset);
+        } else if (screen == MINESWEEPER_GAME_SCREEN) {
+            restored = games_minesweeper::restoreState(record.game, record.gameLength);
+        } else if (screen == SUDOKU_GAME_SCREEN) {
+            restored = games_sudoku::restoreState(record.game, record.gameLength);
+        }
+        if (!restored) {
+            screen = MAIN_SCREEN;
+        }
+
+        bool render = !restored || record.panel == PANEL_OTHER;
+        bool rebuild = !render && record.panel == PANEL_CURRENT && redrawnAtResume(screen);
+        stalePanel = !render && !rebuild;
+        resumeUI(screen, render || rebuild);
+        if (render) {
+            M5.Display.display();
+        }
+
+        Serial.printf("[Resume] Restored screen %d from %s in %lu ms%s\n", (int)screen, fromRtc ? "RTC" : "SD",
+                      millis() - start, render ? " (re-rendered)" : rebuild ? " (framebuffer only)" : "");
+        return true;
+    }
+
+    bool consumeStalePanel() {
+        bool stale = stalePanel;
+        stalePanel = false;
+        return stale;
+    }
+
+    void suspend() {
+        capture(PANEL_CURRENT);
+        Settings::getInstance().flush();
+        ReadingStateStore::getInstance().flush();
+        M5.Display.waitDisplay();
+        SD.end();
+        M5.Display.sleep();
+        M5.Power.deepSleep(0, true);
+    }
+}
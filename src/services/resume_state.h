@@ -0,0 +1,29 @@
+#ifndef RESUME_STATE_H
+#define RESUME_STATE_H
+
+#include <Arduino.h>
+
+namespace resume_state {
+
+    enum PanelState : uint8_t {
+        PANEL_CURRENT = 0,  // the panel shows the captured screen as rendered
+        PANEL_FROZEN = 1,   // the panel shows a full-screen freeze of the captured screen
+        PANEL_OTHER = 2     // the panel shows something else (off screen)
+    };
+
+    // Snapshots navigation state into RTC memory and /.resume_state on the card.
+    void capture(PanelState panel);
+
+    // Loads a snapshot (RTC first, then SD) and restores it. Returns false on a cold boot.
+    // The snapshot is consumed so a faulty one cannot trap the device in a boot loop.
+    bool restore();
+
+    // True once after a resume that left the panel out of sync with the UI state;
+    // the first touch should only re-render.
+    bool consumeStalePanel();
+
+    // Snapshots with PANEL_CURRENT and enters deep sleep with touch wakeup. Does not return.
+    void suspend();
+}
+
+#endif // RESUME_STATE_H
@@ -0,0 +1,71 @@
+#include "serial_console.h"
+
+namespace serial_console {
+    static const int MAX_COMMANDS = 12;
+    static const size_t MAX_LINE_LENGTH = 96;
+
+    struct Command {
+        const char* name;
+        CommandHandler handler;
+        const char* help;
+    };
+
+    static Command commands[MAX_COMMANDS];
+    static int commandCount = 0;
+    static String lineBuffer;
+
+    bool registerCommand(const char* name, CommandHandler handler, const char* help) {
+        for (int i = 0; i < commandCount; ++i) {
+            if (strcmp(commands[i].name, name) == 0) {
+                commands[i].handler = handler;
+                commands[i].help = help;
+                return true;
+            }
+        }
+        if (commandCount >= MAX_COMMANDS) return false;
+        commands[commandCount++] = { name, handler, help };
+        return true;
+    }
+
+    static void printHelp() {
+        Serial.println("Commands:");
+        for (int i = 0; i < commandCount; ++i) {
+            Serial.printf("  %-10s %s\n", commands[i].name, commands[i].help ? commands[i].help : "");
+        }
+    }
+
+    static void dispatch(String line) {
+        line.trim();
+        if (line.isEmpty()) return;
+        int space = line.indexOf(' ');
+        String name = space < 0 ? line : line.substring(0, space);
+        String args = space < 0 ? String("") : line.substring(space + 1);
+        args.trim();
+
+        for (int i = 0; i < commandCount; ++i) {
+            if (name == commands[i].name) {
+                commands[i].handler(args);
+                return;
+            }
+        }
+        if (name != "help") {
+            Serial.println("Unknown command: " + name);
+        }
+        printHelp();
+    }
+
+    void loop() {
+        while (Serial.available() > 0) {
+            char c = (char)Serial.read();
+            if (c == '\n' || c == '\r') {
+                if (!lineBuffer.isEmpty()) {
+                    String line = lineBuffer;
+                    lineBuffer = "";
+                    dispatch(line);
+                }
+            } else if (lineBuffer.length() < MAX_LINE_LENGTH) {
+                lineBuffer += c;
+            }
+        }
+    }
+}
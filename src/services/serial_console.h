@@ -0,0 +1,15 @@
+#ifndef SERIAL_CONSOLE_H
+#define SERIAL_CONSOLE_H
+
+#include <Arduino.h>
+
+namespace serial_console {
+    typedef void (*CommandHandler)(const String& args);
+
+    bool registerCommand(const char* name, CommandHandler handler, const char* help);
+
+    // Reads Serial without blocking and dispatches complete lines.
+    void loop();
+}
+
+#endif // SERIAL_CONSOLE_H
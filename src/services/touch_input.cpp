@@ -0,0 +1,187 @@
+#include "touch_input.h"
+#include <M5Unified.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#include "../debug_config.h"
+
+namespace touch_input {
+    static const gpio_num_t TOUCH_INT_PIN = GPIO_NUM_48;
+    static const int MOVE_THRESHOLD_PX = 3;
+
+    struct Contact {
+        bool active;
+        uint8_t id;
+        int16_t x;
+        int16_t y;
+    };
+
+    static volatile uint32_t interruptUs = 0;
+    static volatile uint32_t interruptCount = 0;
+    static uint32_t seenInterrupts = 0;
+
+    static TouchEvent queue[QUEUE_CAPACITY];
+    static int queueHead = 0;
+    static int queueCount = 0;
+    static uint32_t dropped = 0;
+
+    static Contact contacts[MAX_CONTACTS] = {};
+    static int primaryId = -1;
+    static uint32_t lastTapTarget = 0;
+    static uint32_t lastTapUs = 0;
+    static bool tapSeen = false;
+    static bool started = false;
+    static TouchListener listener = nullptr;
+
+    static void IRAM_ATTR onTouchInterrupt() {
+        interruptUs = (uint32_t)esp_timer_get_time();
+        interruptCount = interruptCount + 1;
+    }
+
+    void begin() {
+        if (started) return;
+        started = true;
+        attachInterrupt(digitalPinToInterrupt(TOUCH_INT_PIN), onTouchInterrupt, FALLING);
+    }
+
+    void setListener(TouchListener callback) {
+        listener = callback;
+    }
+
+    void rearm(bool touchWakeup) {
+        if (!started) return;
+        gpio_set_intr_type(TOUCH_INT_PIN, GPIO_INTR_NEGEDGE);
+        if (touchWakeup) {
+            interruptUs = (uint32_t)esp_timer_get_time();
+            interruptCount = interruptCount + 1;
+        }
+    }
+
+    static void push(const TouchEvent& event) {
+        if (event.type == TOUCH_MOVE && queueCount > 0) {
+            TouchEvent& last = queue[(queueHead + queueCount - 1) % QUEUE_CAPACITY];
+            if (last.type == TOUCH_MOVE && last.id == event.id) {
+                last = event;
+                return;
+            }
+        }
+        if (queueCount == QUEUE_CAPACITY) {
+            queueHead = (queueHead + 1) % QUEUE_CAPACITY;
+            queueCount--;
+            dropped++;
+        }
+        queue[(queueHead + queueCount) % QUEUE_CAPACITY] = event;
+        queueCount++;
+    }
+
+    static void emit(TouchEventType type, const Contact& contact, uint32_t timeUs) {
+        TouchEvent event;
+        event.timeUs = timeUs;
+        event.x = contact.x;
+        event.y = contact.y;
+        event.id = contact.id;
+        event.type = type;
+        event.primary = contact.id == primaryId;
+        if (listener) listener(event);
+        push(event);
+    }
+
+    static Contact* findContact(uint8_t id) {
+        for (int i = 0; i < MAX_CONTACTS; ++i) {
+            if (contacts[i].active && contacts[i].id == id) return &contacts[i];
+        }
+        return nullptr;
+    }
+
+    static Contact* freeContact() {
+        for (int i = 0; i < MAX_CONTACTS; ++i) {
+            if (!contacts[i].active) return &contacts[i];
+        }
+        return nullptr;
+    }
+
+    void poll() {
+        if (!started) return;
+        uint32_t count = interruptCount;
+        bool fired = count != seenInterrupts || gpio_get_level(TOUCH_INT_PIN) == 0;
+        if (!fired && !isTouching()) return;
+        seenInterrupts = count;
+        uint32_t stamp = count != 0 && fired ? interruptUs : (uint32_t)esp_timer_get_time();
+
+        lgfx::touch_point_t points[MAX_CONTACTS];
+        int pointCount = M5.Display.getTouchRaw(points, MAX_CONTACTS);
+        if (pointCount > 0) {
+            M5.Display.convertRawXY(points, pointCount);
+        }
+
+        bool seen[MAX_CONTACTS] = {};
+        for (int i = 0; i < pointCount; ++i) {
+            uint8_t id = (uint8_t)points[i].id;
+            Contact* contact = findContact(id);
+            if (!contact) {
+                contact = freeContact();
+                if (!contact) continue;
+                contact->active = true;
+                contact->id = id;
+                contact->x = points[i].x;
+                contact->y = points[i].y;
+                if (primaryId < 0) primaryId = id;
+                emit(TOUCH_DOWN, *contact, stamp);
+            } else if (abs(points[i].x - contact->x) >= MOVE_THRESHOLD_PX ||
+                       abs(points[i].y - contact->y) >= MOVE_THRESHOLD_PX) {
+                contact->x = points[i].x;
+                contact->y = points[i].y;
+                emit(TOUCH_MOVE, *contact, stamp);
+            }
+            seen[contact - contacts] = true;
+        }
+
+        for (int i = 0; i < MAX_CONTACTS; ++i) {
+            if (!contacts[i].active || seen[i]) continue;
+            emit(TOUCH_UP, contacts[i], stamp);
+            contacts[i].active = false;
+            if (contacts[i].id == primaryId) primaryId = -1;
+        }
+    }
+
+    bool next(TouchEvent& out) {
+        if (queueCount == 0) return false;
+        out = queue[queueHead];
+        queueHead = (queueHead + 1) % QUEUE_CAPACITY;
+        queueCount--;
+        return true;
+    }
+
+    bool peek(TouchEvent& out) {
+        if (queueCount == 0) return false;
+        out = queue[queueHead];
+        return true;
+    }
+
+    int pending() {
+        return queueCount;
+    }
+
+    bool isTouching() {
+        for (int i = 0; i < MAX_CONTACTS; ++i) {
+            if (contacts[i].active) return true;
+        }
+        return false;
+    }
+
+    bool acceptTap(uint32_t targetKey, uint32_t timeUs) {
+        if (tapSeen && targetKey == lastTapTarget && timeUs - lastTapUs < TARGET_DEBOUNCE_US) {
+#ifdef DEBUG_TOUCH
+            Serial.printf("[Touch] Debounced repeat on target %08lx\n", (unsigned long)targetKey);
+#endif
+            return false;
+        }
+        tapSeen = true;
+        lastTapTarget = targetKey;
+        lastTapUs = timeUs;
+        return true;
+    }
+
+    uint32_t droppedEvents() {
+        return dropped;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef TOUCH_INPUT_H
+#define TOUCH_INPUT_H
+
+#include <Arduino.h>
+
+// GT911 input driven by its INT line: the ISR only timestamps, poll() reads
+// the controller when INT fired (or a contact is held) and queues events.
+namespace touch_input {
+
+    enum TouchEventType : uint8_t {
+        TOUCH_DOWN,
+        TOUCH_MOVE,
+        TOUCH_UP
+    };
+
+    struct TouchEvent {
+        uint32_t timeUs;
+        int16_t x;
+        int16_t y;
+        uint8_t id;
+        TouchEventType type;
+        bool primary;
+    };
+
+    typedef void (*TouchListener)(const TouchEvent& event);
+
+    static const int QUEUE_CAPACITY = 32;
+    static const int MAX_CONTACTS = 2;
+    static const uint32_t TARGET_DEBOUNCE_US = 120000;
+
+    void begin();
+    void poll();
+
+    // Sees every event as it is sampled, before move coalescing.
+    void setListener(TouchListener listener);
+
+    bool next(TouchEvent& out);
+    bool peek(TouchEvent& out);
+    int pending();
+    bool isTouching();
+
+    // Restores edge-triggered INT after light sleep reprogrammed it for wakeup.
+    void rearm(bool touchWakeup);
+
+    // False when the same target was already tapped within TARGET_DEBOUNCE_US.
+    bool acceptTap(uint32_t targetKey, uint32_t timeUs);
+
+    uint32_t droppedEvents();
+}
+
+#endif // TOUCH_INPUT_H
@@ -1,20 +1,191 @@
 #include "settings.h"
+#include <Preferences.h>
+#include "crc32.h"
+#include "services/power_telemetry.h"
+#include "services/heap_telemetry.h"
 
-Settings::Settings() {
-    if (!SD.exists(_settingsFile)) {
-        _createDefaultSettings();
+namespace {
+    const char* NVS_NAMESPACE = "hi5set";
+    const char* NVS_BLOB_KEY = "blob";
+    const uint8_t BLOB_MAGIC_0 = 'H';
+    const uint8_t BLOB_MAGIC_1 = '5';
+    const size_t BLOB_HEADER_SIZE = 12;
+    const size_t BLOB_CAPACITY = 768;
+
+    void put32(uint8_t* p, uint32_t v) {
+        p[0] = v & 0xFF;
+        p[1] = (v >> 8) & 0xFF;
+        p[2] = (v >> 16) & 0xFF;
+        p[3] = (v >> 24) & 0xFF;
+    }
+
+    uint32_t get32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    JsonVariant lookup(JsonDocument& doc, const char* key) {
+        const char* dot = strchr(key, '.');
+        if (!dot) return doc[key];
+        String group(key);
+        group = group.substring(0, dot - key);
+        return doc[group][dot + 1];
+    }
+
+    template <typename T>
+    void assign(JsonDocument& doc, const char* key, const T& value) {
+        const char* dot = strchr(key, '.');
+        if (!dot) {
+            doc[key] = value;
+            return;
+        }
+        String group(key);
+        group = group.substring(0, dot - key);
+        doc[group][dot + 1] = value;
+    }
+}
+
+Settings& Settings::getInstance() {
+    static Settings instance;
+    return instance;
+}
+
+Settings::Settings() : _loaded(false), _dirtyKeys(0), _lastChange(0), _jsonMtime(0), _jsonSize(0) {
+    resetToDefaults();
+}
+
+bool Settings::begin() {
+    if (_loaded) return true;
+    _loaded = true;
+    _recoverTempFile();
+
+    unsigned long start = micros();
+    bool blobLoaded = _loadBlob();
+    uint32_t mtime = 0;
+    uint32_t size = 0;
+    bool jsonExists = _statJson(mtime, size);
+
+    if (!jsonExists) {
+        for (uint8_t key = 0; key < SETTING_COUNT; ++key) {
+            _markDirty((SettingKey)key);
+        }
+        return flush();
+    }
+    if (blobLoaded && mtime == _jsonMtime && size == _jsonSize) {
+        Serial.printf("Settings loaded from NVS in %lu us.\n", micros() - start);
+        return true;
+    }
+
+    if (!blobLoaded) resetToDefaults();
+    if (!importJson()) return blobLoaded;
+    _jsonMtime = mtime;
+    _jsonSize = size;
+    Serial.printf("Settings imported from %s in %lu us.\n", _settingsFile.c_str(), micros() - start);
+    return isDirty() ? flush() : _saveBlob();
+}
+
+void Settings::loop() {
+    if (_dirtyKeys != 0 && millis() - _lastChange >= FLUSH_DELAY_MS) {
+        flush();
+    }
+}
+
+bool Settings::flush() {
+    if (_dirtyKeys == 0) return true;
+    POWER_SCOPE(POWER_SD);
+    HEAP_TAG(HEAP_SETTINGS);
+    bool exported = exportJson();
+    bool saved = _saveBlob();
+    if (!saved) return false;
+    _dirtyKeys = 0;
+    return exported;
+}
+
+bool Settings::isDirty() const {
+    return _dirtyKeys != 0;
+}
+
+int32_t Settings::getInt(SettingKey key) const {
+    return key < SETTING_COUNT ? _ints[key] : 0;
+}
+
+bool Settings::getBool(SettingKey key) const {
+    return getInt(key) != 0;
+}
+
+String Settings::getString(SettingKey key) const {
+    return key < SETTING_COUNT ? _strings[key] : String();
+}
+
+bool Settings::isValid(SettingKey key, int32_t value) const {
+    if (key >= SETTING_COUNT) return false;
+    const SettingDef& def = SETTINGS_SCHEMA[key];
+    if (value < def.minValue || value > def.maxValue) return false;
+    return def.validator == nullptr || def.validator(value);
+}
+
+bool Settings::setInt(SettingKey key, int32_t value) {
+    if (key >= SETTING_COUNT || SETTINGS_SCHEMA[key].type == SettingType::STRING) return false;
+    if (!isValid(key, value)) return false;
+    if (_ints[key] != value) {
+        _ints[key] = value;
+        _markDirty(key);
+    }
+    return true;
+}
+
+bool Settings::setBool(SettingKey key, bool value) {
+    return setInt(key, value ? 1 : 0);
+}
+
+bool Settings::setString(SettingKey key, const String& value) {
+    if (key >= SETTING_COUNT || SETTINGS_SCHEMA[key].type != SettingType::STRING) return false;
+    if ((int32_t)value.length() > SETTINGS_SCHEMA[key].maxValue) return false;
+    if (_strings[key] != value) {
+        _strings[key] = value;
+        _markDirty(key);
+    }
+    return true;
+}
+
+void Settings::resetToDefaults() {
+    for (uint8_t key = 0; key < SETTING_COUNT; ++key) {
+        _ints[key] = SETTINGS_SCHEMA[key].defaultInt;
+        _strings[key] = SETTINGS_SCHEMA[key].defaultString;
+    }
+}
+
+void Settings::_markDirty(SettingKey key) {
+    _dirtyKeys |= (1UL << key);
+    _lastChange = millis();
+}
+
+void Settings::_recoverTempFile() {
+    if (!SD.exists(_tempFile)) return;
+    if (SD.exists(_settingsFile)) {
+        SD.remove(_tempFile);
+    } else {
+        Serial.println("Recovering settings from interrupted save.");
+        SD.rename(_tempFile, _settingsFile);
     }
-    loadSettings();
 }
 
-bool Settings::loadSettings() {
+bool Settings::_statJson(uint32_t& mtime, uint32_t& size) const {
+    File file = SD.open(_settingsFile, FILE_READ);
+    if (!file) return false;
+    mtime = (uint32_t)file.getLastWrite();
+    size = file.size();
+    file.close();
+    return true;
+}
+
+bool Settings::importJson() {
     File file = SD.open(_settingsFile, FILE_READ);
     if (!file) {
         Serial.println("Failed to open settings file for reading.");
         return false;
     }
 
-    StaticJsonDocument<512> doc;
+    JsonDocument doc;
     DeserializationError error = deserializeJson(doc, file);
     file.close();
 
@@ -23,104 +194,181 @@ bool Settings::loadSettings() {
         return false;
     }
 
-    _wifiSettings.ssid = doc["wifi"]["ssid"].as<String>();
-    _wifiSettings.password = doc["wifi"]["password"].as<String>();
+    for (uint8_t i = 0; i < SETTING_COUNT; ++i) {
+        SettingKey key = (SettingKey)i;
+        const SettingDef& def = SETTINGS_SCHEMA[key];
+        JsonVariant value = lookup(doc, def.key);
+        bool accepted = false;
+        if (def.type == SettingType::STRING && value.is<const char*>()) {
+            accepted = setString(key, value.as<String>());
+        } else if (def.type == SettingType::BOOL && value.is<bool>()) {
+            accepted = setBool(key, value.as<bool>());
+        } else if (def.type == SettingType::INT && value.is<int32_t>()) {
+            accepted = setInt(key, value.as<int32_t>());
+        }
+        if (!accepted) {
+            Serial.printf("Settings: '%s' missing or invalid, keeping current value.\n", def.key);
+            _markDirty(key);
+        }
+    }
+    return true;
+}
 
+bool Settings::exportJson() {
+    JsonDocument doc;
+    for (uint8_t i = 0; i < SETTING_COUNT; ++i) {
+        SettingKey key = (SettingKey)i;
+        const SettingDef& def = SETTINGS_SCHEMA[key];
+        if (def.type == SettingType::STRING) {
+            assign(doc, def.key, _strings[key]);
+        } else if (def.type == SettingType::BOOL) {
+            assign(doc, def.key, _ints[key] != 0);
+        } else {
+            assign(doc, def.key, _ints[key]);
+        }
+    }
 
-    bool saveNeeded = false;
-    if (!doc.containsKey("lastConnectedSSID")) {
-        doc["lastConnectedSSID"] = "";
-        saveNeeded = true;
+    File file = SD.open(_tempFile, FILE_WRITE);
+    if (!file) {
+        Serial.println("Failed to open settings file for writing.");
+        return false;
     }
-    if (!doc.containsKey("lastConnectedPassword")) {
-        doc["lastConnectedPassword"] = "";
-        saveNeeded = true;
+    if (serializeJsonPretty(doc, file) == 0) {
+        Serial.println("Failed to write to settings file.");
+        file.close();
+        SD.remove(_tempFile);
+        return false;
     }
+    file.flush();
+    file.close();
 
-    _lastConnectedSSID = doc["lastConnectedSSID"].as<String>();
-    _lastConnectedPassword = doc["lastConnectedPassword"].as<String>();
+    if (SD.exists(_settingsFile) && !SD.remove(_settingsFile)) {
+        Serial.println("Failed to replace settings file.");
+        return false;
+    }
+    if (!SD.rename(_tempFile, _settingsFile)) {
+        Serial.println("Failed to rename settings file.");
+        return false;
+    }
+    return _statJson(_jsonMtime, _jsonSize);
+}
 
-    if (saveNeeded) {
+size_t Settings::_encodeBlob(uint8_t* out, size_t capacity) const {
+    out[0] = BLOB_MAGIC_0;
+    out[1] = BLOB_MAGIC_1;
+    out[2] = SETTINGS_SCHEMA_VERSION;
+    out[3] = SETTING_COUNT;
+    put32(out + 4, _jsonMtime);
+    put32(out + 8, _jsonSize);
+    size_t pos = BLOB_HEADER_SIZE;
 
-        file.close();
-        saveSettings();
-    } else {
-        file.close();
+    for (uint8_t key = 0; key < SETTING_COUNT; ++key) {
+        const SettingDef& def = SETTINGS_SCHEMA[key];
+        size_t length = def.type == SettingType::STRING ? 1 + _strings[key].length() : 4;
+        if (pos + 2 + length + 4 > capacity) return 0;
+        out[pos++] = key;
+        out[pos++] = (uint8_t)def.type;
+        if (def.type == SettingType::STRING) {
+            out[pos++] = (uint8_t)_strings[key].length();
+            memcpy(out + pos, _strings[key].c_str(), _strings[key].length());
+            pos += _strings[key].length();
+        } else {
+            put32(out + pos, (uint32_t)_ints[key]);
+            pos += 4;
+        }
     }
 
-    return true;
+    put32(out + pos, crc32(out, pos));
+    return pos + 4;
 }
 
-bool Settings::saveSettings() {
-    File file = SD.open(_settingsFile, FILE_WRITE);
-    if (!file) {
-        Serial.println("Failed to open settings file for writing.");
-        return false;
+bool Settings::_decodeBlob(const uint8_t* data, size_t length) {
+    if (length < BLOB_HEADER_SIZE + 4) return false;
+    if (data[0] != BLOB_MAGIC_0 || data[1] != BLOB_MAGIC_1 || data[2] != SETTINGS_SCHEMA_VERSION) return false;
+    if (crc32(data, length - 4) != get32(data + length - 4)) return false;
+
+    resetToDefaults();
+    size_t end = length - 4;
+    size_t pos = BLOB_HEADER_SIZE;
+    while (pos + 2 <= end) {
+        uint8_t key = data[pos++];
+        SettingType type = (SettingType)data[pos++];
+        if (type == SettingType::STRING) {
+            if (pos >= end || pos + 1 + data[pos] > end) return false;
+            uint8_t len = data[pos++];
+            if (key < SETTING_COUNT && SETTINGS_SCHEMA[key].type == type && len <= SETTINGS_SCHEMA[key].maxValue) {
+                char buffer[SETTING_STRING_MAX_LENGTH + 1];
+                memcpy(buffer, data + pos, len);
+                buffer[len] = '\0';
+                _strings[key] = buffer;
+            }
+            pos += len;
+        } else {
+            if (pos + 4 > end) return false;
+            int32_t value = (int32_t)get32(data + pos);
+            pos += 4;
+            if (key < SETTING_COUNT && SETTINGS_SCHEMA[key].type == type && isValid((SettingKey)key, value)) {
+                _ints[key] = value;
+            }
+        }
     }
 
-    StaticJsonDocument<512> doc;
-    doc["wifi"]["ssid"] = _wifiSettings.ssid;
-    doc["wifi"]["password"] = _wifiSettings.password;
-    doc["lastConnectedSSID"] = _lastConnectedSSID;
-    doc["lastConnectedPassword"] = _lastConnectedPassword;
+    _jsonMtime = get32(data + 4);
+    _jsonSize = get32(data + 8);
+    return true;
+}
 
-    if (serializeJson(doc, file) == 0) {
-        Serial.println("Failed to write to settings file.");
-        file.close();
+bool Settings::_loadBlob() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) return false;
+    uint8_t blob[BLOB_CAPACITY];
+    size_t length = prefs.getBytesLength(NVS_BLOB_KEY);
+    bool loaded = length > 0 && length <= BLOB_CAPACITY &&
+                  prefs.getBytes(NVS_BLOB_KEY, blob, length) == length &&
+                  _decodeBlob(blob, length);
+    prefs.end();
+    return loaded;
+}
+
+bool Settings::_saveBlob() {
+    uint8_t blob[BLOB_CAPACITY];
+    size_t length = _encodeBlob(blob, sizeof(blob));
+    if (length == 0) return false;
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        Serial.println("Failed to open settings NVS namespace.");
         return false;
     }
-
-    file.close();
-    return true;
+    bool saved = prefs.putBytes(NVS_BLOB_KEY, blob, length) == length;
+    prefs.end();
+    return saved;
 }
 
 WiFiSettings Settings::getWiFiSettings() const {
-    return _wifiSettings;
+    WiFiSettings settings;
+    settings.ssid = _strings[SETTING_WIFI_SSID];
+    settings.password = _strings[SETTING_WIFI_PASSWORD];
+    return settings;
 }
 
 void Settings::setWiFiSettings(const String& ssid, const String& password) {
-    _wifiSettings.ssid = ssid;
-    _wifiSettings.password = password;
-    saveSettings();
+    setString(SETTING_WIFI_SSID, ssid);
+    setString(SETTING_WIFI_PASSWORD, password);
 }
 
 String Settings::getLastConnectedSSID() const {
-    return _lastConnectedSSID;
+    return _strings[SETTING_LAST_SSID];
 }
 
 void Settings::setLastConnectedSSID(const String& ssid) {
-    _lastConnectedSSID = ssid;
-    saveSettings();
+    setString(SETTING_LAST_SSID, ssid);
 }
 
 String Settings::getLastConnectedPassword() const {
-    return _lastConnectedPassword;
+    return _strings[SETTING_LAST_PASSWORD];
 }
 
 void Settings::setLastConnectedPassword(const String& password) {
-    _lastConnectedPassword = password;
-    saveSettings();
+    setString(SETTING_LAST_PASSWORD, password);
 }
-
-bool Settings::_createDefaultSettings() {
-    File file = SD.open(_settingsFile, FILE_WRITE);
-    if (!file) {
-        Serial.println("Failed to create settings file.");
-        return false;
-    }
-
-    StaticJsonDocument<128> doc;
-    doc["wifi"]["ssid"] = "";
-    doc["wifi"]["password"] = "";
-    doc["lastConnectedSSID"] = "";
-    doc["lastConnectedPassword"] = "";
-
-    if (serializeJson(doc, file) == 0) {
-        Serial.println("Failed to write default settings.");
-        file.close();
-        return false;
-    }
-
-    file.close();
-    return true;
-}
\ No newline at end of file
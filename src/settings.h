@@ -4,6 +4,7 @@
 #include <ArduinoJson.h>
 #include <SD.h>
 #include <WiFi.h>
+#include "settings_schema.h"
 
 struct WiFiSettings {
     String ssid;
@@ -12,9 +13,25 @@ struct WiFiSettings {
 
 class Settings {
 public:
-    Settings();
-    bool loadSettings();
-    bool saveSettings();
+    static Settings& getInstance();
+
+    bool begin();
+    void loop();
+    bool flush();
+    bool isDirty() const;
+
+    int32_t getInt(SettingKey key) const;
+    bool getBool(SettingKey key) const;
+    String getString(SettingKey key) const;
+    bool setInt(SettingKey key, int32_t value);
+    bool setBool(SettingKey key, bool value);
+    bool setString(SettingKey key, const String& value);
+    bool isValid(SettingKey key, int32_t value) const;
+    void resetToDefaults();
+
+    bool importJson();
+    bool exportJson();
+
     WiFiSettings getWiFiSettings() const;
     void setWiFiSettings(const String& ssid, const String& password);
     String getLastConnectedSSID() const;
@@ -23,12 +40,29 @@ public:
     void setLastConnectedPassword(const String& password);
 
 private:
-    WiFiSettings _wifiSettings;
-    String _lastConnectedSSID;
-    String _lastConnectedPassword;
+    Settings();
+    Settings(const Settings&) = delete;
+    Settings& operator=(const Settings&) = delete;
+
+    int32_t _ints[SETTING_COUNT];
+    String _strings[SETTING_COUNT];
     const String _settingsFile = "/settings.json";
+    const String _tempFile = "/settings.json.tmp";
+    static const unsigned long FLUSH_DELAY_MS = 2000;
+
+    bool _loaded;
+    uint32_t _dirtyKeys;
+    unsigned long _lastChange;
+    uint32_t _jsonMtime;
+    uint32_t _jsonSize;
 
-    bool _createDefaultSettings();
+    void _markDirty(SettingKey key);
+    void _recoverTempFile();
+    bool _statJson(uint32_t& mtime, uint32_t& size) const;
+    size_t _encodeBlob(uint8_t* out, size_t capacity) const;
+    bool _decodeBlob(const uint8_t* data, size_t length);
+    bool _loadBlob();
+    bool _saveBlob();
 };
 
-#endif // SETTINGS_H
\ No newline at end of file
+#endif // SETTINGS_H
@@ -0,0 +1,85 @@
+#ifndef SETTINGS_SCHEMA_H
+#define SETTINGS_SCHEMA_H
+
+#include <stdint.h>
+
+enum class SettingType : uint8_t {
+    BOOL,
+    INT,
+    STRING
+};
+
+enum SettingKey : uint8_t {
+    SETTING_WIFI_SSID,
+    SETTING_WIFI_PASSWORD,
+    SETTING_LAST_SSID,
+    SETTING_LAST_PASSWORD,
+    SETTING_READER_FONT_SIZE,
+    SETTING_REFRESH_POLICY,
+    SETTING_LIGHT_SLEEP_TIMEOUT,
+    SETTING_DEEP_SLEEP_TIMEOUT,
+    SETTING_GATEWAY_PORT,
+    SETTING_BATTERY_CURVE,
+    SETTING_BATTERY_CAPACITY,
+    SETTING_GESTURE_LONG_PRESS,
+    SETTING_GESTURE_DOUBLE_TAP,
+    SETTING_GESTURE_SWIPE_MIN,
+    SETTING_COUNT
+};
+
+enum RefreshPolicy : uint8_t {
+    REFRESH_QUALITY,
+    REFRESH_FAST,
+    REFRESH_PARTIAL_THEN_FULL
+};
+
+typedef bool (*SettingValidator)(int32_t value);
+
+struct SettingDef {
+    const char* key;
+    SettingType type;
+    int32_t defaultInt;
+    const char* defaultString;
+    int32_t minValue;
+    int32_t maxValue;
+    SettingValidator validator;
+};
+
+inline bool isValidGatewayPort(int32_t port) {
+    return port == 80 || (port >= 1024 && port < 65535);
+}
+
+const uint8_t SETTINGS_SCHEMA_VERSION = 1;
+const uint8_t SETTING_STRING_MAX_LENGTH = 64;
+
+constexpr SettingDef SETTINGS_SCHEMA[SETTING_COUNT] = {
+    { "wifi.ssid",             SettingType::STRING, 0,      "", 0,   32,    nullptr },
+    { "wifi.password",         SettingType::STRING, 0,      "", 0,   63,    nullptr },
+    { "lastConnectedSSID",     SettingType::STRING, 0,      "", 0,   32,    nullptr },
+    { "lastConnectedPassword", SettingType::STRING, 0,      "", 0,   63,    nullptr },
+    { "reader.fontSize",       SettingType::INT,    2,      "", 1,   5,     nullptr },
+    { "display.refreshPolicy", SettingType::INT,    REFRESH_QUALITY, "", REFRESH_QUALITY, REFRESH_PARTIAL_THEN_FULL, nullptr },
+    { "power.lightSleepMs",    SettingType::INT,    1500,   "", 0,   600000, nullptr },
+    { "power.deepSleepMin",    SettingType::INT,    0,      "", 0,   1440,  nullptr },
+    { "gateway.port",          SettingType::INT,    8080,   "", 1,   65534, isValidGatewayPort },
+    { "battery.curve",         SettingType::STRING, 0,      "0,10,30,55,75,90,100", 0, 40, nullptr },
+    { "battery.capacityMah",   SettingType::INT,    1800,   "", 200, 10000, nullptr },
+    { "gesture.longPressMs",   SettingType::INT,    600,    "", 200, 3000,  nullptr },
+    { "gesture.doubleTapMs",   SettingType::INT,    300,    "", 100, 1000,  nullptr },
+    { "gesture.swipeMinPx",    SettingType::INT,    50,     "", 20,  300,   nullptr }
+};
+
+constexpr bool settingsSchemaValid(int index = 0) {
+    return index >= SETTING_COUNT ||
+        (SETTINGS_SCHEMA[index].key != nullptr &&
+         SETTINGS_SCHEMA[index].minValue <= SETTINGS_SCHEMA[index].maxValue &&
+         (SETTINGS_SCHEMA[index].type == SettingType::STRING ?
+          SETTINGS_SCHEMA[index].maxValue <= SETTING_STRING_MAX_LENGTH :
+          (SETTINGS_SCHEMA[index].defaultInt >= SETTINGS_SCHEMA[index].minValue &&
+           SETTINGS_SCHEMA[index].defaultInt <= SETTINGS_SCHEMA[index].maxValue)) &&
+         settingsSchemaValid(index + 1));
+}
+
+static_assert(settingsSchemaValid(), "Settings schema defaults and string lengths must lie within their ranges");
+
+#endif // SETTINGS_SCHEMA_H
@@ -0,0 +1,131 @@
+#ifndef TEXT_TYPES_H
+#define TEXT_TYPES_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Non-owning view of UTF-8 bytes. Not necessarily NUL-terminated, so draw
+// calls that need a C string go through a copy (bufferRow, ArenaString).
+class TextSpan {
+public:
+    constexpr TextSpan() : _data(""), _length(0) {}
+    constexpr TextSpan(const char* text, size_t length) : _data(text), _length(length) {}
+    TextSpan(const char* text) : _data(text ? text : ""), _length(text ? strlen(text) : 0) {}
+    TextSpan(const String& text) : _data(text.c_str()), _length(text.length()) {}
+
+    const char* data() const { return _data; }
+    size_t length() const { return _length; }
+    bool empty() const { return _length == 0; }
+    char operator[](size_t index) const { return _data[index]; }
+
+    bool startsWith(TextSpan prefix) const {
+        return prefix._length <= _length && memcmp(_data, prefix._data, prefix._length) == 0;
+    }
+
+    bool endsWith(TextSpan suffix) const {
+        return suffix._length <= _length && memcmp(_data + _length - suffix._length, suffix._data, suffix._length) == 0;
+    }
+
+    TextSpan substr(size_t start, size_t count = (size_t)-1) const {
+        if (start > _length) start = _length;
+        if (count > _length - start) count = _length - start;
+        return TextSpan(_data + start, count);
+    }
+
+    // Longest prefix of at most maxBytes that does not end inside a UTF-8 sequence.
+    TextSpan prefix(size_t maxBytes) const {
+        if (maxBytes >= _length) return *this;
+        size_t cut = maxBytes;
+        while (cut > 0 && ((uint8_t)_data[cut] & 0xC0) == 0x80) cut--;
+        return TextSpan(_data, cut);
+    }
+
+    size_t codepoints() const {
+        size_t count = 0;
+        for (size_t i = 0; i < _length; ++i) {
+            if (((uint8_t)_data[i] & 0xC0) != 0x80) count++;
+        }
+        return count;
+    }
+
+    int compare(TextSpan other) const {
+        size_t common = _length < other._length ? _length : other._length;
+        int result = memcmp(_data, other._data, common);
+        if (result != 0) return result;
+        return _length < other._length ? -1 : (_length > other._length ? 1 : 0);
+    }
+
+private:
+    const char* _data;
+    size_t _length;
+};
+
+inline bool operator==(TextSpan a, TextSpan b) {
+    return a.length() == b.length() && memcmp(a.data(), b.data(), a.length()) == 0;
+}
+
+inline bool operator!=(TextSpan a, TextSpan b) {
+    return !(a == b);
+}
+
+// NUL-terminated string stored inline with a fixed capacity of N - 1 bytes.
+// Trivially copyable, never allocates; text that does not fit is cut at a
+// UTF-8 boundary and assign()/append() report it.
+template <size_t N>
+class InlineString {
+    static_assert(N > 1 && N <= 65536, "InlineString capacity must fit its uint16_t length");
+
+public:
+    InlineString() : _length(0) { _data[0] = '\0'; }
+    InlineString(const char* text) { assign(TextSpan(text)); }
+    explicit InlineString(TextSpan text) { assign(text); }
+
+    InlineString& operator=(const char* text) {
+        assign(TextSpan(text));
+        return *this;
+    }
+
+    InlineString& operator=(TextSpan text) {
+        assign(text);
+        return *this;
+    }
+
+    bool assign(TextSpan text) {
+        TextSpan fitted = text.prefix(N - 1);
+        memmove(_data, fitted.data(), fitted.length());
+        _length = fitted.length();
+        _data[_length] = '\0';
+        return fitted.length() == text.length();
+    }
+
+    bool append(TextSpan text) {
+        TextSpan fitted = text.prefix(N - 1 - _length);
+        memmove(_data + _length, fitted.data(), fitted.length());
+        _length += fitted.length();
+        _data[_length] = '\0';
+        return fitted.length() == text.length();
+    }
+
+    void clear() {
+        _length = 0;
+        _data[0] = '\0';
+    }
+
+    const char* c_str() const { return _data; }
+    size_t length() const { return _length; }
+    bool empty() const { return _length == 0; }
+    static constexpr size_t capacity() { return N - 1; }
+
+    operator TextSpan() const { return TextSpan(_data, _length); }
+    TextSpan span() const { return TextSpan(_data, _length); }
+    bool endsWith(TextSpan suffix) const { return span().endsWith(suffix); }
+    bool startsWith(TextSpan prefix) const { return span().startsWith(prefix); }
+
+private:
+    char _data[N];
+    uint16_t _length;
+};
+
+#endif // TEXT_TYPES_H
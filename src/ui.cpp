@@ -1,16 +1,13 @@
 #include "ui.h"
 #include <WiFi.h>
+#include "services/power_telemetry.h"
+#include "services/latency_trace.h"
+#include "services/profiler.h"
+#include "services/heap_telemetry.h"
 
 
-#include "apps/text_lang_test/app_screen.h"
-#include "apps/test2/app_screen.h"
-#include "apps/geometry_test/app_screen.h"
-#include "apps/swipe_test/app_screen.h"
-#include "apps/calculator/app_screen.h"
-#include "games/minesweeper/game.h"
-#include "games/sudoku/game.h"
-#include "games/test/game.h"
-#include "screens/games_screen.h"
+#include "screen_registry.h"
+#include "hit_index.h"
 
 
 bool firstRenderDone = false;
@@ -22,10 +19,13 @@ Footer footer;
 Message currentMessage = {"", 0};
 ScreenType currentScreen = MAIN_SCREEN;
 String currentPath = "/";
-String displayedFiles[MAX_DISPLAYED_FILES];
+TextSpan displayedFiles[MAX_DISPLAYED_FILES];
 int displayedFilesCount = 0;
 BufferedRow rowsBuffer[MAX_ROWS_BUFFER];
 int rowsBufferCount = 0;
+RenderStats renderStats = {0, 0, 0};
+static ScreenType arenaScreen = SCREEN_COUNT;
+static int renderDepth = 0;
 
 
 void setUniversalFont() {
@@ -43,7 +43,7 @@ int getRowFromY(int y) {
 }
 
 
-void drawRow(const String& text, int row, uint16_t textColor, uint16_t bgColor, int fontSize, bool underline) {
+void drawRow(const char* text, int row, uint16_t textColor, uint16_t bgColor, int fontSize, bool underline) {
     RowPosition pos = getRowPosition(row);
     M5.Display.fillRect(pos.x, pos.y, pos.width, pos.height, bgColor);
     M5.Display.setCursor(pos.x + 10, pos.y + 10);
@@ -52,7 +52,7 @@ void drawRow(const String& text, int row, uint16_t textColor, uint16_t bgColor,
     M5.Display.print(text);
     
     if (underline) {
-        int textWidth = M5.Display.textWidth(text.c_str());
+        int textWidth = M5.Display.textWidth(text);
         int underlineY = pos.y + 40;
         M5.Display.drawLine(pos.x + 10, underlineY, pos.x + 10 + textWidth, underlineY, TFT_BLACK);
     }
@@ -61,14 +61,22 @@ void drawRow(const String& text, int row, uint16_t textColor, uint16_t bgColor,
 
 void drawRowsBuffered() {
     for (int i = 0; i < rowsBufferCount; i++) {
-        drawRow(rowsBuffer[i].text, rowsBuffer[i].row, rowsBuffer[i].textColor, 
+        drawRow(rowsBuffer[i].text.data(), rowsBuffer[i].row, rowsBuffer[i].textColor, 
                 rowsBuffer[i].bgColor, rowsBuffer[i].fontSize, rowsBuffer[i].underline);
+        if (rowsBuffer[i].underline) {
+            RowPosition pos = getRowPosition(rowsBuffer[i].row);
+            hit_index::add(pos.x, pos.y, pos.width, pos.height, hit_index::HIT_ROW, rowsBuffer[i].row);
+        }
     }
     rowsBufferCount = 0;
+    // Drawn outside renderCurrentScreen() (Freeze's full-screen text): nothing else ends this frame.
+    if (renderDepth == 0) {
+        arenas::frame().reset();
+    }
 }
 
 
-void bufferRow(const String& text, int row, uint16_t textColor, uint16_t bgColor, int fontSize, bool underline) {
+void bufferRow(TextSpan text, int row, uint16_t textColor, uint16_t bgColor, int fontSize, bool underline) {
 
     if (rowsBufferCount >= MAX_ROWS_BUFFER) {
 
@@ -77,7 +85,12 @@ void bufferRow(const String& text, int row, uint16_t textColor, uint16_t bgColor
         }
         rowsBufferCount = 0;
     }
-    rowsBuffer[rowsBufferCount] = {text, row, textColor, bgColor, fontSize, underline};
+    // ArenaString text is already a terminated frame-arena copy.
+    Arena& frame = arenas::frame();
+    const char* end = text.data() + text.length();
+    bool inFrame = frame.owns(text.data()) && frame.owns(end) && *end == '\0';
+    const char* stored = inFrame ? text.data() : frame.copy(text.data(), text.length());
+    rowsBuffer[rowsBufferCount] = {stored ? TextSpan(stored, text.length()) : TextSpan(), row, textColor, bgColor, fontSize, underline};
     rowsBufferCount++;
 }
 
@@ -90,14 +103,16 @@ void clearAllBuffers() {
         rowsBuffer[i] = {"", 0, TFT_BLACK, TFT_WHITE, (int)FONT_SIZE_ALL, false};
     }
     for (int i = 0; i < MAX_DISPLAYED_FILES; i++) {
-        displayedFiles[i] = "";
+        displayedFiles[i] = TextSpan();
     }
 }
 
 
 void updateHeader() {
-    bufferRow("Battery: " + String(getBatteryPercentage()) + "%", 0, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
-    if (currentMessage.text != "") {
+    ArenaString battery(arenas::frame());
+    battery.append("Battery: ").append(getBatteryPercentage()).append('%');
+    bufferRow(battery.c_str(), 0, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
+    if (!currentMessage.text.empty()) {
         bufferRow(currentMessage.text, 1, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
     } else {
         bufferRow("", 1, TFT_BLACK, TFT_WHITE, FONT_SIZE_ALL, false);
@@ -105,42 +120,6 @@ void updateHeader() {
 }
 
 
-static FooterButton mainFooterButtons[] = {
-    {"Home", homeAction},
-    {"Off", showOffScreen},
-    {"Rfrsh", refreshUI},
-    {"Files", filesAction}
-};
-
-static FooterButton filesFooterButtons[] = {
-    {"Home", homeAction},
-    {"Off", showOffScreen},
-    {"Rfrsh", refreshUI},
-    {"Files", filesAction}
-};
-
-static FooterButton viewerFooterButtons[] = {
-    {"Home", homeAction},
-    {"Off", showOffScreen},
-    {"Freeze", freezeAction},
-    {"Files", filesAction}
-};
-
-static FooterButton appFooterButtons[] = {
-    {"Home", homeAction},
-    {"Off", showOffScreen},
-    {"Rfrsh", refreshUI},
-    {"Files", filesAction}
-};
-
-static FooterButton sdgwFooterButtons[] = {
-    {"Home", homeAction},
-    {"Off", showOffScreen},
-    {"Rfrsh", refreshUI},
-    {"Files", filesAction}
-};
-
-
 void setupUI() {
 
     setUniversalFont();
@@ -148,14 +127,33 @@ void setupUI() {
 
     currentScreen = MAIN_SCREEN;
     
-
-    footer.setButtons(mainFooterButtons, 4);
-    
     renderCurrentScreen();
 }
 
 
+void resumeUI(ScreenType screen, bool render) {
+    setUniversalFont();
+    footer.setVisible(true);
+    currentScreen = screen;
+    applyScreenFooter(screen);
+    if (render) {
+        renderCurrentScreen();
+    }
+}
+
+
 void renderCurrentScreen() {
+    unsigned long renderStart = millis();
+    HEAP_TAG(HEAP_UI);
+    heap_telemetry::beginFrame();
+    renderDepth++;
+    if (currentScreen != arenaScreen) {
+        arenas::screen().reset();
+        arenaScreen = currentScreen;
+    }
+    power_telemetry::noteScreen(currentScreen);
+    latency_trace::mark(latency_trace::TRACE_DRAW_ISSUED, currentScreen);
+    hit_index::clear();
     M5.Display.startWrite();
 
 
@@ -163,9 +161,8 @@ void renderCurrentScreen() {
 
 
     rowsBufferCount = 0;
-    if (currentScreen != MINESWEEPER_GAME_SCREEN && 
-        currentScreen != SUDOKU_GAME_SCREEN && 
-        currentScreen != TEST_GAME_SCREEN) {
+    const ScreenDescriptor& screen = getScreenDescriptor(currentScreen);
+    if (screen.flags & SCREEN_HEADER) {
         updateHeader();
     }
 
@@ -174,89 +171,27 @@ void renderCurrentScreen() {
     RowPosition footerStart = getRowPosition(15);
     M5.Display.fillRect(contentStart.x, contentStart.y, contentStart.width, footerStart.y - contentStart.y, TFT_WHITE);
 
-    switch(currentScreen) {
-        case MAIN_SCREEN:
-            footer.setButtons(mainFooterButtons, 4);
-            screens::drawMainScreen();
-            break;
-        case FILES_SCREEN:
-            footer.setButtons(filesFooterButtons, 4);
-            screens::drawFilesScreen();
-            break;
-        case OFF_SCREEN:
-            screens::drawOffScreen();
-            break;
-        case TXT_VIEWER_SCREEN:
-        case IMG_VIEWER_SCREEN:
-            footer.setButtons(viewerFooterButtons, 4);
-            if (currentScreen == TXT_VIEWER_SCREEN) {
-                screens::drawTxtViewerScreen(currentPath);
-            } else {
-                screens::drawImgViewerScreen(currentPath);
-            }
-            break;
-        case CLEAR_SCREEN:
-            screens::drawClearScreen();
-            break;
-        case WIFI_SCREEN:
-            screens::drawWifiScreen();
-            break;
-        case APPS_SCREEN:
-            screens::drawAppsScreen();
-            break;
-        case GAMES_SCREEN:
-            drawGamesScreen();
-            break;
-        case TEXT_LANG_TEST_SCREEN:
-            footer.setButtons(appFooterButtons, 4);
-            apps_text_lang_test::drawAppScreen();
-            break;
-        case TEST2_APP_SCREEN:
-            footer.setButtons(appFooterButtons, 4);
-            apps_test2::drawAppScreen();
-            break;
-        case GEOMETRY_TEST_SCREEN:
-            footer.setButtons(appFooterButtons, 4);
-            apps_geometry_test::drawAppScreen();
-            break;
-        case SWIPE_TEST_SCREEN:
-            footer.setButtons(appFooterButtons, 4);
-            apps_swipe_test::drawAppScreen();
-            break;
-        case READER_APP_SCREEN:
-            footer.setButtons(appFooterButtons, 4);
-            apps_reader::drawAppScreen();
-            break;
-        case CALCULATOR_APP_SCREEN:
-            footer.setButtons(appFooterButtons, 4);
-            apps_calculator::drawAppScreen();
-            break;
-        case MINESWEEPER_GAME_SCREEN:
-            games_minesweeper::drawGameScreen();
-            break;
-        case SUDOKU_GAME_SCREEN:
-            games_sudoku::drawGameScreen();
-            break;
-        case TEST_GAME_SCREEN:
-            games_test::drawGameScreen();
-            break;
-        case SD_GATEWAY_SCREEN:
-            footer.setButtons(sdgwFooterButtons, 4);
-            screens::drawSdGatewayScreen();
-            break;
-    }
+    applyScreenFooter(currentScreen);
+    M5.Display.setEpdMode(nextScreenEpdMode(currentScreen));
+    screen.draw();
 
 
     drawRowsBuffered();
 
 
-    if (currentScreen != MINESWEEPER_GAME_SCREEN && 
-        currentScreen != SUDOKU_GAME_SCREEN && 
-        currentScreen != TEST_GAME_SCREEN) {
+    if (getScreenDescriptor(currentScreen).flags & SCREEN_FOOTER) {
         footer.draw(footer.isVisible());
     }
 
     M5.Display.endWrite();
+    latency_trace::mark(latency_trace::TRACE_FRAMEBUFFER, currentScreen);
+    if (--renderDepth == 0) {
+        arenas::frame().reset();
+    }
+    heap_telemetry::endFrame();
+
+    renderStats.renderCount++;
+    renderStats.lastRenderMs = millis() - renderStart;
 }
 
 
@@ -265,8 +200,14 @@ void updateUI() {
     clearMessage();
 
 
-    M5.Display.endWrite();
-    M5.Display.display();
+    unsigned long displayStart = millis();
+    {
+        POWER_SCOPE(POWER_EPD);
+        M5.Display.endWrite();
+        latency_trace::mark(latency_trace::TRACE_EPD_START, currentScreen);
+        M5.Display.display();
+    }
+    renderStats.lastDisplayMs = millis() - displayStart;
 
 
     extern bool isRendering;
@@ -274,7 +215,7 @@ void updateUI() {
 }
 
 
-void displayMessage(const String& msg) {
+void displayMessage(TextSpan msg) {
     currentMessage.text = msg;
     currentMessage.timestamp = millis();
     renderCurrentScreen();
@@ -288,6 +229,7 @@ void clearMessage() {
 
 
 void wordWrap(const String& text, int maxWidth, String* lines, int& lineCount, int maxLines) {
+    PROFILE_SCOPE("wordWrap");
     lineCount = 0;
     if (text.length() == 0) {
         return;
@@ -357,20 +299,69 @@ void wordWrap(const String& text, int maxWidth, String* lines, int& lineCount, i
 }
 
 
+int wordWrap(const char* text, int maxWidth, Arena& arena, const char** lines, int maxLines) {
+    PROFILE_SCOPE("wordWrap");
+    char* buffer = arena.copy(text);
+    if (!buffer) {
+        return 0;
+    }
+
+
+    ::setUniversalFont();
+
+    // Lines are slices of buffer: a break writes '\0' over the space or newline after the last word.
+    int lineCount = 0;
+    char* lineStart = nullptr;
+    char* lineEnd = nullptr;
+    char* p = buffer;
+    while (*p && lineCount < maxLines) {
+        if (*p == ' ') {
+            p++;
+            continue;
+        }
+        if (*p == '\n') {
+            if (lineStart) {
+                *lineEnd = '\0';
+                lines[lineCount++] = lineStart;
+                lineStart = nullptr;
+            }
+            p++;
+            continue;
+        }
+
+        char* wordStart = p;
+        while (*p && *p != ' ' && *p != '\n') p++;
+        if (!lineStart) {
+            lineStart = wordStart;
+            lineEnd = p;
+            continue;
+        }
+
+        char saved = *p;
+        *p = '\0';
+        bool fits = M5.Display.textWidth(lineStart) <= maxWidth;
+        *p = saved;
+        if (!fits) {
+            *lineEnd = '\0';
+            lines[lineCount++] = lineStart;
+            lineStart = wordStart;
+        }
+        lineEnd = p;
+    }
+
+    if (lineStart && lineCount < maxLines) {
+        *lineEnd = '\0';
+        lines[lineCount++] = lineStart;
+    }
+    return lineCount;
+}
+
+
 void navigateTo(const String& path) {
     currentPath = path;
     currentScreen = FILES_SCREEN;
     screens::resetPagination();
     
-
-    FooterButton filesFooterButtons[] = {
-        {"Home", homeAction},
-        {"Off", showOffScreen},
-        {"Rfrsh", refreshUI},
-        {"Files", filesAction}
-    };
-    footer.setButtons(filesFooterButtons, 4);
-    
     renderCurrentScreen();
 }
 
@@ -387,15 +378,6 @@ void navigateUp() {
     currentScreen = FILES_SCREEN;
     screens::resetPagination();
     
-
-    FooterButton filesFooterButtons[] = {
-        {"Home", homeAction},
-        {"Off", showOffScreen},
-        {"Rfrsh", refreshUI},
-        {"Files", filesAction}
-    };
-    footer.setButtons(filesFooterButtons, 4);
-    
     renderCurrentScreen();
 }
 
@@ -6,6 +6,8 @@
 #include "sdcard.h"
 #include "button.h"
 #include "footer.h"
+#include "arena.h"
+#include "text_types.h"
 #include <String>
 #include <WiFi.h> 
 
@@ -43,8 +45,13 @@ const lgfx::IFont* const UNIVERSAL_FONT = &fonts::efontCN_12;
 extern bool firstRenderDone;
 
 
+const int MESSAGE_CAPACITY = 64;
+// Listed names longer than this are cut on screen; the listing keeps the full name.
+const int FILE_LABEL_BYTES = 95;
+
+
 struct Message {
-    String text;
+    InlineString<MESSAGE_CAPACITY> text;
     unsigned long timestamp;
 };
 
@@ -57,8 +64,16 @@ struct RowPosition {
 };
 
 
+struct RenderStats {
+    unsigned long renderCount;
+    unsigned long lastRenderMs;
+    unsigned long lastDisplayMs;
+};
+
+
+// text is a NUL-terminated frame-arena copy, valid until the frame is drawn.
 struct BufferedRow {
-    String text;
+    TextSpan text;
     int row;
     uint16_t textColor;
     uint16_t bgColor;
@@ -86,7 +101,9 @@ enum ScreenType {
     MINESWEEPER_GAME_SCREEN,
     SUDOKU_GAME_SCREEN,
     TEST_GAME_SCREEN,
-    SD_GATEWAY_SCREEN
+    SD_GATEWAY_SCREEN,
+    HEAP_MONITOR_SCREEN,
+    SCREEN_COUNT
 };
 
 
@@ -97,26 +114,31 @@ const int MAX_ROWS_BUFFER = 25;
 extern Message currentMessage;
 extern ScreenType currentScreen;
 extern String currentPath;
-extern String displayedFiles[MAX_DISPLAYED_FILES];
+// Full NUL-terminated names, folders first with a trailing '/'; storage owned by the files screen.
+extern TextSpan displayedFiles[MAX_DISPLAYED_FILES];
 extern int displayedFilesCount;
 extern BufferedRow rowsBuffer[MAX_ROWS_BUFFER];
 extern int rowsBufferCount;
 extern Footer footer;
+extern RenderStats renderStats;
 
 
 RowPosition getRowPosition(int row);
 int getRowFromY(int y);
-void drawRow(const String& text, int row, uint16_t textColor, uint16_t bgColor, int fontSize, bool underline = false);
+void drawRow(const char* text, int row, uint16_t textColor, uint16_t bgColor, int fontSize, bool underline = false);
 void setupUI();
 void updateUI();
-void displayMessage(const String& msg);
+void resumeUI(ScreenType screen, bool render);
+void displayMessage(TextSpan msg);
 void clearMessage();
 
 
 void wordWrap(const String& text, int maxWidth, String* lines, int& lineCount, int maxLines);
+// Wraps a copy of text held in arena; lines point into that copy. Returns the line count.
+int wordWrap(const char* text, int maxWidth, Arena& arena, const char** lines, int maxLines);
 
 
-void bufferRow(const String& text, int row, uint16_t textColor = TFT_BLACK, uint16_t bgColor = TFT_WHITE, int fontSize = FONT_SIZE_ALL, bool underline = false);
+void bufferRow(TextSpan text, int row, uint16_t textColor = TFT_BLACK, uint16_t bgColor = TFT_WHITE, int fontSize = FONT_SIZE_ALL, bool underline = false);
 void drawRowsBuffered();
 void renderCurrentScreen();
 void clearAllBuffers();
@@ -0,0 +1,115 @@
+#ifndef FAKE_ARDUINO_H
+#define FAKE_ARDUINO_H
+
+// Host stand-in for the Arduino core: just what the modules under test use.
+// Every test suite is a single translation unit, so state lives in statics.
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+namespace fake {
+    static unsigned long millisNow = 0;
+    static uint64_t microsNow = 0;
+
+    inline void advanceMicros(uint64_t us) {
+        microsNow += us;
+        millisNow = (unsigned long)(microsNow / 1000);
+    }
+}
+
+inline unsigned long millis() { return fake::millisNow; }
+inline unsigned long micros() { return (unsigned long)fake::microsNow; }
+inline void delay(unsigned long ms) { fake::advanceMicros((uint64_t)ms * 1000); }
+
+class String {
+public:
+    String() {}
+    String(const char* text) : _text(text ? text : "") {}
+    String(const std::string& text) : _text(text) {}
+    String(char value) : _text(1, value) {}
+    String(int value) : _text(std::to_string(value)) {}
+    String(unsigned int value) : _text(std::to_string(value)) {}
+    String(long value) : _text(std::to_string(value)) {}
+    String(unsigned long value) : _text(std::to_string(value)) {}
+
+    const char* c_str() const { return _text.c_str(); }
+    unsigned int length() const { return (unsigned int)_text.size(); }
+    bool isEmpty() const { return _text.empty(); }
+    bool reserve(unsigned int size) { _text.reserve(size); return true; }
+    char operator[](unsigned int index) const { return index < _text.size() ? _text[index] : 0; }
+
+    String& operator+=(const String& other) { _text += other._text; return *this; }
+    String& operator+=(const char* other) { _text += other; return *this; }
+    String& operator+=(char other) { _text += other; return *this; }
+    friend String operator+(const String& a, const String& b) { return String(a._text + b._text); }
+
+    bool operator==(const String& other) const { return _text == other._text; }
+    bool operator==(const char* other) const { return _text == (other ? other : ""); }
+    bool operator!=(const String& other) const { return _text != other._text; }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return _text < other._text; }
+
+    bool startsWith(const String& prefix) const { return _text.compare(0, prefix._text.size(), prefix._text) == 0; }
+    bool endsWith(const String& suffix) const {
+        return _text.size() >= suffix._text.size() &&
+               _text.compare(_text.size() - suffix._text.size(), suffix._text.size(), suffix._text) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return _found(_text.find(c, from)); }
+    int indexOf(const String& text, unsigned int from = 0) const { return _found(_text.find(text._text, from)); }
+    int lastIndexOf(char c) const { return _found(_text.rfind(c)); }
+
+    String substring(unsigned int from) const { return from < _text.size() ? String(_text.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (to > _text.size()) to = (unsigned int)_text.size();
+        return from < to ? String(_text.substr(from, to - from)) : String();
+    }
+
+    void toLowerCase() {
+        for (size_t i = 0; i < _text.size(); ++i) _text[i] = (char)tolower((unsigned char)_text[i]);
+    }
+
+    void trim() {
+        size_t start = 0;
+        while (start < _text.size() && isspace((unsigned char)_text[start])) start++;
+        size_t end = _text.size();
+        while (end > start && isspace((unsigned char)_text[end - 1])) end--;
+        _text = _text.substr(start, end - start);
+    }
+
+    long toInt() const { return strtol(_text.c_str(), nullptr, 10); }
+
+private:
+    static int _found(size_t position) { return position == std::string::npos ? -1 : (int)position; }
+
+    std::string _text;
+};
+
+class Print {
+public:
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        int written = vprintf(format, args);
+        va_end(args);
+        return written < 0 ? 0 : (size_t)written;
+    }
+    size_t print(const char* text) { return (size_t)::printf("%s", text); }
+    size_t println(const char* text = "") { return (size_t)::printf("%s\n", text); }
+    size_t println(const String& text) { return println(text.c_str()); }
+};
+
+static Print Serial;
+
+#endif // FAKE_ARDUINO_H
@@ -0,0 +1,47 @@
+#ifndef FAKE_PREFERENCES_H
+#define FAKE_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+// NVS stand-in: one map of "namespace/key" blobs that tests can seed and inspect.
+namespace fake {
+    static std::map<std::string, std::vector<uint8_t> > nvs;
+}
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false) {
+        _name = name;
+        (void)readOnly;
+        return true;
+    }
+
+    void end() {}
+
+    size_t getBytesLength(const char* key) {
+        std::map<std::string, std::vector<uint8_t> >::const_iterator it = fake::nvs.find(_key(key));
+        return it == fake::nvs.end() ? 0 : it->second.size();
+    }
+
+    size_t getBytes(const char* key, void* buffer, size_t length) {
+        std::map<std::string, std::vector<uint8_t> >::const_iterator it = fake::nvs.find(_key(key));
+        if (it == fake::nvs.end() || it->second.size() > length) return 0;
+        memcpy(buffer, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+
+    size_t putBytes(const char* key, const void* data, size_t length) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        fake::nvs[_key(key)].assign(bytes, bytes + length);
+        return length;
+    }
+
+private:
+    std::string _key(const char* key) const { return _name + "/" + key; }
+
+    std::string _name;
+};
+
+#endif // FAKE_PREFERENCES_H
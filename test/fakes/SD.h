@@ -0,0 +1,154 @@
+#ifndef FAKE_SD_H
+#define FAKE_SD_H
+
+#include <Arduino.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <memory>
+
+// SD card backed by a host directory: SD.begin(root) mounts it and card paths
+// ("/books/a.txt") resolve under that root. Open files and directories are shared
+// between File copies, like the ESP32 FS handles.
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fake {
+    static std::string sdRoot;
+
+    inline std::string hostPath(const String& path) {
+        return sdRoot + (path.length() > 0 && path[0] == '/' ? "" : "/") + path.c_str();
+    }
+}
+
+class File {
+public:
+    File() {}
+
+    File(const String& path, const char* mode) {
+        std::string host = fake::hostPath(path);
+        struct stat info;
+        bool exists = stat(host.c_str(), &info) == 0;
+        std::shared_ptr<Handle> handle(new Handle());
+        handle->path = path.c_str();
+        if (exists && S_ISDIR(info.st_mode)) {
+            handle->dir = opendir(host.c_str());
+            if (!handle->dir) return;
+        } else {
+            if (!exists && mode[0] == 'r') return;
+            handle->file = fopen(host.c_str(), mode[0] == 'r' && mode[1] == '+' ? "r+b" :
+                                                mode[0] == 'w' ? "wb" : mode[0] == 'a' ? "ab" : "rb");
+            if (!handle->file) return;
+        }
+        _handle = handle;
+    }
+
+    explicit operator bool() const { return _handle && (_handle->file || _handle->dir); }
+
+    void close() { _handle.reset(); }
+
+    bool isDirectory() const { return _handle && _handle->dir; }
+    const char* path() const { return _handle ? _handle->path.c_str() : ""; }
+
+    // Like the ESP32 core: the last path component.
+    const char* name() const {
+        if (!_handle) return "";
+        size_t slash = _handle->path.rfind('/');
+        return _handle->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+    }
+
+    size_t size() const {
+        struct stat info;
+        if (!_handle || !_handle->file) return 0;
+        fflush(_handle->file);
+        return fstat(fileno(_handle->file), &info) == 0 ? (size_t)info.st_size : 0;
+    }
+
+    time_t getLastWrite() const {
+        struct stat info;
+        if (!_handle) return 0;
+        if (_handle->file) fflush(_handle->file);
+        return stat(fake::hostPath(_handle->path.c_str()).c_str(), &info) == 0 ? info.st_mtime : 0;
+    }
+
+    bool seek(uint32_t position) { return _handle && _handle->file && fseek(_handle->file, position, SEEK_SET) == 0; }
+    size_t position() const { return _handle && _handle->file ? (size_t)ftell(_handle->file) : 0; }
+    int available() const { return (int)(size() - position()); }
+
+    int read(uint8_t* buffer, size_t length) {
+        if (!_handle || !_handle->file) return -1;
+        return (int)fread(buffer, 1, length, _handle->file);
+    }
+
+    String readStringUntil(char terminator) {
+        String out;
+        if (!_handle || !_handle->file) return out;
+        int c;
+        while ((c = fgetc(_handle->file)) != EOF && c != terminator) out += (char)c;
+        return out;
+    }
+
+    size_t write(const uint8_t* data, size_t length) {
+        if (!_handle || !_handle->file) return 0;
+        return fwrite(data, 1, length, _handle->file);
+    }
+
+    size_t print(const String& text) { return write((const uint8_t*)text.c_str(), text.length()); }
+    size_t print(const char* text) { return print(String(text)); }
+    size_t print(char c) { return write((const uint8_t*)&c, 1); }
+    size_t print(unsigned long value) { return print(String(value)); }
+
+    File openNextFile() {
+        if (!_handle || !_handle->dir) return File();
+        while (struct dirent* entry = readdir(_handle->dir)) {
+            std::string name = entry->d_name;
+            if (name == "." || name == "..") continue;
+            std::string base = _handle->path == "/" ? "" : _handle->path;
+            return File(String(base + "/" + name), FILE_READ);
+        }
+        return File();
+    }
+
+private:
+    struct Handle {
+        std::string path;
+        FILE* file = nullptr;
+        DIR* dir = nullptr;
+
+        ~Handle() {
+            if (file) fclose(file);
+            if (dir) closedir(dir);
+        }
+    };
+
+    std::shared_ptr<Handle> _handle;
+};
+
+class SDFS {
+public:
+    bool begin(const char* hostRoot) {
+        fake::sdRoot = hostRoot;
+        return true;
+    }
+
+    File open(const String& path, const char* mode = FILE_READ) { return File(path, mode); }
+
+    bool exists(const String& path) {
+        struct stat info;
+        return stat(fake::hostPath(path).c_str(), &info) == 0;
+    }
+
+    bool remove(const String& path) { return unlink(fake::hostPath(path).c_str()) == 0; }
+    bool mkdir(const String& path) { return ::mkdir(fake::hostPath(path).c_str(), 0755) == 0; }
+    bool rmdir(const String& path) { return ::rmdir(fake::hostPath(path).c_str()) == 0; }
+
+    bool rename(const String& from, const String& to) {
+        return ::rename(fake::hostPath(from).c_str(), fake::hostPath(to).c_str()) == 0;
+    }
+};
+
+static SDFS SD __attribute__((unused));
+
+#endif // FAKE_SD_H
@@ -0,0 +1,278 @@
+#ifndef FAKE_WEBSERVER_H
+#define FAKE_WEBSERVER_H
+
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <functional>
+#include <map>
+#include <vector>
+
+// The ESP32 WebServer API over a host TCP socket: one request per connection,
+// served from handleClient(). Bodies of routes with a raw handler are fed to it
+// in HTTP_RAW_BUFLEN pieces like the core does; other bodies become arg("plain").
+// Responses of unknown length are ended by closing the connection.
+
+typedef enum { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS } HTTPMethod;
+typedef enum { RAW_START, RAW_WRITE, RAW_END, RAW_ABORTED } HTTPRawStatus;
+
+#define HTTP_RAW_BUFLEN 1436
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+struct HTTPRaw {
+    HTTPRawStatus status;
+    size_t totalSize;
+    size_t currentSize;
+    uint8_t buf[HTTP_RAW_BUFLEN];
+};
+
+class WebServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    explicit WebServer(int port = 80) : _port(port) {}
+
+    ~WebServer() {
+        if (_listener >= 0) ::close(_listener);
+    }
+
+    void on(const String& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction rawFn = nullptr) {
+        Route route = { uri, method, fn, rawFn };
+        _routes.push_back(route);
+    }
+
+    bool begin() {
+        _listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (_listener < 0) return false;
+        int yes = 1;
+        setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons((uint16_t)_port);
+        return bind(_listener, (sockaddr*)&address, sizeof(address)) == 0 && listen(_listener, 8) == 0;
+    }
+
+    // Blocks until one request has been served.
+    void handleClient() {
+        _client = accept(_listener, nullptr, nullptr);
+        if (_client < 0) return;
+        _serve();
+        ::close(_client);
+        _client = -1;
+    }
+
+    bool hasArg(const String& name) const { return _args.count(name.c_str()) > 0; }
+
+    String arg(const String& name) const {
+        std::map<std::string, std::string>::const_iterator it = _args.find(name.c_str());
+        return it == _args.end() ? String() : String(it->second);
+    }
+
+    HTTPRaw& raw() { return _raw; }
+
+    void sendHeader(const String& name, const String& value) {
+        _headers += std::string(name.c_str()) + ": " + value.c_str() + "\r\n";
+    }
+
+    void setContentLength(size_t length) { _contentLength = length; }
+
+    void send(int code, const char* contentType, const String& content) {
+        size_t length = _contentLength == CONTENT_LENGTH_UNKNOWN ? CONTENT_LENGTH_UNKNOWN : content.length();
+        _sendHead(code, contentType, length);
+        sendContent(content);
+    }
+
+    void sendContent(const String& content) { _write(content.c_str(), content.length()); }
+
+    template <typename T>
+    size_t streamFile(T& file, const String& contentType) {
+        _sendHead(200, contentType.c_str(), file.size());
+        uint8_t buffer[4096];
+        size_t sent = 0;
+        int n;
+        while ((n = file.read(buffer, sizeof(buffer))) > 0) {
+            _write((const char*)buffer, (size_t)n);
+            sent += (size_t)n;
+        }
+        return sent;
+    }
+
+private:
+    struct Route {
+        String uri;
+        HTTPMethod method;
+        THandlerFunction fn;
+        THandlerFunction rawFn;
+    };
+
+    static std::string _decode(const std::string& text) {
+        std::string out;
+        for (size_t i = 0; i < text.size(); ++i) {
+            if (text[i] == '+') {
+                out += ' ';
+            } else if (text[i] == '%' && i + 2 < text.size()) {
+                out += (char)strtol(text.substr(i + 1, 2).c_str(), nullptr, 16);
+                i += 2;
+            } else {
+                out += text[i];
+            }
+        }
+        return out;
+    }
+
+    static HTTPMethod _parseMethod(const std::string& name) {
+        static const char* names[] = { "", "GET", "HEAD", "POST", "PUT", "PATCH", "DELETE", "OPTIONS" };
+        for (int i = 1; i < 8; ++i) {
+            if (name == names[i]) return (HTTPMethod)i;
+        }
+        return HTTP_ANY;
+    }
+
+    static const char* _reason(int code) {
+        switch (code) {
+            case 200: return "OK";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 409: return "Conflict";
+            case 410: return "Gone";
+            case 422: return "Unprocessable Entity";
+            case 500: return "Internal Server Error";
+            default: return "Status";
+        }
+    }
+
+    bool _readMore(std::string& buffer) {
+        char chunk[4096];
+        ssize_t n = recv(_client, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, (size_t)n);
+        return true;
+    }
+
+    void _serve() {
+        std::string buffer;
+        size_t headEnd;
+        while ((headEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (!_readMore(buffer)) return;
+        }
+        std::string head = buffer.substr(0, headEnd);
+        std::string body = buffer.substr(headEnd + 4);
+
+        size_t lineEnd = head.find("\r\n");
+        std::string requestLine = head.substr(0, lineEnd);
+        size_t space1 = requestLine.find(' ');
+        size_t space2 = requestLine.find(' ', space1 + 1);
+        HTTPMethod method = _parseMethod(requestLine.substr(0, space1));
+        std::string target = requestLine.substr(space1 + 1, space2 - space1 - 1);
+
+        size_t contentLength = 0;
+        size_t position = lineEnd;
+        while (position != std::string::npos && position < head.size()) {
+            size_t next = head.find("\r\n", position + 2);
+            std::string line = head.substr(position + 2, next == std::string::npos ? std::string::npos : next - position - 2);
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                std::string name = line.substr(0, colon);
+                for (size_t i = 0; i < name.size(); ++i) name[i] = (char)tolower((unsigned char)name[i]);
+                if (name == "content-length") contentLength = (size_t)strtoul(line.c_str() + colon + 1, nullptr, 10);
+            }
+            position = next;
+        }
+
+        _args.clear();
+        size_t query = target.find('?');
+        std::string uri = target.substr(0, query);
+        if (query != std::string::npos) {
+            std::string pairs = target.substr(query + 1);
+            size_t start = 0;
+            while (start <= pairs.size()) {
+                size_t end = pairs.find('&', start);
+                if (end == std::string::npos) end = pairs.size();
+                std::string pair = pairs.substr(start, end - start);
+                size_t equals = pair.find('=');
+                if (!pair.empty()) {
+                    _args[_decode(pair.substr(0, equals))] = equals == std::string::npos ? "" : _decode(pair.substr(equals + 1));
+                }
+                start = end + 1;
+            }
+        }
+
+        _headers.clear();
+        _contentLength = 0;
+        const Route* route = nullptr;
+        for (size_t i = 0; i < _routes.size(); ++i) {
+            if (_routes[i].uri == uri.c_str() && (_routes[i].method == HTTP_ANY || _routes[i].method == method)) {
+                route = &_routes[i];
+                break;
+            }
+        }
+        if (!route) {
+            send(404, "text/plain", "Not found");
+            return;
+        }
+
+        if (route->rawFn) {
+            _raw.totalSize = 0;
+            _raw.status = RAW_START;
+            route->rawFn();
+            size_t received = 0;
+            while (received < contentLength) {
+                if (body.empty() && !_readMore(body)) {
+                    _raw.status = RAW_ABORTED;
+                    route->rawFn();
+                    return;
+                }
+                size_t n = min(min(body.size(), contentLength - received), (size_t)HTTP_RAW_BUFLEN);
+                memcpy(_raw.buf, body.data(), n);
+                body.erase(0, n);
+                _raw.currentSize = n;
+                _raw.totalSize += n;
+                _raw.status = RAW_WRITE;
+                route->rawFn();
+                received += n;
+            }
+            _raw.status = RAW_END;
+            route->rawFn();
+        } else {
+            while (body.size() < contentLength) {
+                if (!_readMore(body)) return;
+            }
+            if (contentLength > 0) _args["plain"] = body.substr(0, contentLength);
+        }
+        route->fn();
+    }
+
+    void _sendHead(int code, const char* contentType, size_t length) {
+        char status[64];
+        snprintf(status, sizeof(status), "HTTP/1.1 %d %s\r\n", code, _reason(code));
+        std::string head = status;
+        head += std::string("Content-Type: ") + contentType + "\r\n";
+        if (length != CONTENT_LENGTH_UNKNOWN) head += "Content-Length: " + std::to_string(length) + "\r\n";
+        head += _headers + "Connection: close\r\n\r\n";
+        _write(head.data(), head.size());
+    }
+
+    void _write(const char* data, size_t length) {
+        while (length > 0) {
+            ssize_t n = ::send(_client, data, length, MSG_NOSIGNAL);
+            if (n <= 0) return;
+            data += n;
+            length -= (size_t)n;
+        }
+    }
+
+    int _port;
+    int _listener = -1;
+    int _client = -1;
+    std::vector<Route> _routes;
+    std::map<std::string, std::string> _args;
+    std::string _headers;
+    size_t _contentLength = 0;
+    HTTPRaw _raw;
+};
+
+#endif // FAKE_WEBSERVER_H
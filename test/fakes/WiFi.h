@@ -0,0 +1,202 @@
+#ifndef FAKE_WIFI_H
+#define FAKE_WIFI_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+// Simulated ESP32 station driver. It records what the code under test asked for
+// and raises the same events the real driver would; tests script the access point
+// side through associate(), grantIp() and drop().
+
+class IPAddress {
+public:
+    IPAddress() : _address(0) {}
+    IPAddress(uint32_t address) : _address(address) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : _address((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24)) {}
+
+    operator uint32_t() const { return _address; }
+
+    String toString() const {
+        char text[16];
+        snprintf(text, sizeof(text), "%u.%u.%u.%u", (unsigned)(_address & 0xFF), (unsigned)((_address >> 8) & 0xFF),
+                 (unsigned)((_address >> 16) & 0xFF), (unsigned)(_address >> 24));
+        return String(text);
+    }
+
+private:
+    uint32_t _address;
+};
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL,
+    WL_SCAN_COMPLETED,
+    WL_CONNECTED,
+    WL_CONNECT_FAILED,
+    WL_CONNECTION_LOST,
+    WL_DISCONNECTED
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_READY = 0,
+    ARDUINO_EVENT_WIFI_SCAN_DONE,
+    ARDUINO_EVENT_WIFI_STA_START,
+    ARDUINO_EVENT_WIFI_STA_STOP,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_AUTHMODE_CHANGE,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP
+} arduino_event_id_t;
+
+struct wifi_event_sta_connected_t { uint8_t ssid[32]; uint8_t ssid_len; uint8_t bssid[6]; uint8_t channel; };
+struct wifi_event_sta_disconnected_t { uint8_t ssid[32]; uint8_t ssid_len; uint8_t bssid[6]; uint8_t reason; };
+struct esp_ip4_addr_t { uint32_t addr; };
+struct esp_netif_ip_info_t { esp_ip4_addr_t ip; esp_ip4_addr_t netmask; esp_ip4_addr_t gw; };
+struct ip_event_got_ip_t { esp_netif_ip_info_t ip_info; };
+
+typedef union {
+    wifi_event_sta_connected_t wifi_sta_connected;
+    wifi_event_sta_disconnected_t wifi_sta_disconnected;
+    ip_event_got_ip_t got_ip;
+} arduino_event_info_t;
+
+class WiFiClass {
+public:
+    typedef std::function<void(arduino_event_id_t, arduino_event_info_t)> EventHandler;
+
+    static const uint8_t REASON_ASSOC_LEAVE = 8;
+
+    // What the code under test asked for.
+    int beginCalls = 0;
+    int disconnectCalls = 0;
+    String lastSsid;
+    int32_t lastChannel = 0;
+    bool lastHadBssid = false;
+    uint32_t configuredIp = 0;      // 0: DHCP
+
+    void persistent(bool) {}
+    void setAutoReconnect(bool) {}
+    wifi_mode_t getMode() const { return _mode; }
+    bool mode(wifi_mode_t mode) { _mode = mode; return true; }
+
+    void onEvent(EventHandler handler, arduino_event_id_t event) {
+        _handlers.push_back(std::make_pair(event, handler));
+    }
+
+    bool config(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns = IPAddress()) {
+        (void)gateway;
+        (void)subnet;
+        (void)dns;
+        configuredIp = ip;
+        return true;
+    }
+
+    wl_status_t begin(const char* ssid, const char* password, int32_t channel = 0, const uint8_t* bssid = nullptr) {
+        (void)password;
+        beginCalls++;
+        lastSsid = ssid;
+        lastChannel = channel;
+        lastHadBssid = bssid != nullptr;
+        _active = true;
+        return WL_DISCONNECTED;
+    }
+
+    // Like esp_wifi_disconnect(): leaving an attempt or a link reports ASSOC_LEAVE.
+    bool disconnect(bool wifiOff = false) {
+        (void)wifiOff;
+        disconnectCalls++;
+        if (_active) {
+            _active = false;
+            _status = WL_DISCONNECTED;
+            _raiseDisconnected(REASON_ASSOC_LEAVE);
+        }
+        return true;
+    }
+
+    wl_status_t status() const { return _status; }
+    IPAddress localIP() const { return IPAddress(_ip); }
+    IPAddress gatewayIP() const { return IPAddress(_gateway); }
+    IPAddress subnetMask() const { return IPAddress(_subnet); }
+    IPAddress dnsIP(uint8_t = 0) const { return IPAddress(_gateway); }
+
+    int16_t scanNetworks(bool = false, bool = false, bool = false, uint32_t = 300, uint8_t = 0) { return WIFI_SCAN_FAILED; }
+    int16_t scanComplete() const { return WIFI_SCAN_FAILED; }
+    void scanDelete() {}
+    String SSID(uint8_t) const { return String(); }
+    uint8_t* BSSID(uint8_t) { return _noBssid; }
+    int32_t RSSI(uint8_t) const { return 0; }
+    int32_t channel(uint8_t) const { return 0; }
+
+    // Access point side.
+    void associate(const uint8_t* bssid, uint8_t channel) {
+        arduino_event_info_t info;
+        memset(&info, 0, sizeof(info));
+        memcpy(info.wifi_sta_connected.bssid, bssid, 6);
+        info.wifi_sta_connected.channel = channel;
+        _raise(ARDUINO_EVENT_WIFI_STA_CONNECTED, info);
+    }
+
+    // A static config keeps its address; otherwise `dhcpIp` is what the DHCP server hands out.
+    void grantIp(uint32_t dhcpIp, uint32_t gateway, uint32_t subnet) {
+        _ip = configuredIp != 0 ? configuredIp : dhcpIp;
+        _gateway = gateway;
+        _subnet = subnet;
+        _status = WL_CONNECTED;
+        arduino_event_info_t info;
+        memset(&info, 0, sizeof(info));
+        info.got_ip.ip_info.ip.addr = _ip;
+        info.got_ip.ip_info.gw.addr = _gateway;
+        info.got_ip.ip_info.netmask.addr = _subnet;
+        _raise(ARDUINO_EVENT_WIFI_STA_GOT_IP, info);
+    }
+
+    void drop(uint8_t reason) {
+        _active = false;
+        _status = WL_DISCONNECTED;
+        _raiseDisconnected(reason);
+    }
+
+    // Forgets the recorded calls; the link itself stays as it is.
+    void clearCalls() {
+        beginCalls = 0;
+        disconnectCalls = 0;
+        lastSsid = "";
+        lastChannel = 0;
+        lastHadBssid = false;
+    }
+
+private:
+    void _raiseDisconnected(uint8_t reason) {
+        arduino_event_info_t info;
+        memset(&info, 0, sizeof(info));
+        info.wifi_sta_disconnected.reason = reason;
+        _raise(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info);
+    }
+
+    void _raise(arduino_event_id_t event, const arduino_event_info_t& info) {
+        for (size_t i = 0; i < _handlers.size(); ++i) {
+            if (_handlers[i].first == event) _handlers[i].second(event, info);
+        }
+    }
+
+    wifi_mode_t _mode = WIFI_OFF;
+    bool _active = false;
+    wl_status_t _status = WL_DISCONNECTED;
+    uint32_t _ip = 0;
+    uint32_t _gateway = 0;
+    uint32_t _subnet = 0;
+    uint8_t _noBssid[6] = {};
+    std::vector<std::pair<arduino_event_id_t, EventHandler> > _handlers;
+};
+
+static WiFiClass WiFi;
+
+#endif // FAKE_WIFI_H
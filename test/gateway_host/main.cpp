@@ -0,0 +1,74 @@
+// Host build of the SD Gateway's file, upload and sync endpoints, serving a host
+// directory as the card. tools/tests/test_hi5sync.py builds it and runs hi5sync
+// against it:
+//
+//     c++ -std=gnu++11 -DPROFILE_DISABLED -Itest/fakes -I<ArduinoJson>/src
+//         test/gateway_host/main.cpp -o gateway_host
+//     ./gateway_host --root CARD_DIR --port 8080
+#include <Arduino.h>
+#include <SD.h>
+#include <WebServer.h>
+#include "../../src/gateway/gateway_util.cpp"
+#include "../../src/gateway/file_api.cpp"
+#include "../../src/gateway/chunked_upload.cpp"
+#include "../../src/gateway/sync_manifest.cpp"
+
+// The pools fall back to the host heap.
+namespace pools {
+    class HostJsonAllocator : public ArduinoJson::Allocator {
+    public:
+        void* allocate(size_t size) override { return malloc(size); }
+        void deallocate(void* ptr) override { free(ptr); }
+        void* reallocate(void* ptr, size_t size) override { return realloc(ptr, size); }
+    };
+
+    void* allocate(Pool, size_t size, size_t alignment) {
+        void* ptr = nullptr;
+        return posix_memalign(&ptr, max(alignment, sizeof(void*)), size) == 0 ? ptr : nullptr;
+    }
+
+    void release(void* ptr) {
+        free(ptr);
+    }
+
+    ArduinoJson::Allocator* jsonAllocator() {
+        static HostJsonAllocator allocator;
+        return &allocator;
+    }
+}
+
+// No WebSocket clients on the host; events are dropped.
+namespace gateway_events {
+    void notifyFileChanged(const String&, const char*) {}
+    void notifyUploadProgress(const String&, size_t, size_t) {}
+}
+
+int main(int argc, char** argv) {
+    const char* root = nullptr;
+    int port = 8080;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--root") == 0) root = argv[i + 1];
+        if (strcmp(argv[i], "--port") == 0) port = atoi(argv[i + 1]);
+    }
+    if (!root) {
+        fprintf(stderr, "usage: %s --root CARD_DIR [--port PORT]\n", argv[0]);
+        return 2;
+    }
+
+    SD.begin(root);
+    WebServer server(port);
+    if (!gateway_util::acquireIoBuffers() || !server.begin()) {
+        perror("gateway_host");
+        return 1;
+    }
+    gateway_file_api::registerRoutes(&server);
+    gateway_upload::registerRoutes(&server);
+    gateway_sync::registerRoutes(&server);
+    printf("[SD Gateway] serving %s on port %d\n", root, port);
+    fflush(stdout);
+
+    while (true) {
+        server.handleClient();
+        fflush(stdout);
+    }
+}
@@ -0,0 +1,246 @@
+// Replays recorded touch traces through the gesture recognizer. Traces are the
+// down/move/up samples touch_input queues, with times relative to the first touch;
+// the replay calls gestures::update() every loop period like main.cpp does.
+#include <unity.h>
+#include <Arduino.h>
+#include "../../src/services/gestures.cpp"
+
+// gestures.cpp only reads the gesture.* settings; serve them from the schema.
+Settings::Settings() : _loaded(false), _dirtyKeys(0), _lastChange(0), _jsonMtime(0), _jsonSize(0) {
+    resetToDefaults();
+}
+
+Settings& Settings::getInstance() {
+    static Settings instance;
+    return instance;
+}
+
+void Settings::resetToDefaults() {
+    for (int i = 0; i < SETTING_COUNT; ++i) {
+        _ints[i] = SETTINGS_SCHEMA[i].defaultInt;
+    }
+}
+
+int32_t Settings::getInt(SettingKey key) const {
+    return _ints[key];
+}
+
+bool Settings::setInt(SettingKey key, int32_t value) {
+    _ints[key] = value;
+    return true;
+}
+
+namespace touch_input {
+    void setListener(TouchListener) {}
+}
+
+using gestures::Gesture;
+
+struct TraceStep {
+    uint32_t ms;
+    touch_input::TouchEventType type;
+    uint8_t id;
+    int16_t x;
+    int16_t y;
+};
+
+static const touch_input::TouchEventType D = touch_input::TOUCH_DOWN;
+static const touch_input::TouchEventType M = touch_input::TOUCH_MOVE;
+static const touch_input::TouchEventType U = touch_input::TOUCH_UP;
+
+static const uint32_t LOOP_PERIOD_US = 10000;
+static const int MAX_RESULTS = gestures::QUEUE_CAPACITY;
+
+static Gesture results[MAX_RESULTS];
+static int resultCount = 0;
+static uint32_t traceStartUs = 0;
+
+static void runLoopUntil(uint64_t us) {
+    while (fake::microsNow + LOOP_PERIOD_US <= us) {
+        fake::advanceMicros(LOOP_PERIOD_US);
+        gestures::update();
+    }
+    fake::advanceMicros(us - fake::microsNow);
+}
+
+template <size_t N>
+static void replay(const TraceStep (&trace)[N], uint32_t tailMs = 500) {
+    uint64_t origin = fake::microsNow;
+    traceStartUs = (uint32_t)origin;
+    for (size_t i = 0; i < N; ++i) {
+        runLoopUntil(origin + (uint64_t)trace[i].ms * 1000);
+        touch_input::TouchEvent event;
+        event.timeUs = (uint32_t)fake::microsNow;
+        event.x = trace[i].x;
+        event.y = trace[i].y;
+        event.id = trace[i].id;
+        event.type = trace[i].type;
+        event.primary = trace[i].id == 0;
+        gestures::feed(event);
+        gestures::update();
+    }
+    runLoopUntil(fake::microsNow + (uint64_t)tailMs * 1000);
+
+    resultCount = 0;
+    while (resultCount < MAX_RESULTS && gestures::next(results[resultCount])) {
+        resultCount++;
+    }
+}
+
+void setUp(void) {
+    Gesture stale;
+    while (gestures::next(stale)) {}
+    Settings::getInstance().resetToDefaults();
+    // Well past any double-tap window left open by the previous trace.
+    fake::advanceMicros(2000000);
+}
+
+void tearDown(void) {}
+
+void test_tap(void) {
+    static const TraceStep trace[] = {
+        { 0, D, 0, 100, 200 }, { 40, M, 0, 103, 202 }, { 90, U, 0, 104, 203 }
+    };
+    replay(trace);
+    TEST_ASSERT_EQUAL(1, resultCount);
+    TEST_ASSERT_EQUAL(gestures::GESTURE_TAP, results[0].type);
+    TEST_ASSERT_EQUAL(100, results[0].x);
+    TEST_ASSERT_EQUAL(200, results[0].y);
+    TEST_ASSERT_EQUAL(90, results[0].durationMs);
+    TEST_ASSERT_EQUAL_UINT32(traceStartUs, results[0].startUs);
+}
+
+void test_double_tap(void) {
+    static const TraceStep trace[] = {
+        { 0, D, 0, 300, 300 }, { 70, U, 0, 301, 300 },
+        { 220, D, 0, 306, 296 }, { 290, U, 0, 306, 297 }
+    };
+    replay(trace);
+    TEST_ASSERT_EQUAL(3, resultCount);
+    TEST_ASSERT_EQUAL(gestures::GESTURE_TAP, results[0].type);
+    TEST_ASSERT_EQUAL(gestures::GESTURE_TAP, results[1].type);
+    TEST_ASSERT_EQUAL(gestures::GESTURE_DOUBLE_TAP, results[2].type);
+    TEST_ASSERT_EQUAL_UINT32(traceStartUs + 220000, results[2].startUs);
+}
+
+void test_taps_outside_double_tap_window(void) {
+    static const TraceStep trace[] = {
+        { 0, D, 0, 300, 300 }, { 70, U, 0, 300, 300 },
+        { 450, D, 0, 302, 301 }, { 520, U, 0, 302, 301 }
+    };
+    replay(trace);
+    TEST_ASSERT_EQUAL(2, resultCount);
+    TEST_ASSERT_EQUAL(gestures::GESTURE_TAP, results[0].type);
+    TEST_ASSERT_EQUAL(gestures::GESTURE_TAP, results[1].type);
+}
+
+void test_long_press(void) {
+    static const TraceStep trace[] = {
+        { 0, D, 0, 120, 640 }, { 300, M, 0, 124, 643 }, { 900, U, 0, 125, 643 }
+    };
+    replay(trace);
+    TEST_ASSERT_EQUAL(1, resultCount);
+    TEST_ASSERT_EQUAL(gestures::GESTURE_LONG_PRESS, results[0].type);
+    TEST_ASSERT_EQUAL(120, results[0].x);
+    TEST_ASSERT_EQUAL(640, results[0].y);
+    TEST_ASSERT_EQUAL(600, results[0].durationMs);
+}
+
+void test_long_press_follows_setting(void) {
+    static const TraceStep trace[] = {
+        { 0, D, 0, 120, 640 }, { 300, M, 0, 124, 643 }, { 900, U, 0, 125, 643 }
+    };
+    Settings::getInstance().setInt(SETTING_GESTURE_LONG_PRESS, 1000);
+    replay(trace);
+    TEST_ASSERT_EQUAL(0, resultCount);
+}
+
+void test_swipe_left(void) {
+    static const TraceStep trace[] = {
+        { 0, D, 0, 420, 480 }, { 40, M, 0, 380, 482 }, { 80, M, 0, 300, 486 },
+        { 120, M, 0, 220, 490 }, { 160, U, 0, 170, 492 }
+    };
+    replay(trace);
+    TEST_ASSERT_EQUAL(1, resultCount);
+    TEST_ASSERT_EQUAL(gestures::GESTURE_SWIPE, results[0].type);
+    TEST_ASSERT_EQUAL(gestures::SWIPE_LEFT, results[0].direction);
+    TEST_ASSERT_EQUAL(-250, results[0].dx);
+    TEST_ASSERT_EQUAL(12, results[0].dy);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 1563.5f, results[0].velocity);
+}
+
+void test_swipe_down(void) {
+    static const TraceStep trace[] = {
+        { 0, D, 0, 270, 200 }, { 60, M, 0, 272, 300 }, { 120, U, 0, 273, 420 }
+    };
+    replay(trace);
+    TEST_ASSERT_EQUAL(1, resultCount);
+    TEST_ASSERT_EQUAL(gestures::GESTURE_SWIPE, results[0].type);
+    TEST_ASSERT_EQUAL(gestures::SWIPE_DOWN, results[0].direction);
+}
+
+void test_slow_drag_is_pan(void) {
+    static const TraceStep trace[] = {
+        { 0, D, 0, 100, 100 }, { 400, M, 0, 160, 100 }, { 800, M, 0, 220, 100 }, { 900, U, 0, 230, 100 }
+    };
+    replay(trace);
+    TEST_ASSERT_EQUAL(1, resultCount);
+    TEST_ASSERT_EQUAL(gestures::GESTURE_PAN, results[0].type);
+    TEST_ASSERT_EQUAL(130, results[0].dx);
+}
+
+void test_pinch_out(void) {
+    static const TraceStep trace[] = {
+        { 0, D, 0, 200, 400 }, { 30, D, 1, 300, 400 },
+        { 100, M, 0, 160, 400 }, { 100, M, 1, 340, 400 },
+        { 200, M, 0, 100, 400 }, { 200, M, 1, 400, 400 },
+        { 260, U, 1, 400, 400 }, { 280, U, 0, 100, 400 }
+    };
+    replay(trace);
+    TEST_ASSERT_EQUAL(1, resultCount);
+    TEST_ASSERT_EQUAL(gestures::GESTURE_PINCH, results[0].type);
+    TEST_ASSERT_EQUAL(250, results[0].x);
+    TEST_ASSERT_EQUAL(400, results[0].y);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 3.0f, results[0].scale);
+}
+
+void test_pinch_in(void) {
+    static const TraceStep trace[] = {
+        { 0, D, 0, 100, 300 }, { 20, D, 1, 400, 300 },
+        { 120, M, 0, 180, 300 }, { 120, M, 1, 320, 300 },
+        { 240, M, 0, 220, 300 }, { 240, M, 1, 280, 300 },
+        { 300, U, 0, 220, 300 }, { 310, U, 1, 280, 300 }
+    };
+    replay(trace);
+    TEST_ASSERT_EQUAL(1, resultCount);
+    TEST_ASSERT_EQUAL(gestures::GESTURE_PINCH, results[0].type);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.2f, results[0].scale);
+}
+
+void test_small_pinch_is_ignored(void) {
+    static const TraceStep trace[] = {
+        { 0, D, 0, 200, 400 }, { 30, D, 1, 300, 400 },
+        { 150, M, 0, 190, 400 }, { 150, M, 1, 310, 400 },
+        { 260, U, 1, 310, 400 }, { 280, U, 0, 190, 400 }
+    };
+    replay(trace);
+    TEST_ASSERT_EQUAL(0, resultCount);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_tap);
+    RUN_TEST(test_double_tap);
+    RUN_TEST(test_taps_outside_double_tap_window);
+    RUN_TEST(test_long_press);
+    RUN_TEST(test_long_press_follows_setting);
+    RUN_TEST(test_swipe_left);
+    RUN_TEST(test_swipe_down);
+    RUN_TEST(test_slow_drag_is_pan);
+    RUN_TEST(test_pinch_out);
+    RUN_TEST(test_pinch_in);
+    RUN_TEST(test_small_pinch_is_ignored);
+    return UNITY_END();
+}
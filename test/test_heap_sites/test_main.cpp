@@ -0,0 +1,84 @@
+// Records allocation call sites through the replaced operator new of the host build.
+#include <unity.h>
+#include <Arduino.h>
+#include <vector>
+#include "../../src/services/heap_sites.cpp"
+
+static int* volatile kept = nullptr;
+
+__attribute__((noinline)) static void allocateInt() {
+    kept = new int(1);
+    delete kept;
+}
+
+__attribute__((noinline)) static void allocateArray() {
+    kept = new int[16];
+    delete[] kept;
+}
+
+// The site closest after the function's entry point, i.e. the call inside it.
+static const heap_sites::Site* findSiteIn(const heap_sites::Site* sites, int count, void (*function)()) {
+    const heap_sites::Site* found = nullptr;
+    uintptr_t best = 256;
+    for (int i = 0; i < count; ++i) {
+        uintptr_t offset = (uintptr_t)sites[i].address - (uintptr_t)function;
+        if (offset < best) {
+            best = offset;
+            found = &sites[i];
+        }
+    }
+    return found;
+}
+
+void setUp(void) {
+    heap_sites::reset();
+}
+
+void tearDown(void) {}
+
+void test_allocations_are_counted_per_call_site(void) {
+    for (int i = 0; i < 3; ++i) allocateInt();
+    for (int i = 0; i < 5; ++i) allocateArray();
+
+    heap_sites::Site sites[heap_sites::MAX_SITES];
+    int count = heap_sites::snapshot(sites, heap_sites::MAX_SITES);
+    const heap_sites::Site* single = findSiteIn(sites, count, allocateInt);
+    const heap_sites::Site* array = findSiteIn(sites, count, allocateArray);
+    TEST_ASSERT_TRUE(single != nullptr);
+    TEST_ASSERT_TRUE(array != nullptr);
+    TEST_ASSERT_EQUAL_UINT32(3, single->allocs);
+    TEST_ASSERT_EQUAL(3 * sizeof(int), single->bytes);
+    TEST_ASSERT_EQUAL_UINT32(5, array->allocs);
+    TEST_ASSERT_EQUAL(5 * 16 * sizeof(int), array->bytes);
+}
+
+void test_snapshot_is_busiest_first_and_capped(void) {
+    allocateInt();
+    for (int i = 0; i < 4; ++i) allocateArray();
+    std::vector<char> buffer(64);
+
+    heap_sites::Site sites[2];
+    TEST_ASSERT_EQUAL(2, heap_sites::snapshot(sites, 2));
+    TEST_ASSERT_EQUAL_UINT32(4, sites[0].allocs);
+    TEST_ASSERT_TRUE(findSiteIn(sites, 1, allocateArray) != nullptr);
+    TEST_ASSERT_EQUAL_UINT32(1, sites[1].allocs);
+    heap_sites::printReport(Serial, 2);
+}
+
+void test_reset_forgets_sites(void) {
+    allocateInt();
+    heap_sites::reset();
+    heap_sites::Site sites[4];
+    TEST_ASSERT_EQUAL(0, heap_sites::snapshot(sites, 4));
+    TEST_ASSERT_EQUAL_UINT32(0, heap_sites::dropped());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_allocations_are_counted_per_call_site);
+    RUN_TEST(test_snapshot_is_busiest_first_and_capped);
+    RUN_TEST(test_reset_forgets_sites);
+    return UNITY_END();
+}
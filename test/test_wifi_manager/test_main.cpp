@@ -0,0 +1,205 @@
+// Drives WiFiManager against the simulated driver in test/fakes/WiFi.h.
+#include <unity.h>
+#include <time.h>
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include "../../src/network/credential_store.h"
+#include "../../src/services/heap_telemetry.h"
+
+static time_t fakeNow = 1700000000;
+
+static time_t fakeTime(time_t* out) {
+    if (out) *out = fakeNow;
+    return fakeNow;
+}
+
+#define time(out) fakeTime(out)
+#include "../../src/network/scan_cache.cpp"
+#include "../../src/network/wifi_manager.cpp"
+#undef time
+
+// WiFiManager only reports to the credential store here; count what it reports.
+static int recordedConnects = 0;
+static int recordedFailures = 0;
+
+bool CredentialStore::begin() { return true; }
+const WiFiProfile* CredentialStore::find(TextSpan) const { return nullptr; }
+bool CredentialStore::upsert(const String&, const String&) { return true; }
+uint16_t CredentialStore::knownChannels() const { return 0; }
+bool CredentialStore::allChannelsKnown() const { return false; }
+const WiFiProfile* CredentialStore::selectBest(const ScanNetwork*, int, const ScanNetwork**) const { return nullptr; }
+void CredentialStore::recordConnect(const String&, const uint8_t*, uint8_t, uint32_t) { recordedConnects++; }
+void CredentialStore::recordFailure(const String&) { recordedFailures++; }
+
+namespace heap_telemetry {
+    HeapTag setTag(HeapTag tag) { return tag; }
+}
+
+// Same layout as WiFiManager::FastReconnectCache, which the manager keeps in NVS.
+struct CacheRecord {
+    char ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+    uint32_t leaseEpoch;
+};
+
+static const char* CACHE_KEY = "hi5wifi/fast";
+static const uint8_t HOME_BSSID[6] = { 0x24, 0x4B, 0xFE, 0x10, 0x20, 0x30 };
+static const uint32_t GATEWAY = IPAddress(192, 168, 1, 1);
+static const uint32_t SUBNET = IPAddress(255, 255, 255, 0);
+static const uint32_t CACHED_IP = IPAddress(192, 168, 1, 42);
+static const uint32_t DHCP_IP = IPAddress(192, 168, 1, 77);
+
+static WiFiManager& manager() {
+    return WiFiManager::getInstance();
+}
+
+static CacheRecord storedCache() {
+    CacheRecord record;
+    memset(&record, 0, sizeof(record));
+    const std::vector<uint8_t>& blob = fake::nvs[CACHE_KEY];
+    TEST_ASSERT_EQUAL(sizeof(record), blob.size());
+    memcpy(&record, blob.data(), sizeof(record));
+    return record;
+}
+
+static void joinHome(uint32_t dhcpIp) {
+    WiFi.associate(HOME_BSSID, 6);
+    WiFi.grantIp(dhcpIp, GATEWAY, SUBNET);
+    manager().loop();
+}
+
+void setUp(void) {
+    WiFi.clearCalls();
+}
+
+void tearDown(void) {}
+
+void test_cached_lease_is_reused_without_restamping(void) {
+    CacheRecord seeded;
+    memset(&seeded, 0, sizeof(seeded));
+    strcpy(seeded.ssid, "HomeNet");
+    memcpy(seeded.bssid, HOME_BSSID, sizeof(seeded.bssid));
+    seeded.channel = 6;
+    seeded.ip = CACHED_IP;
+    seeded.gateway = GATEWAY;
+    seeded.subnet = SUBNET;
+    seeded.dns = GATEWAY;
+    seeded.leaseEpoch = (uint32_t)fakeNow - 600;
+    const uint8_t* bytes = (const uint8_t*)&seeded;
+    fake::nvs[CACHE_KEY].assign(bytes, bytes + sizeof(seeded));
+
+    TEST_ASSERT_TRUE(manager().connect("HomeNet", "secret"));
+    TEST_ASSERT_EQUAL_UINT32(CACHED_IP, WiFi.configuredIp);
+    TEST_ASSERT_EQUAL(6, WiFi.lastChannel);
+    TEST_ASSERT_TRUE(WiFi.lastHadBssid);
+
+    joinHome(DHCP_IP);
+    TEST_ASSERT_TRUE(manager().isConnected());
+    CacheRecord stored = storedCache();
+    TEST_ASSERT_EQUAL_UINT32(CACHED_IP, stored.ip);
+    TEST_ASSERT_EQUAL_UINT32(seeded.leaseEpoch, stored.leaseEpoch);
+    manager().disconnect();
+}
+
+void test_reused_lease_expires_and_falls_back_to_dhcp(void) {
+    // One hour after the last real DHCP exchange, however many reconnects reused it.
+    fakeNow += 3000;
+    TEST_ASSERT_TRUE(manager().connect("HomeNet", "secret"));
+    TEST_ASSERT_EQUAL_UINT32(0, WiFi.configuredIp);
+    TEST_ASSERT_EQUAL(6, WiFi.lastChannel);
+
+    joinHome(DHCP_IP);
+    TEST_ASSERT_TRUE(manager().isConnected());
+    CacheRecord stored = storedCache();
+    TEST_ASSERT_EQUAL_UINT32(DHCP_IP, stored.ip);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)fakeNow, stored.leaseEpoch);
+    manager().disconnect();
+}
+
+void test_fresh_dhcp_lease_is_reused(void) {
+    fakeNow += 60;
+    TEST_ASSERT_TRUE(manager().connect("HomeNet", "secret"));
+    TEST_ASSERT_EQUAL_UINT32(DHCP_IP, WiFi.configuredIp);
+    joinHome(0);
+    TEST_ASSERT_TRUE(manager().isConnected());
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)fakeNow - 60, storedCache().leaseEpoch);
+    manager().disconnect();
+}
+
+void test_switching_network_while_connecting_ignores_own_leave(void) {
+    int failures = recordedFailures;
+    TEST_ASSERT_TRUE(manager().connect("Office", "hunter2"));
+    manager().loop();
+    TEST_ASSERT_TRUE(manager().connect("HomeNet", "secret"));
+    TEST_ASSERT_EQUAL(1, WiFi.disconnectCalls);
+
+    manager().loop();
+    TEST_ASSERT_TRUE(manager().getState() == WiFiManager::ConnectionState::CONNECTING);
+    TEST_ASSERT_EQUAL(2, WiFi.beginCalls);
+    TEST_ASSERT_EQUAL(failures, recordedFailures);
+
+    joinHome(0);
+    TEST_ASSERT_TRUE(manager().isConnected());
+    TEST_ASSERT_TRUE(manager().getTargetSSID() == "HomeNet");
+}
+
+void test_switching_network_while_connected_ignores_own_leave(void) {
+    TEST_ASSERT_TRUE(manager().isConnected());
+    int failures = recordedFailures;
+    TEST_ASSERT_TRUE(manager().connect("Office", "hunter2"));
+    manager().loop();
+    TEST_ASSERT_TRUE(manager().getState() == WiFiManager::ConnectionState::CONNECTING);
+    TEST_ASSERT_EQUAL(1, WiFi.beginCalls);
+    TEST_ASSERT_TRUE(WiFi.lastSsid == "Office");
+    TEST_ASSERT_EQUAL(failures, recordedFailures);
+}
+
+void test_driver_failure_backs_off_and_retries(void) {
+    WiFi.drop(REASON_NO_AP_FOUND);
+    manager().loop();
+    TEST_ASSERT_TRUE(manager().getState() == WiFiManager::ConnectionState::WAITING_RETRY);
+    TEST_ASSERT_EQUAL(1000, manager().getRetryInMs());
+
+    delay(999);
+    manager().loop();
+    TEST_ASSERT_TRUE(manager().getState() == WiFiManager::ConnectionState::WAITING_RETRY);
+    delay(1);
+    manager().loop();
+    TEST_ASSERT_TRUE(manager().getState() == WiFiManager::ConnectionState::CONNECTING);
+    TEST_ASSERT_EQUAL(1, WiFi.beginCalls);
+    manager().disconnect();
+}
+
+void test_rejected_password_is_reported_as_credentials_failure(void) {
+    TEST_ASSERT_TRUE(manager().connect("Office", "old-password"));
+    manager().loop();
+    TEST_ASSERT_FALSE(manager().failedOnCredentials());
+    WiFi.drop(REASON_AUTH_FAIL);
+    manager().loop();
+    TEST_ASSERT_TRUE(manager().getState() == WiFiManager::ConnectionState::FAILED);
+    TEST_ASSERT_TRUE(manager().failedOnCredentials());
+
+    TEST_ASSERT_TRUE(manager().connect("Office", "new-password"));
+    TEST_ASSERT_FALSE(manager().failedOnCredentials());
+    manager().disconnect();
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_cached_lease_is_reused_without_restamping);
+    RUN_TEST(test_reused_lease_expires_and_falls_back_to_dhcp);
+    RUN_TEST(test_fresh_dhcp_lease_is_reused);
+    RUN_TEST(test_switching_network_while_connecting_ignores_own_leave);
+    RUN_TEST(test_switching_network_while_connected_ignores_own_leave);
+    RUN_TEST(test_driver_failure_backs_off_and_retries);
+    RUN_TEST(test_rejected_password_is_reported_as_credentials_failure);
+    return UNITY_END();
+}
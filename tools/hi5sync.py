@@ -0,0 +1,271 @@
+#!/usr/bin/env python3
+"""Two-way folder sync between a host directory and the Hi5Stack SD Gateway.
+
+Usage:
+    hi5sync.py HOST LOCAL_DIR REMOTE_DIR [--port 8080] [--dry-run]
+
+Example:
+    hi5sync.py 192.168.1.42 ~/ebooks /books
+
+The last agreed state of every file is kept in LOCAL_DIR/.hi5sync-state.json.
+Each run compares the host tree, the device manifest and that state (a
+three-way merge):
+
+- changed on one side only: copied to the other side
+- deleted on one side and unchanged on the other: deleted on the other side
+- deleted on one side and changed on the other: the changed file wins
+- changed on both sides: the newer mtime wins (ties go to the larger hash);
+  the losing version is kept next to it as NAME.conflict-<host|device>-<hash8>.EXT
+
+Only the Python standard library is used.
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import sys
+import time
+import urllib.error
+import urllib.parse
+import urllib.request
+
+STATE_FILE = ".hi5sync-state.json"
+STATE_VERSION = 1
+DEFAULT_CHUNK_SIZE = 64 * 1024
+HTTP_TIMEOUT = 120
+
+
+class Gateway:
+    def __init__(self, host, port):
+        self.base = "http://%s:%d" % (host, port)
+
+    def _request(self, method, path, params=None, body=None, content_type=None):
+        url = self.base + path
+        if params:
+            url += "?" + urllib.parse.urlencode(params)
+        request = urllib.request.Request(url, data=body, method=method)
+        if content_type:
+            request.add_header("Content-Type", content_type)
+        try:
+            with urllib.request.urlopen(request, timeout=HTTP_TIMEOUT) as response:
+                return response.read()
+        except urllib.error.HTTPError as error:
+            detail = error.read().decode("utf-8", "replace")
+            raise RuntimeError("%s %s -> %d %s" % (method, path, error.code, detail))
+
+    def _json(self, method, path, params=None, payload=None):
+        body = None
+        if payload is not None:
+            body = json.dumps(payload).encode("utf-8")
+        data = self._request(method, path, params, body, "application/json" if body else None)
+        return json.loads(data.decode("utf-8"))
+
+    def manifest(self, root):
+        reply = self._json("GET", "/api/sync/manifest", {"path": root})
+        return {entry["path"]: entry for entry in reply["entries"]}
+
+    def download(self, path):
+        return self._request("GET", "/api/file", {"path": path})
+
+    def upload(self, path, data, sha256):
+        session = self._json("POST", "/api/upload/session", payload={"path": path, "size": len(data)})
+        chunk_size = session.get("chunkSize") or DEFAULT_CHUNK_SIZE
+        for start, end in missing_ranges(session.get("received", []), len(data)):
+            for offset in range(start, end, chunk_size):
+                piece = data[offset:min(offset + chunk_size, end)]
+                self._request("PUT", "/api/upload/chunk", {"id": session["id"], "offset": offset},
+                              piece, "application/octet-stream")
+        self._json("POST", "/api/upload/finalize", {"id": session["id"], "sha256": sha256})
+
+    def delete(self, paths):
+        if not paths:
+            return
+        ops = [{"op": "delete", "path": path} for path in paths]
+        reply = self._json("POST", "/api/ops", payload={"ops": ops})
+        if reply.get("failed"):
+            raise RuntimeError("device delete failed: %s" % reply["results"])
+
+
+def missing_ranges(received, size):
+    gaps = []
+    position = 0
+    for start, end in sorted(received):
+        if start > position:
+            gaps.append((position, start))
+        position = max(position, end)
+    if position < size:
+        gaps.append((position, size))
+    return gaps
+
+
+def sha256_file(path):
+    digest = hashlib.sha256()
+    with open(path, "rb") as handle:
+        for block in iter(lambda: handle.read(1 << 16), b""):
+            digest.update(block)
+    return digest.hexdigest()
+
+
+def scan_local(root, previous):
+    files = {}
+    for directory, dirs, names in os.walk(root):
+        dirs[:] = sorted(d for d in dirs if not d.startswith("."))
+        for name in sorted(names):
+            if name.startswith(".") or name.endswith(".part"):
+                continue
+            full = os.path.join(directory, name)
+            rel = os.path.relpath(full, root).replace(os.sep, "/")
+            stat = os.stat(full)
+            size, mtime = stat.st_size, int(stat.st_mtime)
+            known = previous.get(rel, {})
+            if known.get("localSize") == size and known.get("localMtime") == mtime:
+                sha256 = known["sha256"]
+            else:
+                sha256 = sha256_file(full)
+            files[rel] = {"path": rel, "size": size, "mtime": mtime, "sha256": sha256}
+    return files
+
+
+def load_state(local_root, remote_root):
+    path = os.path.join(local_root, STATE_FILE)
+    try:
+        with open(path, "r", encoding="utf-8") as handle:
+            state = json.load(handle)
+    except (OSError, ValueError):
+        return {}
+    if state.get("v") != STATE_VERSION or state.get("remote") != remote_root:
+        return {}
+    return state.get("files", {})
+
+
+def save_state(local_root, remote_root, files):
+    path = os.path.join(local_root, STATE_FILE)
+    tmp = path + ".tmp"
+    with open(tmp, "w", encoding="utf-8") as handle:
+        json.dump({"v": STATE_VERSION, "remote": remote_root, "files": files}, handle, indent=1, sort_keys=True)
+    os.replace(tmp, path)
+
+
+def conflict_name(rel, side, sha256):
+    stem, ext = os.path.splitext(rel)
+    return "%s.conflict-%s-%s%s" % (stem, side, sha256[:8], ext)
+
+
+def plan(local, remote, base):
+    """Return a sorted list of (action, path, detail) tuples.
+
+    Actions: upload, download, delete_local, delete_remote, keep.
+    """
+    actions = []
+    for rel in sorted(set(local) | set(remote) | set(base)):
+        l = local.get(rel, {}).get("sha256")
+        r = remote.get(rel, {}).get("sha256")
+        b = base.get(rel, {}).get("sha256")
+        if l == r:
+            if l is not None:
+                actions.append(("keep", rel, None))
+        elif l == b:
+            actions.append(("delete_local", rel, None) if r is None else ("download", rel, None))
+        elif r == b:
+            actions.append(("delete_remote", rel, None) if l is None else ("upload", rel, None))
+        elif l is None:
+            actions.append(("download", rel, None))
+        elif r is None:
+            actions.append(("upload", rel, None))
+        else:
+            local_key = (local[rel]["mtime"], l)
+            remote_key = (remote[rel]["mtime"], r)
+            if local_key > remote_key:
+                actions.append(("upload", rel, conflict_name(rel, "device", r)))
+            else:
+                actions.append(("download", rel, conflict_name(rel, "host", l)))
+    return actions
+
+
+def remote_path(remote_root, rel):
+    return remote_root.rstrip("/") + "/" + rel
+
+
+def write_local(path, data, mtime=None):
+    os.makedirs(os.path.dirname(path) or ".", exist_ok=True)
+    tmp = path + ".part"
+    with open(tmp, "wb") as handle:
+        handle.write(data)
+    os.replace(tmp, path)
+    if mtime:
+        os.utime(path, (mtime, mtime))
+
+
+def sync(gateway, local_root, remote_root, dry_run=False, log=print):
+    remote_root = "/" + remote_root.strip("/")
+    base = load_state(local_root, remote_root)
+    local = scan_local(local_root, base)
+    remote = gateway.manifest(remote_root)
+    actions = plan(local, remote, base)
+
+    agreed = {}
+    remote_deletes = []
+    counts = {}
+    for action, rel, conflict in actions:
+        counts[action] = counts.get(action, 0) + 1
+        if action != "keep":
+            log("%-13s %s%s" % (action, rel, " (conflict copy: %s)" % conflict if conflict else ""))
+        if dry_run:
+            continue
+        full = os.path.join(local_root, *rel.split("/"))
+        entry = None
+        if action == "keep":
+            entry = local[rel]
+        elif action == "upload":
+            if conflict:
+                write_local(os.path.join(local_root, *conflict.split("/")), gateway.download(remote_path(remote_root, rel)))
+            with open(full, "rb") as handle:
+                gateway.upload(remote_path(remote_root, rel), handle.read(), local[rel]["sha256"])
+            entry = local[rel]
+        elif action == "download":
+            if conflict:
+                os.replace(full, os.path.join(local_root, *conflict.split("/")))
+            data = gateway.download(remote_path(remote_root, rel))
+            if hashlib.sha256(data).hexdigest() != remote[rel]["sha256"]:
+                raise RuntimeError("hash mismatch downloading %s" % rel)
+            write_local(full, data)
+            entry = dict(remote[rel])
+        elif action == "delete_local":
+            os.remove(full)
+        elif action == "delete_remote":
+            remote_deletes.append(remote_path(remote_root, rel))
+        if entry is not None:
+            stat = os.stat(full)
+            agreed[rel] = {"sha256": entry["sha256"], "localSize": stat.st_size, "localMtime": int(stat.st_mtime)}
+
+    if not dry_run:
+        gateway.delete(remote_deletes)
+        save_state(local_root, remote_root, agreed)
+    return counts
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Two-way folder sync with the Hi5Stack SD Gateway")
+    parser.add_argument("host")
+    parser.add_argument("local_dir")
+    parser.add_argument("remote_dir")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--dry-run", action="store_true")
+    args = parser.parse_args(argv)
+
+    if not os.path.isdir(args.local_dir):
+        parser.error("%s is not a directory" % args.local_dir)
+    started = time.time()
+    counts = sync(Gateway(args.host, args.port), args.local_dir, args.remote_dir, args.dry_run)
+    summary = ", ".join("%s %d" % item for item in sorted(counts.items())) or "nothing to do"
+    print("%s in %.1fs" % (summary, time.time() - started))
+    return 0
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except (RuntimeError, urllib.error.URLError, OSError) as error:
+        print("hi5sync: %s" % error, file=sys.stderr)
+        sys.exit(1)
@@ -0,0 +1,91 @@
+"""Runs the host build of the SD Gateway (test/gateway_host/main.cpp) on a host directory.
+
+The build is the firmware's own file, upload and sync handlers compiled against
+the simulated drivers in test/fakes. It needs a C++ compiler ($CXX, default c++)
+and ArduinoJson 7: $ARDUINOJSON_DIR, or the copy PlatformIO installs for the
+native environment (pio pkg install -e native). Without them the tests are skipped.
+"""
+
+import atexit
+import os
+import shutil
+import socket
+import subprocess
+import tempfile
+import time
+import unittest
+
+REPO = os.path.abspath(os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", ".."))
+SOURCE = os.path.join(REPO, "test", "gateway_host", "main.cpp")
+
+_build_dir = None
+_binary = None
+
+
+def _arduinojson_dir():
+    candidates = [os.environ.get("ARDUINOJSON_DIR", ""),
+                  os.path.join(REPO, ".pio", "libdeps", "native", "ArduinoJson", "src")]
+    for candidate in candidates:
+        if candidate and os.path.isfile(os.path.join(candidate, "ArduinoJson.h")):
+            return candidate
+    return None
+
+
+def build():
+    """Compile the host gateway once per run and return the binary path."""
+    global _build_dir, _binary
+    if _binary:
+        return _binary
+    compiler = shutil.which(os.environ.get("CXX", "c++"))
+    json_dir = _arduinojson_dir()
+    if not compiler or not json_dir:
+        raise unittest.SkipTest("host gateway needs a C++ compiler and ArduinoJson "
+                                "(set ARDUINOJSON_DIR or run pio pkg install -e native)")
+    _build_dir = tempfile.mkdtemp(prefix="hi5-gateway-host-")
+    atexit.register(shutil.rmtree, _build_dir, True)
+    binary = os.path.join(_build_dir, "gateway_host")
+    command = [compiler, "-std=gnu++11", "-DPROFILE_DISABLED",
+               "-I" + os.path.join(REPO, "test", "fakes"), "-I" + json_dir, SOURCE, "-o", binary]
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    if result.returncode != 0:
+        raise RuntimeError("host gateway build failed:\n" + result.stdout.decode("utf-8", "replace"))
+    _binary = binary
+    return _binary
+
+
+def _free_port():
+    with socket.socket() as probe:
+        probe.bind(("127.0.0.1", 0))
+        return probe.getsockname()[1]
+
+
+class HostGateway:
+    """Context manager: serves `card` (the SD root) on a free localhost port."""
+
+    def __init__(self, card):
+        self.card = card
+        self.port = _free_port()
+        self.process = None
+        self.log = None
+
+    def __enter__(self):
+        self.log = tempfile.TemporaryFile()
+        self.process = subprocess.Popen([build(), "--root", self.card, "--port", str(self.port)],
+                                        stdout=self.log, stderr=subprocess.STDOUT)
+        deadline = time.time() + 10
+        while True:
+            try:
+                socket.create_connection(("127.0.0.1", self.port), timeout=1).close()
+                return self
+            except OSError:
+                if self.process.poll() is not None or time.time() > deadline:
+                    self.__exit__(None, None, None)
+                    raise RuntimeError("host gateway did not start")
+                time.sleep(0.05)
+
+    def __exit__(self, *exc):
+        if self.process and self.process.poll() is None:
+            self.process.terminate()
+            self.process.wait()
+        if self.log:
+            self.log.close()
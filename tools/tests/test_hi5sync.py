@@ -0,0 +1,214 @@
+"""End-to-end tests for hi5sync.py against the host build of the SD Gateway.
+
+Run from the repository root:
+    python3 -m unittest discover -s tools/tests
+"""
+
+import hashlib
+import os
+import sys
+import tempfile
+import time
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+
+import hi5sync  # noqa: E402
+from gateway_host import HostGateway  # noqa: E402
+
+
+def write(path, data, mtime=None):
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, "wb") as handle:
+        handle.write(data)
+    if mtime is not None:
+        os.utime(path, (mtime, mtime))
+
+
+def read(path):
+    with open(path, "rb") as handle:
+        return handle.read()
+
+
+def tree(root):
+    files = {}
+    for directory, dirs, names in os.walk(root):
+        dirs[:] = [d for d in dirs if not d.startswith(".")]
+        for name in names:
+            if name.startswith("."):
+                continue
+            full = os.path.join(directory, name)
+            files[os.path.relpath(full, root).replace(os.sep, "/")] = read(full)
+    return files
+
+
+class GatewayTestCase(unittest.TestCase):
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        self.card = os.path.join(self.tmp.name, "card")
+        os.makedirs(os.path.join(self.card, "books"))
+        self.gateway = HostGateway(self.card)
+        self.gateway.__enter__()
+        self.client = hi5sync.Gateway("127.0.0.1", self.gateway.port)
+
+    def tearDown(self):
+        self.gateway.__exit__(None, None, None)
+        self.tmp.cleanup()
+
+    def device(self, rel):
+        return os.path.join(self.card, "books", *rel.split("/"))
+
+
+class SyncTest(GatewayTestCase):
+    def setUp(self):
+        super().setUp()
+        self.local = os.path.join(self.tmp.name, "host")
+        os.makedirs(self.local)
+
+    def sync(self):
+        return hi5sync.sync(self.client, self.local, "/books", log=lambda *args: None)
+
+    def test_first_sync_uploads_everything_including_empty_files(self):
+        write(os.path.join(self.local, "a.txt"), b"alpha" * 700)
+        write(os.path.join(self.local, "empty.txt"), b"")
+        write(os.path.join(self.local, "sub", "b.txt"), b"beta")
+
+        counts = self.sync()
+
+        self.assertEqual(counts, {"upload": 3})
+        self.assertEqual(tree(os.path.join(self.card, "books")), tree(self.local))
+        self.assertEqual(self.sync(), {"keep": 3})
+
+    def test_device_changes_and_deletions_come_back(self):
+        write(os.path.join(self.local, "a.txt"), b"one")
+        write(os.path.join(self.local, "b.txt"), b"two")
+        self.sync()
+
+        write(self.device("a.txt"), b"changed on device", mtime=int(time.time()) + 5)
+        os.remove(self.device("b.txt"))
+        write(self.device("new/c.txt"), b"new on device")
+
+        counts = self.sync()
+
+        self.assertEqual(counts, {"download": 2, "delete_local": 1})
+        self.assertEqual(read(os.path.join(self.local, "a.txt")), b"changed on device")
+        self.assertFalse(os.path.exists(os.path.join(self.local, "b.txt")))
+        self.assertEqual(read(os.path.join(self.local, "new", "c.txt")), b"new on device")
+
+    def test_local_deletion_propagates(self):
+        write(os.path.join(self.local, "a.txt"), b"one")
+        self.sync()
+        os.remove(os.path.join(self.local, "a.txt"))
+
+        self.assertEqual(self.sync(), {"delete_remote": 1})
+        self.assertFalse(os.path.exists(self.device("a.txt")))
+
+    def test_conflict_keeps_losing_copy(self):
+        write(os.path.join(self.local, "a.txt"), b"base")
+        self.sync()
+        now = int(time.time())
+        write(os.path.join(self.local, "a.txt"), b"host edit", mtime=now + 10)
+        write(self.device("a.txt"), b"device edit", mtime=now)
+
+        self.assertEqual(self.sync(), {"upload": 1})
+
+        device_hash = hashlib.sha256(b"device edit").hexdigest()[:8]
+        self.assertEqual(read(self.device("a.txt")), b"host edit")
+        self.assertEqual(read(os.path.join(self.local, "a.conflict-device-%s.txt" % device_hash)), b"device edit")
+
+    def test_upload_resumes_from_received_ranges(self):
+        data = bytes(range(256)) * 20
+        write(os.path.join(self.local, "big.bin"), data)
+        session = self.client._json("POST", "/api/upload/session",
+                                    payload={"path": "/books/big.bin", "size": len(data)})
+        self.client._request("PUT", "/api/upload/chunk", {"id": session["id"], "offset": 0},
+                             data[:2000], "application/octet-stream")
+        offsets = []
+        send = self.client._request
+
+        def record(method, path, params=None, body=None, content_type=None):
+            if path == "/api/upload/chunk":
+                offsets.append((params["offset"], len(body)))
+            return send(method, path, params, body, content_type)
+
+        self.client._request = record
+        self.sync()
+
+        self.assertEqual(offsets, [(2000, len(data) - 2000)])
+        self.assertEqual(read(self.device("big.bin")), data)
+
+
+class GatewayRulesTest(GatewayTestCase):
+    def session(self, size, path="/books/f.bin"):
+        return self.client._json("POST", "/api/upload/session", payload={"path": path, "size": size})["id"]
+
+    def finalize(self, session, sha256=None):
+        params = {"id": session}
+        if sha256 is not None:
+            params["sha256"] = sha256
+        return self.client._json("POST", "/api/upload/finalize", params)
+
+    def test_missing_sha256_is_rejected(self):
+        session = self.session(0)
+        with self.assertRaisesRegex(RuntimeError, "400 .*Missing sha256"):
+            self.finalize(session)
+
+    def test_malformed_sha256_is_rejected(self):
+        session = self.session(0)
+        with self.assertRaisesRegex(RuntimeError, "400 .*64 hex digits"):
+            self.finalize(session, "z" * 64)
+
+    def test_empty_file_finalizes_without_chunks(self):
+        session = self.session(0)
+        reply = self.finalize(session, hashlib.sha256(b"").hexdigest())
+        self.assertEqual(reply["size"], 0)
+        self.assertEqual(read(self.device("f.bin")), b"")
+        self.assertFalse(os.path.exists(self.device("f.bin.part")))
+
+    def test_leading_gap_is_rejected_when_size_is_unknown(self):
+        session = self.session(0)
+        self.client._request("PUT", "/api/upload/chunk", {"id": session, "offset": 10}, b"x",
+                             "application/octet-stream")
+        with self.assertRaisesRegex(RuntimeError, "409"):
+            self.finalize(session, hashlib.sha256(b"x").hexdigest())
+
+    def test_hash_mismatch_drops_the_upload(self):
+        session = self.session(3)
+        self.client._request("PUT", "/api/upload/chunk", {"id": session, "offset": 0}, b"abc",
+                             "application/octet-stream")
+        with self.assertRaisesRegex(RuntimeError, "422"):
+            self.finalize(session, hashlib.sha256(b"abd").hexdigest())
+        self.assertFalse(os.path.exists(self.device("f.bin")))
+        self.assertFalse(os.path.exists(self.device("f.bin.part")))
+
+    def test_manifest_reuses_hashes_until_a_file_changes(self):
+        write(self.device("a.txt"), b"one")
+        write(self.device("b.txt"), b"two")
+        write(self.device(".hidden"), b"skip")
+        write(self.device("c.txt.part"), b"skip")
+
+        first = self.client._json("GET", "/api/sync/manifest", {"path": "/books"})
+        self.assertEqual(sorted(entry["path"] for entry in first["entries"]), ["a.txt", "b.txt"])
+        self.assertEqual(first["hashed"], 2)
+        self.assertEqual(self.client._json("GET", "/api/sync/manifest", {"path": "/books"})["hashed"], 0)
+
+        write(self.device("a.txt"), b"one more", mtime=int(time.time()) + 5)
+        third = self.client._json("GET", "/api/sync/manifest", {"path": "/books"})
+        self.assertEqual(third["hashed"], 1)
+        self.assertIn(hashlib.sha256(b"one more").hexdigest(), [entry["sha256"] for entry in third["entries"]])
+
+    def test_manifests_of_similar_roots_stay_separate(self):
+        write(os.path.join(self.card, "a_b", "x.txt"), b"flat")
+        write(os.path.join(self.card, "a", "b", "y.txt"), b"nested")
+
+        for _ in range(2):
+            flat = self.client._json("GET", "/api/sync/manifest", {"path": "/a_b"})
+            nested = self.client._json("GET", "/api/sync/manifest", {"path": "/a/b"})
+            self.assertEqual([entry["path"] for entry in flat["entries"]], ["x.txt"])
+            self.assertEqual([entry["path"] for entry in nested["entries"]], ["y.txt"])
+        self.assertEqual(flat["hashed"], 0)
+        self.assertEqual(nested["hashed"], 0)
+
+
+if __name__ == "__main__":
+    unittest.main()